@@ -0,0 +1,171 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "action_manager.h"
+#include "struct_walk_action_manager.h"
+
+namespace
+{
+
+const size_t channelCount = 32;
+const int tick_msec = 5;
+
+// Every rule fires every tick: toggles, a timed action and, for every other rule,
+// a guard on an output
+template <typename M>
+void setUpAllRulesFire(M& manager, size_t ruleCount, size_t actionCount)
+{
+    manager.setInputChannelCount(channelCount);
+    manager.setOutputChannelCount(channelCount);
+
+    for (size_t i = 0; i < ruleCount; ++i)
+    {
+        Rule rule;
+
+        rule.condition.inputChannelIndex = i % channelCount;
+        rule.condition.eventType = EventType::rise;
+
+        for (size_t a = 0; a < actionCount; ++a)
+        {
+            RuleAction action;
+
+            action.outputChannelIndex = (i * 7 + a) % channelCount;
+            action.actionType = (a == 1) ? ActionType::onFor : ActionType::toggle;
+            action.duration_msec = 1000;
+
+            rule.actions.push_back(action);
+        }
+
+        if (i % 2 != 0)
+        {
+            RuleGuard guard;
+
+            guard.source = GuardSource::output;
+            guard.channelIndex = (i * 3) % channelCount;
+            guard.state = DiscreteState::off;
+
+            rule.guards.push_back(guard);
+        }
+
+        manager.addRule(rule);
+    }
+}
+
+template <typename M>
+void runAllRulesFireTick(M& manager)
+{
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        manager.setInputEvent(i, EventType::rise);
+    }
+
+    manager.advanceTime(tick_msec);
+    manager.execute();
+}
+
+template <typename M>
+void runAllRulesFire(benchmark::State& state)
+{
+    const auto ruleCount = static_cast<size_t>(state.range(0));
+    const auto actionCount = static_cast<size_t>(state.range(1));
+
+    M manager;
+    setUpAllRulesFire(manager, ruleCount, actionCount);
+
+    for (auto _ : state)
+    {
+        runAllRulesFireTick(manager);
+    }
+
+    state.SetItemsProcessed(state.iterations() * ruleCount);
+}
+
+} // namespace
+
+// Rule evaluation of a tick in which every input has an event
+static void BM_ActionManager_AllRulesFire(benchmark::State& state)
+{
+    runAllRulesFire<ActionManager>(state);
+}
+BENCHMARK(BM_ActionManager_AllRulesFire)
+    ->ArgNames({ "rules", "actions" })
+    ->Args({ 32, 1 })
+    ->Args({ 32, 4 })
+    ->Args({ 128, 1 })
+    ->Args({ 128, 4 });
+
+// The same ticks through the struct walk
+static void BM_ActionManager_AllRulesFire_StructWalk(benchmark::State& state)
+{
+    runAllRulesFire<StructWalkActionManager>(state);
+}
+BENCHMARK(BM_ActionManager_AllRulesFire_StructWalk)
+    ->ArgNames({ "rules", "actions" })
+    ->Args({ 32, 1 })
+    ->Args({ 32, 4 })
+    ->Args({ 128, 1 })
+    ->Args({ 128, 4 });
+
+// A scene over every output of a large board: one toggle per output or one group_toggle
+static void BM_ActionManager_Scene(benchmark::State& state)
+{
+    const size_t outputCount = ActionManager::maxOutputChannelCount;
+    const auto isGroup = state.range(0) != 0;
+
+    ActionManager manager;
+
+    manager.setInputChannelCount(1);
+    manager.setOutputChannelCount(outputCount);
+
+    uint32_t mask[ActionManager::maxOutputWordCount];
+    for (auto& word : mask)
+    {
+        word = UINT32_MAX;
+    }
+
+    manager.addOutputGroup(mask, ActionManager::maxOutputWordCount);
+
+    Rule rule;
+
+    rule.condition.inputChannelIndex = 0;
+    rule.condition.eventType = EventType::rise;
+
+    if (isGroup)
+    {
+        RuleAction action;
+
+        action.outputChannelIndex = 0;
+        action.actionType = ActionType::groupToggle;
+
+        rule.actions.push_back(action);
+    }
+    else
+    {
+        for (size_t i = 0; i < outputCount; ++i)
+        {
+            RuleAction action;
+
+            action.outputChannelIndex = i;
+            action.actionType = ActionType::toggle;
+
+            rule.actions.push_back(action);
+        }
+    }
+
+    manager.addRule(rule);
+
+    for (auto _ : state)
+    {
+        manager.setInputEvent(0, EventType::rise);
+        manager.advanceTime(5);
+        manager.execute();
+    }
+
+    state.SetItemsProcessed(state.iterations() * outputCount);
+}
+BENCHMARK(BM_ActionManager_Scene)
+    ->ArgNames({ "group" })
+    ->Arg(0)
+    ->Arg(1);
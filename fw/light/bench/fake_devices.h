@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <vector>
+
+#include "types.h"
+
+// Host stand-ins for the I2C expander devices and the SPIFFS rules reader.
+
+class FakeInputDevice : public IInputDevice
+{
+public:
+    void setChannelCount(size_t value)
+    {
+        _channelCount = value;
+
+        _onWords.assign((value + 31) / 32, 0);
+        _validWords.assign(_onWords.size(), 0);
+
+        for (size_t i = 0; i < value; ++i)
+        {
+            setValue(i, DiscreteState::off);
+        }
+    }
+
+    size_t getChannelCount() const { return _channelCount; }
+
+    void setValue(size_t channelIndex, DiscreteState value)
+    {
+        const auto w = channelIndex / 32;
+        const auto mask = static_cast<uint32_t>(1) << (channelIndex % 32);
+
+        _onWords[w] = (value == DiscreteState::on) ? (_onWords[w] | mask) : (_onWords[w] & ~mask);
+        _validWords[w] = (value != DiscreteState::unknown) ? (_validWords[w] | mask) : (_validWords[w] & ~mask);
+    }
+
+    // Whole frame at once, the word layout of readAll()
+    void setFrame(const std::vector<uint32_t>& onWords, const std::vector<uint32_t>& validWords)
+    {
+        for (size_t w = 0; w < _onWords.size(); ++w)
+        {
+            _onWords[w] = (w < onWords.size()) ? onWords[w] : 0;
+            _validWords[w] = (w < validWords.size()) ? validWords[w] : 0;
+        }
+    }
+
+    bool getCurrentValue(size_t channelIndex, DiscreteState& curValue_out) const override
+    {
+        if (channelIndex >= _channelCount)
+        {
+            return false;
+        }
+
+        const auto w = channelIndex / 32;
+        const auto mask = static_cast<uint32_t>(1) << (channelIndex % 32);
+
+        if ((_validWords[w] & mask) == 0)
+        {
+            curValue_out = DiscreteState::unknown;
+        }
+        else
+        {
+            curValue_out = ((_onWords[w] & mask) != 0) ? DiscreteState::on : DiscreteState::off;
+        }
+
+        return true;
+    }
+
+    void readAll(uint32_t* onMask_out, uint32_t* validMask_out, size_t wordCount) const override
+    {
+        for (size_t w = 0; w < wordCount; ++w)
+        {
+            const auto isPresent = w < _onWords.size();
+
+            onMask_out[w] = isPresent ? _onWords[w] : 0;
+            validMask_out[w] = isPresent ? _validWords[w] : 0;
+        }
+    }
+
+    // Timestamped raw changes takeEdges() returns until the next call
+    void setEdges(const std::vector<InputEdge>& value)
+    {
+        _edges = value;
+        _takenEdgeCount = 0;
+    }
+
+    size_t takeEdges(InputEdge* edges_out, size_t maxCount) override
+    {
+        size_t count = 0;
+
+        while ((count < maxCount) && (_takenEdgeCount < _edges.size()))
+        {
+            edges_out[count++] = _edges[_takenEdgeCount++];
+        }
+
+        return count;
+    }
+
+private:
+    size_t _channelCount = 0;
+
+    std::vector<InputEdge> _edges;
+    size_t _takenEdgeCount = 0;
+
+    // Bit per channel, as readAll() returns them
+    std::vector<uint32_t> _onWords;
+    std::vector<uint32_t> _validWords;
+};
+
+class FakeOutputDevice : public IOutputDevice
+{
+public:
+    void setChannelCount(size_t value) { _values.assign(value, DiscreteState::unknown); }
+    size_t getChannelCount() const { return _values.size(); }
+
+    DiscreteState getValue(size_t channelIndex) const { return _values[channelIndex]; }
+
+    void setCurrentValue(size_t channelIndex, DiscreteState value) override
+    {
+        if (channelIndex < _values.size())
+        {
+            _values[channelIndex] = value;
+        }
+    }
+
+private:
+    std::vector<DiscreteState> _values;
+};
+
+class FakeRulesReader : public IRulesReader
+{
+public:
+    void addRule(const Rule& rule) { _rules.push_back(rule); }
+    void clear() { _rules.clear(); _position = 0; }
+
+    ReadResult readRule(Rule& result_out) override
+    {
+        if (_position >= _rules.size())
+        {
+            return ReadResult::noData;
+        }
+
+        result_out = _rules[_position++];
+        return ReadResult::success;
+    }
+
+    bool hasMoreRules() const override { return _position < _rules.size(); }
+
+    bool reset() override
+    {
+        _position = 0;
+        return true;
+    }
+
+private:
+    std::vector<Rule> _rules;
+    size_t _position = 0;
+};
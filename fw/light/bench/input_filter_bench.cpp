@@ -0,0 +1,80 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "input_filter_ac.h"
+#include "input_filter_bank.h"
+
+namespace
+{
+
+const int tickPeriod_msec = 5;
+
+// Raw state of a channel on a tick: half of the channels see AC, the others are idle.
+bool isRawOn(size_t channelIndex, size_t tick)
+{
+    return (channelIndex % 2 == 0) && (tick % 2 == 0);
+}
+
+} // namespace
+
+// One filter object per channel, updated through the interface.
+static void BM_InputFilters_PerChannel(benchmark::State& state)
+{
+    const auto channelCount = static_cast<size_t>(state.range(0));
+
+    std::vector<std::unique_ptr<IInputFilter>> filters;
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        filters.push_back(std::unique_ptr<IInputFilter>(new InputFilterAc()));
+    }
+
+    size_t tick = 0;
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            filters[i]->update(isRawOn(i, tick) ? DiscreteState::on : DiscreteState::off, tickPeriod_msec);
+            benchmark::DoNotOptimize(filters[i]->resultingState());
+        }
+
+        ++tick;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InputFilters_PerChannel)->ArgName("channels")->Arg(16)->Arg(64)->Arg(128);
+
+// All channels in the bank, updated from packed words.
+static void BM_InputFilters_Bank(benchmark::State& state)
+{
+    const auto channelCount = static_cast<size_t>(state.range(0));
+
+    std::unique_ptr<InputFilterBank> bank(new InputFilterBank());
+    bank->setChannelCount(channelCount);
+
+    InputFilterBank::Word onWords[2][InputFilterBank::maxWordCount] = {};
+    InputFilterBank::Word knownWords[InputFilterBank::maxWordCount] = {};
+
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        BitUtils::assign(onWords[0], i, isRawOn(i, 0));
+        BitUtils::assign(knownWords, i, true);
+    }
+
+    size_t tick = 0;
+    for (auto _ : state)
+    {
+        bank->update(onWords[tick % 2], knownWords, tickPeriod_msec);
+        benchmark::DoNotOptimize(bank->getChangedWord(0));
+
+        ++tick;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_InputFilters_Bank)->ArgName("channels")->Arg(16)->Arg(64)->Arg(128);
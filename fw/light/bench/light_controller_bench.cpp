@@ -0,0 +1,131 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <memory>
+
+#include <benchmark/benchmark.h>
+
+#include "light_controller.h"
+
+#include "fake_devices.h"
+
+namespace
+{
+
+const int tickPeriod_msec = 5;
+
+// Ticks a switch stays pressed or released in the busy scenario,
+// long enough for the AC filter to settle on each state.
+const size_t pressTicks = 40;
+
+class BenchRig
+{
+public:
+    BenchRig(size_t channelCount, size_t ruleCount)
+    {
+        _inputDevice.setChannelCount(channelCount);
+        _outputDevice.setChannelCount(channelCount);
+
+        for (size_t i = 0; i < ruleCount; ++i)
+        {
+            Rule rule;
+
+            rule.condition.inputChannelIndex = i % channelCount;
+            rule.condition.eventType = (i % 2 == 0) ? EventType::rise : EventType::fall;
+
+            RuleAction action;
+
+            action.outputChannelIndex = (i * 7) % channelCount;
+            action.actionType = ActionType::toggle;
+            action.duration_msec = 0;
+
+            rule.actions.push_back(action);
+
+            _rulesReader.addRule(rule);
+        }
+
+        _controller.setInputCount(channelCount);
+        _controller.setOutputCount(channelCount);
+
+        _controller.setInputDevice(&_inputDevice);
+        _controller.setOutputDevice(&_outputDevice);
+        _controller.setRulesReader(&_rulesReader);
+
+        _controller.initialize();
+    }
+
+    // Feeds every channel a 100 Hz square wave (what the optocoupler
+    // produces from 50 Hz mains) while its switch is pressed, staggering
+    // the channels so that some of them change state on most ticks.
+    void stimulate()
+    {
+        const auto channelCount = _inputDevice.getChannelCount();
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            const auto pressed = ((_tick + i * 3) / pressTicks) % 2 == 0;
+            const auto high = pressed && (_tick % 2 == 0);
+
+            _inputDevice.setValue(i, high ? DiscreteState::on : DiscreteState::off);
+        }
+
+        ++_tick;
+    }
+
+    void execute() { _controller.execute(tickPeriod_msec); }
+
+private:
+    FakeInputDevice _inputDevice;
+    FakeOutputDevice _outputDevice;
+    FakeRulesReader _rulesReader;
+
+    LightController _controller;
+
+    size_t _tick = 0;
+};
+
+void channelAndRuleArgs(benchmark::internal::Benchmark* bench)
+{
+    bench->ArgNames({ "channels", "rules" });
+
+    for (const auto channels : { 16, 64, 128 })
+    {
+        for (const auto rules : { 8, 128 })
+        {
+            bench->Args({ channels, rules });
+        }
+    }
+}
+
+} // namespace
+
+// All inputs are released: the common case in the field.
+static void BM_LightController_IdleTick(benchmark::State& state)
+{
+    std::unique_ptr<BenchRig> rig(new BenchRig(state.range(0), state.range(1)));
+
+    for (auto _ : state)
+    {
+        rig->execute();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LightController_IdleTick)->Apply(channelAndRuleArgs);
+
+// Every input is pressed and released periodically.
+static void BM_LightController_BusyTick(benchmark::State& state)
+{
+    std::unique_ptr<BenchRig> rig(new BenchRig(state.range(0), state.range(1)));
+
+    for (auto _ : state)
+    {
+        rig->stimulate();
+        rig->execute();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_LightController_BusyTick)->Apply(channelAndRuleArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,369 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <algorithm>
+#include <vector>
+
+#include "action_manager.h"
+#include "bit_utils.h"
+#include "rule_table.h"
+#include "timer_wheel.h"
+
+// The rule path the bytecode replaced, the reference the interpreter is timed and tested
+// against: the rules stay structs that every matched rule walks through an if-chain.
+// Of execute() only the timers, the rules and the change and event resets are here,
+// there are no forced states. The index of the rules is the one of RuleTable
+class StructWalkActionManager
+{
+public:
+    StructWalkActionManager()
+    {
+        clearWords(_inputOn);
+        clearWords(_inputOff);
+
+        clearWords(_outputsOn);
+        clearWords(_outputsKnown);
+        clearWords(_changedOutputs);
+
+        for (auto& words : _pendingEvents)
+        {
+            clearWords(words);
+        }
+    }
+
+    void setInputChannelCount(size_t value) { _inputChannelCount = value; }
+
+    void setOutputChannelCount(size_t value)
+    {
+        _outputChannelCount = value;
+        _timers.setCapacity(value);
+    }
+
+    void addOutputGroup(const uint32_t* mask, size_t wordCount)
+    {
+        std::vector<BitUtils::Word> group(_maxWordCount, 0);
+
+        for (size_t w = 0; (w < wordCount) && (w < _maxWordCount); ++w)
+        {
+            group[w] = mask[w];
+        }
+
+        _outputGroups.push_back(group);
+    }
+
+    void addRule(const Rule& rule)
+    {
+        if (_table.addRule(rule) == ActionManagerError::none)
+        {
+            _rules.push_back(rule);
+        }
+    }
+
+    void setInputEvent(size_t inputChannelIndex, EventType event)
+    {
+        size_t slot;
+        if ((inputChannelIndex < _inputChannelCount) && RuleTable::getEventSlot(event, slot))
+        {
+            BitUtils::assign(_pendingEvents[slot], inputChannelIndex, true);
+        }
+    }
+
+    void setInputState(size_t inputChannelIndex, DiscreteState value)
+    {
+        if (inputChannelIndex < _inputChannelCount)
+        {
+            BitUtils::assign(_inputOn, inputChannelIndex, value == DiscreteState::on);
+            BitUtils::assign(_inputOff, inputChannelIndex, value == DiscreteState::off);
+        }
+    }
+
+    void advanceTime(int elapsed_msec) { _elapsed_msec += static_cast<uint32_t>(elapsed_msec); }
+
+    void execute()
+    {
+        clearWords(_changedOutputs);
+
+        _timers.advance(_elapsed_msec,
+            [this](size_t outputChannelIndex)
+            {
+                setOutputState(outputChannelIndex, DiscreteState::off);
+            });
+
+        _elapsed_msec = 0;
+
+        applyRules();
+
+        for (auto& words : _pendingEvents)
+        {
+            clearWords(words);
+        }
+    }
+
+    size_t getPendingTimerCount() const { return _timers.getPendingCount(); }
+
+    DiscreteState getOutputState(size_t outputChannelIndex) const
+    {
+        if (!BitUtils::isSet(_outputsKnown, outputChannelIndex))
+        {
+            return DiscreteState::unknown;
+        }
+
+        return BitUtils::isSet(_outputsOn, outputChannelIndex) ? DiscreteState::on : DiscreteState::off;
+    }
+
+    BitUtils::Word getChangedOutputWord(size_t wordIndex) const { return _changedOutputs[wordIndex]; }
+
+private:
+    static const size_t _maxWordCount = ActionManager::maxOutputWordCount;
+
+    static void clearWords(BitUtils::Word* words)
+    {
+        for (size_t w = 0; w < _maxWordCount; ++w)
+        {
+            words[w] = 0;
+        }
+    }
+
+    void applyRules()
+    {
+        if (!_table.isIndexBuilt(_inputChannelCount))
+        {
+            _table.buildIndex(_inputChannelCount);
+        }
+
+        size_t matchedCount = 0;
+        size_t matchedSpanCount = 0;
+
+        for (size_t slot = 0; slot < RuleTable::eventSlotCount; ++slot)
+        {
+            for (size_t w = 0; w < BitUtils::wordCount(_inputChannelCount); ++w)
+            {
+                auto pending = _pendingEvents[slot][w];
+
+                while (pending != 0)
+                {
+                    const auto channelIndex = w * BitUtils::bitsPerWord + BitUtils::lowestSetBit(pending);
+                    pending = BitUtils::clearLowestSetBit(pending);
+
+                    size_t ruleCount;
+                    const auto rules_p = _table.getKeyRules(RuleTable::getKey(channelIndex, slot), ruleCount);
+
+                    if (ruleCount == 0)
+                    {
+                        continue;
+                    }
+
+                    for (size_t i = 0; i < ruleCount; ++i)
+                    {
+                        _matchedRules[matchedCount++] = rules_p[i];
+                    }
+
+                    ++matchedSpanCount;
+                }
+            }
+        }
+
+        if (matchedSpanCount > 1)
+        {
+            std::sort(_matchedRules, _matchedRules + matchedCount);
+        }
+
+        for (size_t i = 0; i < matchedCount; ++i)
+        {
+            const auto& rule = _rules[_matchedRules[i]];
+
+            // Guards see the outputs as the rules before this one left them
+            if (!checkRuleGuards(rule))
+            {
+                continue;
+            }
+
+            for (const auto& action : rule.actions)
+            {
+                executeRuleAction(action);
+            }
+        }
+    }
+
+    bool checkRuleGuards(const Rule& rule) const
+    {
+        for (const auto& guard : rule.guards)
+        {
+            if (guard.source == GuardSource::output)
+            {
+                if ((guard.channelIndex >= _outputChannelCount) || (getOutputState(guard.channelIndex) != guard.state))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                if (guard.channelIndex >= _inputChannelCount)
+                {
+                    return false;
+                }
+
+                const auto words_p = (guard.state == DiscreteState::on) ? _inputOn : _inputOff;
+                if (!BitUtils::isSet(words_p, guard.channelIndex))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void executeRuleAction(const RuleAction& action)
+    {
+        switch (action.actionType)
+        {
+            case ActionType::none:
+                return;
+
+            case ActionType::localOff:
+            case ActionType::globalOff:
+                setAllOff();
+                return;
+
+            case ActionType::groupOn:
+            case ActionType::groupOff:
+            case ActionType::groupToggle:
+                executeGroupAction(action);
+                return;
+
+            default:
+                break;
+        }
+
+        const auto channelIndex = action.outputChannelIndex;
+        if (channelIndex >= _outputChannelCount)
+        {
+            return;
+        }
+
+        auto state = getOutputState(channelIndex);
+
+        if (action.actionType == ActionType::onFor)
+        {
+            state = DiscreteState::on;
+            _timers.start(channelIndex, action.duration_msec);
+        }
+        else if (action.actionType == ActionType::offAfter)
+        {
+            _timers.start(channelIndex, action.duration_msec);
+        }
+        else if (action.actionType == ActionType::pulse)
+        {
+            if (_timers.isPending(channelIndex))
+            {
+                return;
+            }
+
+            state = DiscreteState::on;
+            _timers.start(channelIndex, action.duration_msec);
+        }
+        else
+        {
+            _timers.cancel(channelIndex);
+        }
+
+        if (action.actionType == ActionType::turnOn)
+        {
+            state = DiscreteState::on;
+        }
+        else if (action.actionType == ActionType::turnOff)
+        {
+            state = DiscreteState::off;
+        }
+        else if (action.actionType == ActionType::toggle)
+        {
+            // Unknown turns off
+            state = (state == DiscreteState::off) ? DiscreteState::on : DiscreteState::off;
+        }
+
+        setOutputState(channelIndex, state);
+    }
+
+    // Off if any output of the group is on for groupToggle
+    void executeGroupAction(const RuleAction& action)
+    {
+        if (action.outputChannelIndex >= _outputGroups.size())
+        {
+            return;
+        }
+
+        const auto& group = _outputGroups[action.outputChannelIndex];
+
+        auto state = (action.actionType == ActionType::groupOff) ? DiscreteState::off : DiscreteState::on;
+
+        for (size_t i = 0; i < _outputChannelCount; ++i)
+        {
+            if ((action.actionType == ActionType::groupToggle) && BitUtils::isSet(group.data(), i) && (getOutputState(i) == DiscreteState::on))
+            {
+                state = DiscreteState::off;
+            }
+        }
+
+        for (size_t i = 0; i < _outputChannelCount; ++i)
+        {
+            if (BitUtils::isSet(group.data(), i))
+            {
+                _timers.cancel(i);
+                setOutputState(i, state);
+            }
+        }
+    }
+
+    void setAllOff()
+    {
+        _timers.cancelAll();
+
+        for (size_t i = 0; i < _outputChannelCount; ++i)
+        {
+            setOutputState(i, DiscreteState::off);
+        }
+    }
+
+    void setOutputState(size_t outputChannelIndex, DiscreteState state)
+    {
+        if (state == DiscreteState::unknown)
+        {
+            return;
+        }
+
+        const auto w = BitUtils::wordIndex(outputChannelIndex);
+        const auto mask = BitUtils::bitMask(outputChannelIndex);
+
+        const auto on = (state == DiscreteState::on) ? mask : 0;
+        const auto changed = ((_outputsOn[w] & mask) ^ on) | (~_outputsKnown[w] & mask);
+
+        _outputsOn[w] = (_outputsOn[w] & ~mask) | on;
+        _outputsKnown[w] |= mask;
+        _changedOutputs[w] |= changed;
+    }
+
+    size_t _inputChannelCount = 0;
+    size_t _outputChannelCount = 0;
+
+    BitUtils::Word _pendingEvents[RuleTable::eventSlotCount][_maxWordCount];
+
+    BitUtils::Word _inputOn[_maxWordCount];
+    BitUtils::Word _inputOff[_maxWordCount];
+
+    BitUtils::Word _outputsOn[_maxWordCount];
+    BitUtils::Word _outputsKnown[_maxWordCount];
+    BitUtils::Word _changedOutputs[_maxWordCount];
+
+    TimerWheel _timers;
+    uint32_t _elapsed_msec = 0;
+
+    std::vector<std::vector<BitUtils::Word>> _outputGroups;
+
+    RuleTable _table;
+    std::vector<Rule> _rules;
+    RuleTable::RuleNumber _matchedRules[RuleTable::maxRuleCount];
+};
@@ -0,0 +1,73 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <benchmark/benchmark.h>
+
+#include "timer_wheel.h"
+
+namespace
+{
+
+const int tickPeriod_msec = 5;
+
+// Delays spread over a minute, like staircase timers of many outputs
+uint32_t getDelay_msec(size_t timerIndex)
+{
+    return static_cast<uint32_t>((timerIndex * 7919) % 60000) + 1000;
+}
+
+} // namespace
+
+// A tick with every timer pending, each restarted as soon as it runs out.
+static void BM_TimerWheel_Tick(benchmark::State& state)
+{
+    const auto timerCount = static_cast<size_t>(state.range(0));
+
+    TimerWheel wheel;
+    wheel.setCapacity(timerCount);
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        wheel.start(i, getDelay_msec(i));
+    }
+
+    size_t expiredCount = 0;
+
+    for (auto _ : state)
+    {
+        wheel.advance(tickPeriod_msec,
+            [&wheel, &expiredCount](size_t timerIndex)
+            {
+                wheel.start(timerIndex, getDelay_msec(timerIndex));
+                ++expiredCount;
+            });
+    }
+
+    benchmark::DoNotOptimize(expiredCount);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheel_Tick)->ArgName("timers")->Arg(128)->Arg(1024)->Arg(8192)->Arg(65534);
+
+// Restarting a pending timer, what a retriggered on_for does.
+static void BM_TimerWheel_Restart(benchmark::State& state)
+{
+    const size_t timerCount = 1024;
+
+    TimerWheel wheel;
+    wheel.setCapacity(timerCount);
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        wheel.start(i, getDelay_msec(i));
+    }
+
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        wheel.start(i, getDelay_msec(i + 1));
+        i = (i + 1) % timerCount;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TimerWheel_Restart);
@@ -613,6 +613,7 @@ boolean FtpServer::processCommand()
         millisBeginTrans = millis();
         bytesTransfered = 0;
         transferStatus = 2;
+        _storePath = path;
       }
     }
   }
@@ -674,7 +675,11 @@ boolean FtpServer::processCommand()
 		  Serial.println("Renaming " + String(buf) + " to " + String(path));
             #endif
 	      if (_fileSystem_p->rename(buf, path))
+	      {
               client.println( "250 File successfully renamed or moved");
+              if (_fileWritten)
+                _fileWritten(String(path));
+	      }
             else
 				client.println( "451 Rename/move failure");
                                  
@@ -804,6 +809,8 @@ boolean FtpServer::doStore()
   if( !data.connected() && (navail <= 0) )
   {
     closeTransfer();
+    if (_fileWritten)
+      _fileWritten(_storePath);
     return false;
   }
   else
@@ -32,6 +32,8 @@
 #define FTP_SERVERESP_H
 
 //#include "Streaming.h"
+#include <functional>
+
 #include <FS.h>
 #include <WiFiClient.h>
 
@@ -52,6 +54,9 @@ class FtpServer
 public:
 	void setFileSystem(FS* value_p) { _fileSystem_p = value_p; }
 	
+	// Called with the full path once a file is uploaded or renamed to
+	void setFileWrittenCallback(std::function<void(const String& path)> value) { _fileWritten = value; }
+	
   void    begin(String uname, String pword);
   void    handleFTP();
 
@@ -99,7 +104,9 @@ private:
   String   _FTP_USER;
   String   _FTP_PASS;
 
-	FS* _fileSystem_p = nullptr;  
+	FS* _fileSystem_p = nullptr;
+	String _storePath;
+	std::function<void(const String& path)> _fileWritten;  
 
 };
 
@@ -1,48 +1,144 @@
+#include <algorithm>
+
 #include "action_manager.h"
 
 ActionManager::ActionManager() :
     IActionManager(),
-    IActionManagerConfigurator()
+    IActionManagerConfigurator(),
+    _activeRuleTable_p(&_ruleTables[0]),
+    _pendingRuleTable_p(nullptr)
 {
     _inLocalOff = false; 
     _inGlobalOff = false;
 
     _outLocalOff = false;
     _outGlobalOff = false;
+
+    for (auto& words : _pendingEvents)
+    {
+        for (auto& word : words)
+        {
+            word = 0;
+        }
+    }
+
+    for (size_t w = 0; w < maxOutputWordCount; ++w)
+    {
+        _changedOutputs[w] = 0;
+        _outputsOn[w] = 0;
+        _outputsKnown[w] = 0;
+        _forcedOutputs[w] = 0;
+        _forcedOutputsOn[w] = 0;
+    }
+
+    for (size_t w = 0; w < _maxInputWordCount; ++w)
+    {
+        _inputOn[w] = 0;
+        _inputOff[w] = 0;
+    }
 }
 
 ActionManagerError ActionManager::setInputEvent(size_t inputChannelIndex, EventType event)
 {
-    if (inputChannelIndex >= _curInputEvents.size())
+    if (inputChannelIndex >= _inputChannelCount)
+    {
+        return ActionManagerError::invalidChannelIndex;
+    }
+
+    // none clears the events of the channel
+    if (event == EventType::none)
+    {
+        for (auto& words : _pendingEvents)
+        {
+            BitUtils::assign(words, inputChannelIndex, false);
+        }
+
+        return ActionManagerError::none;
+    }
+
+    size_t slot;
+    if (RuleTable::getEventSlot(event, slot))
+    {
+        BitUtils::assign(_pendingEvents[slot], inputChannelIndex, true);
+        _hasPendingEvents = true;
+    }
+
+    return ActionManagerError::none;
+}
+
+ActionManagerError ActionManager::setInputState(size_t inputChannelIndex, DiscreteState value)
+{
+    if (inputChannelIndex >= _inputChannelCount)
     {
         return ActionManagerError::invalidChannelIndex;
     }
 
-    _curInputEvents[inputChannelIndex] = event;
+    BitUtils::assign(_inputOn, inputChannelIndex, value == DiscreteState::on);
+    BitUtils::assign(_inputOff, inputChannelIndex, value == DiscreteState::off);
 
     return ActionManagerError::none;
 }
 
 ActionManagerError ActionManager::getOutputState(size_t outputChannelIndex, DiscreteState& outputState_out)
 {
-    if (outputChannelIndex >= _curOutputStates.size())
+    if (outputChannelIndex >= _outputChannelCount)
     {
         return ActionManagerError::invalidChannelIndex;
     }
 
-    outputState_out = _curOutputStates[outputChannelIndex];
+    if (!BitUtils::isSet(_outputsKnown, outputChannelIndex))
+    {
+        outputState_out = DiscreteState::unknown;
+    }
+    else
+    {
+        outputState_out = BitUtils::isSet(_outputsOn, outputChannelIndex) ? DiscreteState::on : DiscreteState::off;
+    }
 
     return ActionManagerError::none;
 }
 
+// unknown takes the force back
 ActionManagerError ActionManager::forceOutput(size_t outputChannelIndex, DiscreteState state)
 {
-    if (outputChannelIndex >= _curForcedOutputStates.size())
+    if (outputChannelIndex >= _outputChannelCount)
     {
         return ActionManagerError::invalidChannelIndex;
     }
 
-    _curForcedOutputStates[outputChannelIndex] = state;
+    const auto isForced = state != DiscreteState::unknown;
+
+    BitUtils::assign(_forcedOutputs, outputChannelIndex, isForced);
+    BitUtils::assign(_forcedOutputsOn, outputChannelIndex, state == DiscreteState::on);
+    _hasForcedOutputs |= isForced;
+
+    if (isForced)
+    {
+        _timers.cancel(outputChannelIndex);
+    }
+
+    return ActionManagerError::none;
+}
+
+ActionManagerError ActionManager::forceOutputGroup(size_t groupIndex, DiscreteState state)
+{
+    if ((groupIndex >= _outputGroupCount) || (state == DiscreteState::unknown))
+    {
+        return ActionManagerError::invalidChannelIndex;
+    }
+
+    const auto mask_p = getOutputGroupMask(groupIndex);
+    const auto on = (state == DiscreteState::on) ? ~static_cast<BitUtils::Word>(0) : 0;
+
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
+    {
+        _forcedOutputs[w] |= mask_p[w];
+        _forcedOutputsOn[w] = (_forcedOutputsOn[w] & ~mask_p[w]) | (on & mask_p[w]);
+
+        cancelTimers(w, mask_p[w]);
+    }
+
+    _hasForcedOutputs = true;
 
     return ActionManagerError::none;
 }
@@ -73,20 +169,35 @@ ActionManagerError ActionManager::isGlobalOff(bool& result_out)
 
 ActionManagerError ActionManager::addRule(const Rule& rule)
 {
-    if (_rules.size() >= _maxRuleCount)
-    {
-        return ActionManagerError::tooManyRules;
-    }
+    const auto result = _activeRuleTable_p.load(std::memory_order_relaxed)->addRule(rule);
+    return result;
+}
 
-    _rules.push_back(rule);
+// A published table that is not taken yet is dropped too
+ActionManagerError ActionManager::clearRules()
+{
+    _pendingRuleTable_p.store(nullptr, std::memory_order_release);
+    _activeRuleTable_p.load(std::memory_order_relaxed)->clear();
 
     return ActionManagerError::none;
 }
 
-ActionManagerError ActionManager::clearRules()
+RuleTable* ActionManager::getSpareRuleTable()
 {
-    _rules.clear();
-    return ActionManagerError::none;
+    if (_pendingRuleTable_p.load(std::memory_order_acquire) != nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto active_p = _activeRuleTable_p.load(std::memory_order_acquire);
+    return (active_p == &_ruleTables[0]) ? &_ruleTables[1] : &_ruleTables[0];
+}
+
+// The index is built here, off the control path
+void ActionManager::publishRuleTable(RuleTable* table_p)
+{
+    table_p->buildIndex(_inputChannelCount);
+    _pendingRuleTable_p.store(table_p, std::memory_order_release);
 }
 
 ActionManagerError ActionManager::setInputChannelCount(size_t value)
@@ -96,7 +207,7 @@ ActionManagerError ActionManager::setInputChannelCount(size_t value)
         return ActionManagerError::tooManyChannels;
     }
 
-    _curInputEvents.resize(value);
+    _inputChannelCount = value;
     resetInputEvents();
 
     return ActionManagerError::none;
@@ -104,24 +215,72 @@ ActionManagerError ActionManager::setInputChannelCount(size_t value)
 
 ActionManagerError ActionManager::setOutputChannelCount(size_t value)
 {
-    if (value > _maxOutputChannelCount)
+    if (value > maxOutputChannelCount)
     {
         return ActionManagerError::tooManyChannels;
     }
 
-    _curOutputStates.resize(value);
-    _curForcedOutputStates.resize(value);
+    _outputChannelCount = value;
+    _timers.setCapacity(value);
+
+    // Outputs beyond the count never change
+    for (size_t w = 0; w < maxOutputWordCount; ++w)
+    {
+        const auto valid = BitUtils::validMask(value, w);
+
+        _outputsOn[w] &= valid;
+        _outputsKnown[w] &= valid;
+    }
 
     resetInputForcedStates();
+    resetChangedOutputs();
+
+    return ActionManagerError::none;
+}
+
+ActionManagerError ActionManager::addOutputGroup(const uint32_t* mask, size_t wordCount)
+{
+    if (_outputGroupCount >= _maxOutputGroupCount)
+    {
+        return ActionManagerError::tooManyGroups;
+    }
+
+    // Outputs beyond the count are dropped when the group is applied
+    for (size_t w = 0; w < maxOutputWordCount; ++w)
+    {
+        _outputGroupMasks.push_back((w < wordCount) ? mask[w] : 0);
+    }
+
+    ++_outputGroupCount;
+
+    return ActionManagerError::none;
+}
+
+ActionManagerError ActionManager::clearOutputGroups()
+{
+    _outputGroupMasks.clear();
+    _outputGroupCount = 0;
 
     return ActionManagerError::none;
 }
 
 ActionManagerError ActionManager::execute()
 {
+    // Rules published since the last tick
+    const auto pending_p = _pendingRuleTable_p.load(std::memory_order_acquire);
+    if (pending_p != nullptr)
+    {
+        _activeRuleTable_p.store(pending_p, std::memory_order_release);
+        _pendingRuleTable_p.store(nullptr, std::memory_order_release);
+    }
+
     _outLocalOff = false;
     _outGlobalOff = false;
 
+    resetChangedOutputs();
+
+    // Timers that ran out before the events of the tick, so an event may restart them
+    applyTimers();
     applyRules();
     applyForcedStates();
 
@@ -141,105 +300,313 @@ ActionManagerError ActionManager::execute()
     return ActionManagerError::none;
 }
 
+void ActionManager::applyTimers()
+{
+    _timers.advance(_elapsed_msec,
+        [this](size_t outputChannelIndex)
+        {
+            setOutputState(outputChannelIndex, DiscreteState::off);
+        });
+
+    _elapsed_msec = 0;
+}
+
 void ActionManager::applyRules()
 {
-    for (const auto& rule : _rules)
+    auto& table = *_activeRuleTable_p.load(std::memory_order_relaxed);
+
+    // Rules added with addRule()
+    if (!table.isIndexBuilt(_inputChannelCount))
     {
-        if (isRuleConditionMatches(rule.condition))
+        table.buildIndex(_inputChannelCount);
+    }
+
+    if (!_hasPendingEvents)
+    {
+        return;
+    }
+
+    size_t matchedCount = 0;
+    size_t matchedSpanCount = 0;
+
+    const auto wordCount = BitUtils::wordCount(_inputChannelCount);
+
+    for (size_t slot = 0; slot < _eventSlotCount; ++slot)
+    {
+        for (size_t w = 0; w < wordCount; ++w)
         {
-            if (!executeRuleAction(rule.action))
+            auto pending = _pendingEvents[slot][w];
+
+            while (pending != 0)
             {
-                //TODO: report error
+                const auto channelIndex = w * BitUtils::bitsPerWord + BitUtils::lowestSetBit(pending);
+                pending = BitUtils::clearLowestSetBit(pending);
+
+                size_t ruleCount;
+                const auto rules_p = table.getKeyRules(RuleTable::getKey(channelIndex, slot), ruleCount);
+
+                if (ruleCount == 0)
+                {
+                    continue;
+                }
+
+                for (size_t i = 0; i < ruleCount; ++i)
+                {
+                    _matchedRules[matchedCount++] = rules_p[i];
+                }
+
+                ++matchedSpanCount;
             }
         }
     }
+
+    // Rules of different channels and events are executed in the order they were added
+    if (matchedSpanCount > 1)
+    {
+        std::sort(_matchedRules, _matchedRules + matchedCount);
+    }
+
+    for (size_t i = 0; i < matchedCount; ++i)
+    {
+        runRuleCode(table.getRuleCode(_matchedRules[i]));
+    }
 }
 
-void ActionManager::applyForcedStates()
+// Threaded dispatch: every handler jumps straight to the handler of the next opcode.
+// Labels as values are a GNU extension, other compilers get a switch in a loop
+// over the same handlers. LIGHT_RULE_SWITCH_DISPATCH selects the switch anyway,
+// the host tests run both
+#if defined(__GNUC__) && !defined(LIGHT_RULE_SWITCH_DISPATCH)
+#define RULE_THREADED_DISPATCH
+#define RULE_HANDLER(opcode) op_##opcode:
+#define RULE_NEXT() goto *handlers[*code_p++]
+#else
+#define RULE_HANDLER(opcode) case RuleOpcode::opcode:
+#define RULE_NEXT() continue
+#endif
+
+void ActionManager::runRuleCode(const uint8_t* code_p)
 {
-    for (size_t i = 0; i < _curForcedOutputStates.size(); ++i)
+    size_t channelIndex;
+
+#if defined(RULE_THREADED_DISPATCH)
+    // Follows RuleOpcode
+    static const void* const handlers[RuleCompiler::opcodeCount] =
     {
-        const auto state = _curForcedOutputStates[i];
-        if (state == DiscreteState::unknown)
+        &&op_end,
+        &&op_testOutputOn, &&op_testOutputOff, &&op_testInputOn, &&op_testInputOff,
+        &&op_turnOn, &&op_turnOff, &&op_toggle,
+        &&op_onFor, &&op_offAfter, &&op_pulse,
+        &&op_localOff, &&op_globalOff,
+        &&op_groupOn, &&op_groupOff, &&op_groupToggle
+    };
+
+    RULE_NEXT();
+#else
+    for (;;)
+    {
+        switch (static_cast<RuleOpcode>(*code_p++))
         {
-            continue;
-        }
+#endif
+
+RULE_HANDLER(end)
+    return;
+
+RULE_HANDLER(testOutputOn)
+    if (!isOutputInState(*code_p++, DiscreteState::on))
+    {
+        return;
+    }
+    RULE_NEXT();
 
-        _curOutputStates[i] = state;
+RULE_HANDLER(testOutputOff)
+    if (!isOutputInState(*code_p++, DiscreteState::off))
+    {
+        return;
+    }
+    RULE_NEXT();
+
+RULE_HANDLER(testInputOn)
+    channelIndex = *code_p++;
+    if ((channelIndex >= _inputChannelCount) || !BitUtils::isSet(_inputOn, channelIndex))
+    {
+        return;
+    }
+    RULE_NEXT();
+
+RULE_HANDLER(testInputOff)
+    channelIndex = *code_p++;
+    if ((channelIndex >= _inputChannelCount) || !BitUtils::isSet(_inputOff, channelIndex))
+    {
+        return;
+    }
+    RULE_NEXT();
+
+RULE_HANDLER(turnOn)
+    setRuleOutput(*code_p++, DiscreteState::on);
+    RULE_NEXT();
+
+RULE_HANDLER(turnOff)
+    setRuleOutput(*code_p++, DiscreteState::off);
+    RULE_NEXT();
+
+RULE_HANDLER(toggle)
+    toggleRuleOutput(*code_p++);
+    RULE_NEXT();
+
+RULE_HANDLER(onFor)
+    startRuleTimer(code_p[0], RuleCompiler::readUint32(code_p + 1), true, true);
+    code_p += 5;
+    RULE_NEXT();
+
+RULE_HANDLER(offAfter)
+    startRuleTimer(code_p[0], RuleCompiler::readUint32(code_p + 1), true, false);
+    code_p += 5;
+    RULE_NEXT();
+
+RULE_HANDLER(pulse)
+    startRuleTimer(code_p[0], RuleCompiler::readUint32(code_p + 1), false, true);
+    code_p += 5;
+    RULE_NEXT();
+
+RULE_HANDLER(localOff)
+    executeLocalOff();
+    RULE_NEXT();
+
+RULE_HANDLER(globalOff)
+    executeGlobalOff();
+    RULE_NEXT();
+
+RULE_HANDLER(groupOn)
+    setOutputGroup(*code_p++, DiscreteState::on);
+    RULE_NEXT();
+
+RULE_HANDLER(groupOff)
+    setOutputGroup(*code_p++, DiscreteState::off);
+    RULE_NEXT();
+
+RULE_HANDLER(groupToggle)
+    toggleOutputGroup(*code_p++);
+    RULE_NEXT();
+
+#if !defined(RULE_THREADED_DISPATCH)
+        default:
+            return;
+        }
     }
+#endif
 }
 
-bool ActionManager::isRuleConditionMatches(const RuleCondition& condition) const
+#undef RULE_THREADED_DISPATCH
+#undef RULE_HANDLER
+#undef RULE_NEXT
+
+bool ActionManager::isOutputInState(size_t outputChannelIndex, DiscreteState state) const
 {
-    if (condition.eventType == EventType::none)
+    if ((outputChannelIndex >= _outputChannelCount) || !BitUtils::isSet(_outputsKnown, outputChannelIndex))
     {
         return false;
     }
 
-    const auto channelIndex = condition.inputChannelIndex;
-    if (channelIndex >= _curInputEvents.size())
+    return BitUtils::isSet(_outputsOn, outputChannelIndex) == (state == DiscreteState::on);
+}
+
+// Untimed actions cancel the timer of the output
+void ActionManager::setRuleOutput(size_t outputChannelIndex, DiscreteState state)
+{
+    if (outputChannelIndex >= _outputChannelCount)
     {
-        return false;
+        return;
+    }
+
+    _timers.cancel(outputChannelIndex);
+    setOutputState(outputChannelIndex, state);
+}
+
+// Unknown turns off
+void ActionManager::toggleRuleOutput(size_t outputChannelIndex)
+{
+    if (outputChannelIndex >= _outputChannelCount)
+    {
+        return;
     }
 
-    auto match = condition.eventType == _curInputEvents[channelIndex];
+    _timers.cancel(outputChannelIndex);
 
-    return match;
+    const auto w = BitUtils::wordIndex(outputChannelIndex);
+    const auto mask = BitUtils::bitMask(outputChannelIndex);
+    const auto isOff = (_outputsKnown[w] & ~_outputsOn[w] & mask) != 0;
+
+    setOutputState(outputChannelIndex, isOff ? DiscreteState::on : DiscreteState::off);
 }
 
-bool ActionManager::executeRuleAction(const RuleAction& action)
+// A pending timer that is not restartable makes the action be ignored
+void ActionManager::startRuleTimer(size_t outputChannelIndex, uint32_t duration_msec, bool isRestartable, bool isTurningOn)
 {
-    if (action.actionType == ActionType::none)
+    if (outputChannelIndex >= _outputChannelCount)
     {
-        return true;
+        return;
     }
 
-    if (action.actionType == ActionType::localOff)
+    if (!isRestartable && _timers.isPending(outputChannelIndex))
     {
-        executeLocalOff();
+        return;
     }
-    else if (action.actionType == ActionType::globalOff)
+
+    if (isTurningOn)
     {
-        executeGlobalOff();
+        setOutputState(outputChannelIndex, DiscreteState::on);
     }
-    else
+
+    _timers.start(outputChannelIndex, duration_msec);
+}
+
+void ActionManager::setOutputGroup(size_t groupIndex, DiscreteState state)
+{
+    if (groupIndex >= _outputGroupCount)
     {
-        const auto channelIndex = action.outputChannelIndex;
-        if (channelIndex >= _curOutputStates.size())
-        {
-            return false;
-        }
+        return;
+    }
 
-        auto state = _curOutputStates[channelIndex];
+    const auto mask_p = getOutputGroupMask(groupIndex);
+    const auto on = (state == DiscreteState::on) ? ~static_cast<BitUtils::Word>(0) : 0;
 
-        if (action.actionType == ActionType::turnOn)
-        {
-            state = DiscreteState::on;
-        }
-        else if (action.actionType == ActionType::turnOff)
-        {
-            state = DiscreteState::off;
-        }
-        else if (action.actionType == ActionType::toggle)
-        {
-            if (state == DiscreteState::on)
-            {
-                state = DiscreteState::off;
-            }
-            else if (state == DiscreteState::off)
-            {
-                state = DiscreteState::on;
-            }
-            else
-            {
-                state = DiscreteState::off;
-            }
-        }
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
+    {
+        cancelTimers(w, mask_p[w]);
+        setOutputWord(w, mask_p[w], on);
+    }
+}
 
-        _curOutputStates[channelIndex] = state;
+void ActionManager::toggleOutputGroup(size_t groupIndex)
+{
+    if (groupIndex >= _outputGroupCount)
+    {
+        return;
     }
 
-    return true;
+    const auto mask_p = getOutputGroupMask(groupIndex);
+
+    BitUtils::Word anyOn = 0;
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
+    {
+        anyOn |= _outputsOn[w] & _outputsKnown[w] & mask_p[w];
+    }
+
+    setOutputGroup(groupIndex, (anyOn != 0) ? DiscreteState::off : DiscreteState::on);
+}
+
+void ActionManager::applyForcedStates()
+{
+    if (!_hasForcedOutputs)
+    {
+        return;
+    }
+
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
+    {
+        setOutputWord(w, _forcedOutputs[w], _forcedOutputsOn[w]);
+    }
 }
 
 void ActionManager::resetInputForcedStates()
@@ -247,28 +614,123 @@ void ActionManager::resetInputForcedStates()
     _inLocalOff = false;
     _inGlobalOff = false;
 
-    for (auto it = _curForcedOutputStates.begin(); it != _curForcedOutputStates.end(); ++it)
+    if (!_hasForcedOutputs)
     {
-        *it = DiscreteState::unknown;
+        return;
     }
+
+    for (size_t w = 0; w < maxOutputWordCount; ++w)
+    {
+        _forcedOutputs[w] = 0;
+        _forcedOutputsOn[w] = 0;
+    }
+
+    _hasForcedOutputs = false;
 }
 
 void ActionManager::resetInputEvents()
 {
-    for (auto it = _curInputEvents.begin(); it != _curInputEvents.end(); ++it)
+    if (!_hasPendingEvents)
     {
-        *it = EventType::none;
+        return;
     }
+
+    for (auto& words : _pendingEvents)
+    {
+        for (auto& word : words)
+        {
+            word = 0;
+        }
+    }
+
+    _hasPendingEvents = false;
 }
 
 void ActionManager::setAllOff()
 {
-    for (auto it = _curOutputStates.begin(); it != _curOutputStates.end(); ++it)
+    _timers.cancelAll();
+
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
     {
-        *it = DiscreteState::off;
+        setOutputWord(w, ~static_cast<BitUtils::Word>(0), 0);
     }
 }
 
+void ActionManager::setOutputState(size_t outputChannelIndex, DiscreteState state)
+{
+    const auto w = BitUtils::wordIndex(outputChannelIndex);
+    const auto mask = BitUtils::bitMask(outputChannelIndex);
+
+    if (state == DiscreteState::unknown)
+    {
+        const auto changed = _outputsKnown[w] & mask;
+
+        _outputsOn[w] &= ~mask;
+        _outputsKnown[w] &= ~mask;
+
+        _changedOutputs[w] |= changed;
+        _hasChangedOutputs |= changed != 0;
+
+        return;
+    }
+
+    // The channel is in range here, no need to mask the word like setOutputWord() does
+    const auto on = (state == DiscreteState::on) ? mask : 0;
+    const auto changed = ((_outputsOn[w] & mask) ^ on) | (~_outputsKnown[w] & mask);
+
+    _outputsOn[w] = (_outputsOn[w] & ~mask) | on;
+    _outputsKnown[w] |= mask;
+
+    _changedOutputs[w] |= changed;
+    _hasChangedOutputs |= changed != 0;
+}
+
+void ActionManager::setOutputWord(size_t wordIndex, BitUtils::Word mask, BitUtils::Word on)
+{
+    mask &= BitUtils::validMask(_outputChannelCount, wordIndex);
+
+    const auto newOn = (_outputsOn[wordIndex] & ~mask) | (on & mask);
+    const auto newKnown = _outputsKnown[wordIndex] | mask;
+
+    const auto changed = (newOn ^ _outputsOn[wordIndex]) | (newKnown ^ _outputsKnown[wordIndex]);
+
+    _outputsOn[wordIndex] = newOn;
+    _outputsKnown[wordIndex] = newKnown;
+
+    _changedOutputs[wordIndex] |= changed;
+    _hasChangedOutputs |= changed != 0;
+}
+
+// Bit by bit, but only while some timer runs
+void ActionManager::cancelTimers(size_t wordIndex, BitUtils::Word mask)
+{
+    if (_timers.getPendingCount() == 0)
+    {
+        return;
+    }
+
+    while (mask != 0)
+    {
+        _timers.cancel(wordIndex * BitUtils::bitsPerWord + BitUtils::lowestSetBit(mask));
+        mask = BitUtils::clearLowestSetBit(mask);
+    }
+}
+
+void ActionManager::resetChangedOutputs()
+{
+    if (!_hasChangedOutputs)
+    {
+        return;
+    }
+
+    for (auto& word : _changedOutputs)
+    {
+        word = 0;
+    }
+
+    _hasChangedOutputs = false;
+}
+
 void ActionManager::executeLocalOff()
 {
     setAllOff();
@@ -5,19 +5,30 @@
 #include <cstdbool>
 
 #include <vector> 
-#include <list>
+#include <atomic>
 
 #include "types.h"
+#include "bit_utils.h"
+#include "timer_wheel.h"
+#include "rule_compiler.h"
+#include "rule_table.h"
 
 class ActionManager : public IActionManager, public IActionManagerConfigurator
 {
 public:
+    static const size_t maxOutputChannelCount = 128;
+    static const size_t maxOutputWordCount = maxOutputChannelCount / BitUtils::bitsPerWord;
+
     ActionManager();
 
     ActionManagerError setInputEvent(size_t inputChannelIndex, EventType event) override;
+
+    // Filtered input state the input guards check, to be set when it changes
+    ActionManagerError setInputState(size_t inputChannelIndex, DiscreteState value);
     ActionManagerError getOutputState(size_t outputChannelIndex, DiscreteState& outputState_out) override;
 
     ActionManagerError forceOutput(size_t outputChannelIndex, DiscreteState state) override;
+    ActionManagerError forceOutputGroup(size_t groupIndex, DiscreteState state);
     ActionManagerError forceLocalOff() override;
     ActionManagerError forceGlobalOff() override;
 
@@ -26,39 +37,106 @@ public:
 
     ActionManagerError execute() override;
 
+    // Every tick before execute(), runs the timers of the timed actions
+    void advanceTime(int elapsed_msec) { _elapsed_msec += static_cast<uint32_t>(elapsed_msec); }
+    size_t getPendingTimerCount() const { return _timers.getPendingCount(); }
+
+    // Change the running table, not to be used while execute() runs on another task
     ActionManagerError addRule(const Rule& rule) override;
     ActionManagerError clearRules() override;
 
+    // Replacing the rules while they run: the spare table is filled off the control path
+    // and published, execute() switches to it before the rules of its tick.
+    // Null while a published table is not taken yet
+    RuleTable* getSpareRuleTable();
+    void publishRuleTable(RuleTable* table_p);
+    bool isRuleTablePending() const { return _pendingRuleTable_p.load(std::memory_order_acquire) != nullptr; }
+
     ActionManagerError setInputChannelCount(size_t value) override;
     ActionManagerError setOutputChannelCount(size_t value) override;
 
+    ActionManagerError addOutputGroup(const uint32_t* mask, size_t wordCount) override;
+    ActionManagerError clearOutputGroups() override;
+
+    // Outputs whose state was changed by the last execute()
+    bool hasChangedOutputs() const { return _hasChangedOutputs; }
+    BitUtils::Word getChangedOutputWord(size_t wordIndex) const { return _changedOutputs[wordIndex]; }
+
 private:
+    static const size_t _maxInputChannelCount = 128;
+    static const size_t _maxOutputGroupCount = 64;
+
+    static const size_t _eventSlotCount = RuleTable::eventSlotCount;
+    static const size_t _maxInputWordCount = _maxInputChannelCount / BitUtils::bitsPerWord;
+
     void resetInputForcedStates();
     void resetInputEvents();
 
     void setAllOff();
+    void setOutputState(size_t outputChannelIndex, DiscreteState state);
+    void resetChangedOutputs();
+
+    // Word-wide: the outputs of mask are set to their bits of on
+    void setOutputWord(size_t wordIndex, BitUtils::Word mask, BitUtils::Word on);
+    void cancelTimers(size_t wordIndex, BitUtils::Word mask);
+
+    const BitUtils::Word* getOutputGroupMask(size_t groupIndex) const { return &_outputGroupMasks[groupIndex * maxOutputWordCount]; }
+    void setOutputGroup(size_t groupIndex, DiscreteState state);
+    void toggleOutputGroup(size_t groupIndex);
 
     void executeLocalOff();
     void executeGlobalOff();
 
+    void applyTimers();
     void applyRules();
     void applyForcedStates();
 
-    bool isRuleConditionMatches(const RuleCondition& condition) const;
-    bool executeRuleAction(const RuleAction& action);
+    void runRuleCode(const uint8_t* code_p);
+
+    bool isOutputInState(size_t outputChannelIndex, DiscreteState state) const;
+    void setRuleOutput(size_t outputChannelIndex, DiscreteState state);
+    void toggleRuleOutput(size_t outputChannelIndex);
+    void startRuleTimer(size_t outputChannelIndex, uint32_t duration_msec, bool isRestartable, bool isTurningOn);
+
+    // A channel may have several events in a tick (a fall and a click), a mask per event slot
+    size_t _inputChannelCount = 0;
+    BitUtils::Word _pendingEvents[_eventSlotCount][_maxInputWordCount];
+    bool _hasPendingEvents = false;
+
+    BitUtils::Word _inputOn[_maxInputWordCount];
+    BitUtils::Word _inputOff[_maxInputWordCount];
 
-    std::vector<EventType> _curInputEvents;
-    std::vector<DiscreteState> _curForcedOutputStates;
+    // Outputs to force and their states
+    BitUtils::Word _forcedOutputs[maxOutputWordCount];
+    BitUtils::Word _forcedOutputsOn[maxOutputWordCount];
+    bool _hasForcedOutputs = false;
     bool _inLocalOff;
     bool _inGlobalOff;
 
-    std::vector<DiscreteState> _curOutputStates;
+    // Output states, bit per output: the output is on, its state is known
+    size_t _outputChannelCount = 0;
+    BitUtils::Word _outputsOn[maxOutputWordCount];
+    BitUtils::Word _outputsKnown[maxOutputWordCount];
+
+    BitUtils::Word _changedOutputs[maxOutputWordCount];
+    bool _hasChangedOutputs = false;
     bool _outLocalOff;
     bool _outGlobalOff;
 
-    std::list<Rule> _rules;
+    // Timer per output, the output is turned off when it expires
+    TimerWheel _timers;
+    uint32_t _elapsed_msec = 0;
 
-    static const size_t _maxInputChannelCount = 128;
-    static const size_t _maxOutputChannelCount = 128;
-    static const size_t _maxRuleCount = 128;
+    // Output masks of maxOutputWordCount words per group
+    std::vector<BitUtils::Word> _outputGroupMasks;
+    size_t _outputGroupCount = 0;
+
+    // The running table and the spare one. Only execute() changes the running one,
+    // it switches to the published table first and then clears the pending pointer,
+    // so the spare table is never the one execute() may switch to
+    RuleTable _ruleTables[2];
+    std::atomic<RuleTable*> _activeRuleTable_p;
+    std::atomic<RuleTable*> _pendingRuleTable_p;
+
+    RuleTable::RuleNumber _matchedRules[RuleTable::maxRuleCount];
 };
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+class BitUtils
+{
+public:
+    using Word = uint32_t;
+
+    static const size_t bitsPerWord = 32;
+
+    static size_t wordCount(size_t bitCount) { return (bitCount + bitsPerWord - 1) / bitsPerWord; }
+    static size_t wordIndex(size_t bitIndex) { return bitIndex / bitsPerWord; }
+    static Word bitMask(size_t bitIndex) { return static_cast<Word>(1) << (bitIndex % bitsPerWord); }
+
+    // Mask of the bits of word wordIndex that belong to the first bitCount bits
+    static Word validMask(size_t bitCount, size_t wordIndex)
+    {
+        const auto firstBit = wordIndex * bitsPerWord;
+        if (bitCount >= firstBit + bitsPerWord)
+        {
+            return ~static_cast<Word>(0);
+        }
+
+        if (bitCount <= firstBit)
+        {
+            return 0;
+        }
+
+        return (static_cast<Word>(1) << (bitCount - firstBit)) - 1;
+    }
+
+    static bool isSet(const Word* words, size_t bitIndex) { return (words[wordIndex(bitIndex)] & bitMask(bitIndex)) != 0; }
+
+    static void assign(Word* words, size_t bitIndex, bool value)
+    {
+        auto& word = words[wordIndex(bitIndex)];
+        const auto mask = bitMask(bitIndex);
+
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+    // Index of the lowest set bit, word must not be zero
+    static size_t lowestSetBit(Word word) { return static_cast<size_t>(__builtin_ctz(word)); }
+    static Word clearLowestSetBit(Word word) { return word & (word - 1); }
+};
@@ -8,14 +8,19 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <algorithm>
 
 #include "types.h" 
+#include "string_utils.h"
 
 struct InputChannelInfo
 {
 	std::string name;
 	size_t number;
+	
+	// acWindow stands for the AC detector of the controller
+	InputFilterSettings filter;
 };
 
 struct OutputChannelInfo
@@ -35,14 +40,16 @@ template <typename T>
 	
 		bool resolveChannelName(const std::string& channelName, size_t& channelIndex_out) const override
 		{
-			auto name = channelName;
-			std::transform(name.begin(), name.end(), name.begin(), [](int ch) { return std::tolower(ch); });
+			const auto hash = StringUtils::hashCaseInsensitive(channelName);
+			
+			auto it = std::lower_bound(_nameIndex.begin(), _nameIndex.end(), hash, 
+				[](const NameIndexItem& item, uint32_t value) { return item.hash < value; });
 		
-			for (const auto& item : _channels)
+			for (; (it != _nameIndex.end()) && (it->hash == hash); ++it)
 			{
-				if (item.second.name == name)
+				if (StringUtils::equal(*it->name_p, channelName))
 				{
-					channelIndex_out = item.first;
+					channelIndex_out = it->number;
 					return true;
 				}
 			}
@@ -62,16 +69,65 @@ template <typename T>
 			return true;
 		}
 		
+		bool getChannelInfo(size_t index, T& result_out) const
+		{
+			const auto it = _channels.find(index);
+			if (it == _channels.end()) 
+			{
+				return false;
+			}
+			
+			result_out = it->second;
+			return true;
+		}
+		
 		void addChannel(const T& channel)
 		{
+			removeFromIndex(channel.number);
+			
 			_channels[channel.number] = channel;
 		
 			auto& name = _channels[channel.number].name;
 			std::transform(name.begin(), name.end(), name.begin(), [](int ch) { return std::tolower(ch); });
+			
+			NameIndexItem item;
+			
+			item.hash = StringUtils::hashCaseInsensitive(name);
+			item.number = channel.number;
+			item.name_p = &name;
+			
+			// Equal names resolve to the lowest channel number
+			const auto it = std::upper_bound(_nameIndex.begin(), _nameIndex.end(), item, 
+				[](const NameIndexItem& v1, const NameIndexItem& v2) 
+				{ 
+					return (v1.hash < v2.hash) || ((v1.hash == v2.hash) && (v1.number < v2.number)); 
+				});
+			
+			_nameIndex.insert(it, item);
 		}
 	
 	private:
+		// Sorted by name hash, the names point into _channels nodes which are never erased
+		struct NameIndexItem
+		{
+			uint32_t hash;
+			size_t number;
+			const std::string* name_p;
+		};
+		
+		void removeFromIndex(size_t number)
+		{
+			const auto it = std::find_if(_nameIndex.begin(), _nameIndex.end(), 
+				[number](const NameIndexItem& item) { return item.number == number; });
+			
+			if (it != _nameIndex.end())
+			{
+				_nameIndex.erase(it);
+			}
+		}
+		
 		std::map<size_t, T> _channels;
+		std::vector<NameIndexItem> _nameIndex;
 	};
 
 using InputChannelList = ChannelList<InputChannelInfo>;
@@ -36,11 +36,81 @@ bool parseChannelInfo_common(const std::string& line, T& result_out)
 	}*/
 }
 
+// ac, dc, dc:MSEC or raw
+static bool parseInputFilter(const std::string& word, InputFilterSettings& result_out)
+{
+	const auto separatorPos = word.find(':');
+	const auto kindText = word.substr(0, separatorPos);
+	
+	if (StringUtils::equal(kindText, "ac"))
+	{
+		result_out.kind = InputFilterKind::acWindow;
+	}
+	else if (StringUtils::equal(kindText, "dc"))
+	{
+		result_out.kind = InputFilterKind::dcDebounce;
+	}
+	else if (StringUtils::equal(kindText, "raw"))
+	{
+		result_out.kind = InputFilterKind::raw;
+	}
+	else
+	{
+		return false;
+	}
+	
+	if (separatorPos == std::string::npos)
+	{
+		return true;
+	}
+	
+	if (result_out.kind != InputFilterKind::dcDebounce)
+	{
+		return false;
+	}
+	
+	unsigned int debounce_msec;
+	if ((StringUtils::parseNumber(word.substr(separatorPos + 1), debounce_msec) != NumberParsingResult::success) || 
+		(debounce_msec > UINT16_MAX))
+	{
+		return false;
+	}
+	
+	result_out.debounce_msec = static_cast<int>(debounce_msec);
+	return true;
+}
+
 template <>
 bool ChannelsReader<InputChannelInfo>::parseChannelInfo(const std::string& line, InputChannelInfo& result_out)
 {
-	const auto ok = parseChannelInfo_common(line, result_out);
-	return ok;
+	size_t pos = 0;
+	std::string curWord;
+	
+	if (!StringUtils::nextWord(line, pos, curWord))
+	{
+		return false;
+	}
+	
+	result_out.name = curWord;
+	result_out.filter = InputFilterSettings();
+	
+	if (!StringUtils::nextWord(line, pos, curWord))
+	{
+		return true;
+	}
+	
+	// Dropping the line would renumber the channels after it
+	if (!parseInputFilter(curWord, result_out.filter) || StringUtils::nextWord(line, pos, curWord))
+	{
+		LogError msg(_logger, ILogger::ErrorSeverity::warning);
+		
+		msg.addText("Invalid input filter, using the AC one: ");
+		msg.addText(line);
+		
+		result_out.filter = InputFilterSettings();
+	}
+	
+	return true;
 }
 
 template <>
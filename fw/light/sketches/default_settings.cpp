@@ -92,6 +92,12 @@ R"text(
 // Items must not contain any whitespace characters (whitespace itself, tabulator etc.).
 // Empty lines are allowed.
 // To disable a line, add two slashes (//) at the beginning.
+//
+// An item may be followed by the input filter of the channel:
+//     ac        - mains switch through an optocoupler (default)
+//     dc        - pushbutton, debounced for 10 ms
+//     dc:MSEC   - pushbutton, debounced for MSEC milliseconds
+//     raw       - no filtering
 
 // Example:
 //     door_switch
@@ -99,6 +105,7 @@ R"text(
 //     bed_switch_left_sconce
 //     bed_switch_right_chandelier
 //     bed_switch_right_sconce
+//     hall_pushbutton dc:15
 
 in1
 in2
@@ -146,14 +153,31 @@ R"text(
 // Rules settings file
 //
 // Rule syntax:  
-//     INPUT_CHANNEL EVENT OUTPUT_CHANNEL ACTION
+//     INPUT_CHANNEL EVENT OUTPUT_CHANNEL ACTION [OUTPUT_CHANNEL ACTION]... [if GUARD [and GUARD]...]
+//
+// An event may drive several outputs, the actions are applied in order.
+// Guards make the rule run only if every guarded channel is in the given state:
+//     output OUTPUT_CHANNEL is on|off
+//     input INPUT_CHANNEL is on|off
+// Output guards see the states left by the rules applied before.
 //
 // Empty lines are allowed.
 // To disable line, add two slashes (//) at the beginning.
 //
+// The rules are applied without a restart once this file is uploaded by FTP, or on the
+// /api/v1/rules/reload HTTP request. Outputs keep their states. If any rule is invalid,
+// the previous rules keep running. Changes to the channel or group files need a restart.
+//
 // Events:  
-//     fall - event is fired on switching input off
-//     rise - event is fired on switching input on
+//     fall         - event is fired on switching input off
+//     rise         - event is fired on switching input on
+//     click        - input was on for less than 700 ms and no second click followed within 350 ms
+//     double_click - second short press within 350 ms of the first one
+//     long_press   - input is held on for 700 ms
+//     hold_repeat  - fired every 300 ms while input is held after a long_press
+//
+// A press fires rise and fall as well as the gesture events. A click is fired 350 ms after
+// the release, when no double click can follow.
 //
 // Actions: 
 //     turn_off   - output is switched off
@@ -162,6 +186,17 @@ R"text(
 //     local_off  - all outputs are turned off
 //     global_off - all ouputs are turned off, a pulse is fetched to the global off output
 //
+// Group actions, OUTPUT_CHANNEL is the name of an output group:
+//     group_on     - all outputs of the group are switched on
+//     group_off    - all outputs of the group are switched off
+//     group_toggle - all outputs of the group are switched off if any of them is on, switched on otherwise
+//
+// Timed actions, ACTION:DURATION with the duration in ms, s (the default) or m, e.g. on_for:90s:
+//     on_for     - output is switched on and switched off after the duration, a repeated event restarts it
+//     off_after  - output is switched off after the duration, a repeated event restarts it
+//     pulse      - output is switched on for the duration, repeated events do not prolong it
+// Any other action on the output cancels the pending switch off.
+//
 // For the local_off and global_off actions OUTPUT_CHANNEL may be anything, but must not be ommited (will be fixed later maybe).
 //
 // Example: 
@@ -174,6 +209,11 @@ R"text(
 // This example shows a bedroom configuration when we have a chandelier and two sconces on the sides of the bed.
 // Chanlelier is controlled by the switch near the door and two switches on the sides of the bed.
 // Sconces are controlled by the related switches on the sides of the bed.
+//
+// Example of a scene switch and of a guarded rule:
+//     door_switch long_press chandelier turn_off bed_sconce_left turn_off bed_sconce_right turn_off
+//     bed_switch_left_sconce double_click chandelier turn_on if output bed_sconce_left is off
+//     door_switch double_click bedroom group_toggle
 	
 in1 fall out1 turn_off
 in1 rise out1 turn_on
@@ -225,6 +265,54 @@ in16 fall out8 turn_off
 in16 rise out8 turn_on
 )text";
 	
+const String DefaultSettingsCreator::_expandersText = 
+R"text(
+// I2C expanders pin map
+//
+// Line syntax:  
+//     input PIN PIN ...
+//     output PIN PIN ...
+//
+// Every PIN adds the next channel of the input or output channels list, lines add to each other.
+// PIN is written as ADDRESS:NUMBER, where 
+//     ADDRESS is the hexadecimal I2C address of a PCF8574 (0x20..0x27) or PCF8574A (0x38..0x3F)
+//     NUMBER is the expander pin 0..7, or * for all pins 0..7 in order
+// Up to 128 inputs and 128 outputs on up to 16 expanders per direction are supported.
+// Expanders are searched on the bus at startup, channels of missing ones stay unknown.
+//
+// Empty lines are allowed.
+// To disable line, add two slashes (//) at the beginning.
+//
+// Example: 
+//     input 0x20:* 0x21:*
+//     output 0x38:* 0x39:0 0x39:1
+	
+input 0x20:5 0x21:3 0x20:4 0x21:4 0x20:0 0x21:0 0x20:3 0x21:5
+input 0x20:2 0x21:6 0x20:1 0x21:7 0x20:7 0x21:1 0x20:6 0x21:2
+
+output 0x24:5 0x24:4 0x24:0 0x24:3 0x24:2 0x24:1 0x24:7 0x24:6
+)text";
+
+const String DefaultSettingsCreator::_outputGroupsText = 
+R"text(
+// Output groups
+//
+// Line syntax:  
+//     GROUP_NAME OUTPUT_CHANNEL [OUTPUT_CHANNEL]...
+//
+// A group names a set of outputs for the group_on, group_off and group_toggle rule actions
+// and for the network controls. Group names are compared case-insensitively and must differ
+// from each other. Up to 64 groups are supported.
+//
+// Empty lines are allowed.
+// To disable line, add two slashes (//) at the beginning.
+//
+// Example: 
+//     bedroom chandelier bed_sconce_left bed_sconce_right
+	
+//all out1 out2 out3 out4 out5 out6 out7 out8
+)text";
+	
 bool DefaultSettingsCreator::execute()
 {
 	assert(_fileSystem_p != nullptr);
@@ -252,6 +340,20 @@ bool DefaultSettingsCreator::execute()
 		ok &= writeText(_rulesText, _rulesFilename, _overwriteIfExists);
 	}	
 	
+	if (!_expandersFilename.isEmpty())
+	{
+		_logger.trace("Writing I2C expanders defaults");
+		
+		ok &= writeText(_expandersText, _expandersFilename, _overwriteIfExists);
+	}	
+	
+	if (!_outputGroupsFilename.isEmpty())
+	{
+		_logger.trace("Writing output groups defaults");
+		
+		ok &= writeText(_outputGroupsText, _outputGroupsFilename, _overwriteIfExists);
+	}	
+	
 	if (!_mainSettingsFilename.isEmpty())
 	{
 		_logger.trace("Writing main settings");
@@ -26,6 +26,8 @@ public:
 	void setInputsFilename(const String& value) { _inputsFilename = value; }
 	void setOutputsFilename(const String& value) { _outputsFilename = value; }
 	void setRulesFilename(const String& value) { _rulesFilename = value; }
+	void setExpandersFilename(const String& value) { _expandersFilename = value; }
+	void setOutputGroupsFilename(const String& value) { _outputGroupsFilename = value; }
 	
 	bool execute();
 	
@@ -40,6 +42,8 @@ private:
 	String _inputsFilename;
 	String _outputsFilename;
 	String _rulesFilename;
+	String _expandersFilename;
+	String _outputGroupsFilename;
 	
 	bool _overwriteIfExists = false;
 	
@@ -47,4 +51,6 @@ private:
 	static const String _inputsText;
 	static const String _outputsText;
 	static const String _rulesText;
+	static const String _expandersText;
+	static const String _outputGroupsText;
 };
\ No newline at end of file
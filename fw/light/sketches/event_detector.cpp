@@ -4,30 +4,48 @@ EventDetector::EventDetector() :
     IEventDetector(),
     IEventDetectorConfigurator()
 {
-    _previousStates_p = &_statesA;
-    _currentStates_p = &_statesB; 
+    for (size_t i = 0; i < _maxWordCount; ++i)
+    {
+        _currentOn[i] = 0;
+        _currentKnown[i] = 0;
+    }
+
+    resetPreviousStates();
+    resetEvents();
+    resetGestures();
 }
 
 EventDetectorError EventDetector::setInputState(size_t channelIndex, DiscreteState value)
 {
-    if (channelIndex >= _currentStates_p->size())
+    if (channelIndex >= _channelCount)
     {
         return EventDetectorError::invalidChannelIndex;
     }
 
-    (*_currentStates_p)[channelIndex] = value;
+    BitUtils::assign(_currentOn, channelIndex, value == DiscreteState::on);
+    BitUtils::assign(_currentKnown, channelIndex, value != DiscreteState::unknown);
 
     return EventDetectorError::none;
 }
 
 EventDetectorError EventDetector::getOutputEvent(size_t channelIndex, EventType& result_out)
 {
-    if (channelIndex >= _currentEvents.size())
+    if (channelIndex >= _channelCount)
     {
         return EventDetectorError::invalidChannelIndex;
     }
 
-    result_out = _currentEvents[channelIndex];
+    // The first of the events of the tick
+    result_out = EventType::none;
+
+    for (size_t kind = 0; kind < eventKindCount; ++kind)
+    {
+        if (BitUtils::isSet(_events[kind], channelIndex))
+        {
+            result_out = getEventType(kind);
+            break;
+        }
+    }
 
     return EventDetectorError::none;
 }
@@ -39,58 +57,223 @@ EventDetectorError EventDetector::setChannelCount(size_t value)
         return EventDetectorError::tooManyChannels;
     }
 
-    _statesA.resize(value);
-    _statesB.resize(value);
-    _currentEvents.resize(value);
+    _channelCount = value;
+    _wordCount = BitUtils::wordCount(value);
+
+    for (size_t i = 0; i < _maxWordCount; ++i)
+    {
+        _currentOn[i] = 0;
+        _currentKnown[i] = 0;
+    }
 
     resetPreviousStates();
     resetEvents();
+    resetGestures();
 
     return EventDetectorError::none;
 }
 
 EventDetectorError EventDetector::execute()
 {
-    for (size_t i = 0; i < _currentEvents.size(); ++i)
+    Word any = 0;
+
+    for (size_t i = 0; i < _wordCount; ++i)
     {
-        const auto prevState = (*_previousStates_p)[i];
-        const auto curState = (*_currentStates_p)[i];
+        const auto prevOn = _previousOn[i];
+        const auto prevOff = _previousKnown[i] & ~prevOn;
+
+        const auto curOn = _currentOn[i];
+        const auto curOff = _currentKnown[i] & ~curOn;
 
-        EventType event;
+        _events[_riseKind][i] = prevOff & curOn;
+        _events[_fallKind][i] = prevOn & curOff;
 
-        if ((prevState == DiscreteState::off) && (curState == DiscreteState::on))
+        for (auto kind = _clickKind; kind < eventKindCount; ++kind)
         {
-            event = EventType::rise;
+            _events[kind][i] = 0;
         }
-        else if ((prevState == DiscreteState::on) && (curState == DiscreteState::off))
+
+        // Gestures of the channels that became unknown are dropped
+        const auto lost = _previousKnown[i] & ~_currentKnown[i];
+
+        if ((_gestures[i] | _events[_riseKind][i] | _events[_fallKind][i] | lost) != 0)
         {
-            event = EventType::fall;
+            detectGestures(i, lost);
         }
-        else
+
+        for (size_t kind = 0; kind < eventKindCount; ++kind)
         {
-            event = EventType::none;
+            any |= _events[kind][i];
         }
 
-        _currentEvents[i] = event;
+        _previousOn[i] = curOn;
+        _previousKnown[i] = _currentKnown[i];
     }
 
-    std::swap(_previousStates_p, _currentStates_p);
+    _hasEvents = any != 0;
+
+    Word gestures = 0;
+    for (size_t i = 0; i < _wordCount; ++i)
+    {
+        gestures |= _gestures[i];
+    }
+
+    _hasGestures = gestures != 0;
 
     return EventDetectorError::none;
 }
 
+void EventDetector::detectGestures(size_t wordIndex, Word lost)
+{
+    const auto rise = _events[_riseKind][wordIndex];
+    const auto fall = _events[_fallKind][wordIndex];
+
+    auto pending = _gestures[wordIndex] | rise | fall | lost;
+
+    while (pending != 0)
+    {
+        const auto bit = BitUtils::lowestSetBit(pending);
+        const auto mask = BitUtils::bitMask(bit);
+
+        pending = BitUtils::clearLowestSetBit(pending);
+
+        updateGesture(wordIndex * BitUtils::bitsPerWord + bit, (rise & mask) != 0, (fall & mask) != 0, (lost & mask) != 0);
+    }
+}
+
+void EventDetector::updateGesture(size_t channelIndex, bool isRise, bool isFall, bool isLost)
+{
+    auto phase = _phases[channelIndex];
+
+    // Timeouts first, a change of the same tick comes after them
+    switch (phase)
+    {
+        case GesturePhase::pressed:
+        case GesturePhase::pressedAgain:
+            if ((_gestureTimes.longPress_msec > 0) && isElapsed(channelIndex, _gestureTimes.longPress_msec))
+            {
+                addEvent(_longPressKind, channelIndex);
+
+                phase = GesturePhase::held;
+                setPhase(channelIndex, phase);
+            }
+            break;
+
+        case GesturePhase::held:
+            if ((_gestureTimes.holdRepeat_msec > 0) && isElapsed(channelIndex, _gestureTimes.holdRepeat_msec))
+            {
+                addEvent(_holdRepeatKind, channelIndex);
+
+                // Keeps the cadence, unless the ticks fell a whole period behind
+                _phaseStarts_msec[channelIndex] += static_cast<uint32_t>(_gestureTimes.holdRepeat_msec);
+                if (isElapsed(channelIndex, _gestureTimes.holdRepeat_msec))
+                {
+                    _phaseStarts_msec[channelIndex] = _clock_msec;
+                }
+            }
+            break;
+
+        case GesturePhase::released:
+            if (isElapsed(channelIndex, _gestureTimes.doubleClick_msec))
+            {
+                addEvent(_clickKind, channelIndex);
+
+                phase = GesturePhase::idle;
+                setPhase(channelIndex, phase);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    if (isLost)
+    {
+        setPhase(channelIndex, GesturePhase::idle);
+    }
+    else if (isRise)
+    {
+        setPhase(channelIndex, (phase == GesturePhase::released) ? GesturePhase::pressedAgain : GesturePhase::pressed);
+    }
+    else if (isFall)
+    {
+        auto next = GesturePhase::idle;
+
+        if (phase == GesturePhase::pressed)
+        {
+            if (_gestureTimes.doubleClick_msec > 0)
+            {
+                next = GesturePhase::released;
+            }
+            else
+            {
+                addEvent(_clickKind, channelIndex);
+            }
+        }
+        else if (phase == GesturePhase::pressedAgain)
+        {
+            addEvent(_doubleClickKind, channelIndex);
+        }
+
+        // A release after a long press ends the gesture
+        setPhase(channelIndex, next);
+    }
+}
+
+void EventDetector::setPhase(size_t channelIndex, GesturePhase value)
+{
+    _phases[channelIndex] = value;
+    _phaseStarts_msec[channelIndex] = _clock_msec;
+
+    BitUtils::assign(_gestures, channelIndex, value != GesturePhase::idle);
+}
+
+bool EventDetector::isElapsed(size_t channelIndex, int duration_msec) const
+{
+    // Wraparound safe
+    const auto elapsed_msec = _clock_msec - _phaseStarts_msec[channelIndex];
+    return elapsed_msec >= static_cast<uint32_t>(duration_msec);
+}
+
+void EventDetector::addEvent(size_t kind, size_t channelIndex)
+{
+    BitUtils::assign(_events[kind], channelIndex, true);
+}
+
 void EventDetector::resetPreviousStates()
 {
-    for (auto it = _previousStates_p->begin(); it != _previousStates_p->end(); ++it)
+    for (size_t i = 0; i < _maxWordCount; ++i)
     {
-        *it = DiscreteState::off;
+        _previousOn[i] = 0;
+        _previousKnown[i] = BitUtils::validMask(_channelCount, i);
     }
 }
 
 void EventDetector::resetEvents()
 {
-    for (auto it = _currentEvents.begin(); it != _currentEvents.end(); ++it)
+    for (auto& words : _events)
     {
-        *it = EventType::none;
+        for (auto& word : words)
+        {
+            word = 0;
+        }
     }
+
+    _hasEvents = false;
+}
+
+void EventDetector::resetGestures()
+{
+    for (size_t i = 0; i < _maxChannelCount; ++i)
+    {
+        _phases[i] = GesturePhase::idle;
+        _phaseStarts_msec[i] = 0;
+    }
+
+    for (auto& word : _gestures)
+    {
+        word = 0;
+    }
+
+    _hasGestures = false;
 }
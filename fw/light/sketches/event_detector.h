@@ -4,14 +4,22 @@
 #include <cstdint>
 #include <cstdbool>
 
-#include <vector>
-
 #include "types.h"
+#include "bit_utils.h"
 
+// Channel states and events are kept as bit masks, one bit per channel,
+// so that edge detection runs over whole words instead of channel by channel.
+// Gestures (clicks, long presses) are timed per channel, only for the channels
+// that changed or have a gesture in progress.
 class EventDetector : public IEventDetector, public IEventDetectorConfigurator
 {
 public:
-    EventDetector(); 
+    using Word = BitUtils::Word;
+
+    // Every EventType but none, kind = event - 1
+    static const size_t eventKindCount = 6;
+
+    EventDetector();
 
     EventDetectorError setInputState(size_t channelIndex, DiscreteState value) override;
     EventDetectorError getOutputEvent(size_t channelIndex, EventType& result_out) override;
@@ -20,19 +28,72 @@ public:
 
     EventDetectorError execute() override;
 
+    void setGestureTimes(const GestureTimes& value) { _gestureTimes = value; }
+
+    // Every tick, execute() may be skipped while there are no changes, events or gestures
+    void advanceTime(int elapsed_msec) { _clock_msec += static_cast<uint32_t>(elapsed_msec); }
+    bool hasGestures() const { return _hasGestures; }
+
+    size_t getWordCount() const { return _wordCount; }
+
+    Word getEventWord(size_t kind, size_t wordIndex) const { return (wordIndex < _wordCount) ? _events[kind][wordIndex] : 0; }
+    Word getRiseWord(size_t wordIndex) const { return getEventWord(_riseKind, wordIndex); }
+    Word getFallWord(size_t wordIndex) const { return getEventWord(_fallKind, wordIndex); }
+
+    static EventType getEventType(size_t kind) { return static_cast<EventType>(kind + 1); }
+
+    bool hasEvents() const { return _hasEvents; }
+
 private:
-    using States = std::vector<DiscreteState>;
+    enum class GesturePhase : uint8_t
+    {
+        idle,
+        pressed,
+        held,           // Long press reported
+        released,       // Waiting for a second press
+        pressedAgain
+    };
+
+    static const size_t _maxChannelCount = 128;
+    static const size_t _maxWordCount = _maxChannelCount / BitUtils::bitsPerWord;
+
+    static const size_t _riseKind = 0;
+    static const size_t _fallKind = 1;
+    static const size_t _clickKind = 2;
+    static const size_t _doubleClickKind = 3;
+    static const size_t _longPressKind = 4;
+    static const size_t _holdRepeatKind = 5;
 
     void resetPreviousStates();
     void resetEvents();
+    void resetGestures();
 
-    States _statesA;
-    States _statesB;
+    void detectGestures(size_t wordIndex, Word lost);
+    void updateGesture(size_t channelIndex, bool isRise, bool isFall, bool isLost);
+    void setPhase(size_t channelIndex, GesturePhase value);
+    bool isElapsed(size_t channelIndex, int duration_msec) const;
+    void addEvent(size_t kind, size_t channelIndex);
 
-    States* _previousStates_p;
-    States* _currentStates_p;
+    size_t _channelCount = 0;
+    size_t _wordCount = 0;
 
-    std::vector<EventType> _currentEvents;
+    Word _previousOn[_maxWordCount];
+    Word _previousKnown[_maxWordCount];
 
-    static const size_t _maxChannelCount = 128;
+    Word _currentOn[_maxWordCount];
+    Word _currentKnown[_maxWordCount];
+
+    Word _events[eventKindCount][_maxWordCount];
+
+    bool _hasEvents = false;
+
+    GestureTimes _gestureTimes;
+    uint32_t _clock_msec = 0;
+
+    GesturePhase _phases[_maxChannelCount];
+    uint32_t _phaseStarts_msec[_maxChannelCount];
+
+    // Channels not in the idle phase
+    Word _gestures[_maxWordCount];
+    bool _hasGestures = false;
 };
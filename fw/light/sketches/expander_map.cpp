@@ -0,0 +1,325 @@
+#include <cassert>
+
+#include <Wire.h>
+
+#include "string_utils.h"
+#include "expander_map.h"
+
+static const uint8_t pcf8574BaseAddress = 0x20;
+static const uint8_t pcf8574aBaseAddress = 0x38;
+static const uint8_t addressesPerKind = 8;
+static const uint8_t pinsPerExpander = 8;
+
+// Bit of the address in the 16 bit presence mask
+static size_t getAddressBit(uint8_t address)
+{
+	if (address >= pcf8574aBaseAddress)
+	{
+		return addressesPerKind + address - pcf8574aBaseAddress;
+	}
+	
+	return address - pcf8574BaseAddress;
+}
+
+static std::string toHex(uint8_t value)
+{
+	char buf[8];
+	snprintf(buf, sizeof(buf), "0x%02X", value);
+	
+	return std::string(buf);
+}
+
+bool ExpanderMap::isExpanderAddress(uint8_t address)
+{
+	const auto isPcf8574 = (address >= pcf8574BaseAddress) && (address < pcf8574BaseAddress + addressesPerKind);
+	const auto isPcf8574a = (address >= pcf8574aBaseAddress) && (address < pcf8574aBaseAddress + addressesPerKind);
+	
+	return isPcf8574 || isPcf8574a;
+}
+
+bool ExpanderMap::read()
+{
+	assert(_fileSystem_p != nullptr);
+	
+	_inputPins.clear();
+	_outputPins.clear();
+	
+	_inputAddressMask = 0;
+	_outputAddressMask = 0;
+	
+	for (auto& mask : _usedPinMasks)
+	{
+		mask = 0;
+	}
+	
+	auto file = _fileSystem_p->open(_filename);
+	if (!file)
+	{
+		LogError msg(_logger, ILogger::ErrorSeverity::error);
+		
+		msg.addText("Failed to open file ");
+		msg.addText(std::string(_filename.c_str()));
+		
+		return false;
+	}
+	
+	while (file.available() > 0)
+	{
+		auto line = file.readStringUntil('\n');
+		std::string s(line.c_str());
+		
+		StringUtils::trim(s);
+		
+		if (s.empty() || (s.substr(0, 2) == "//"))
+		{
+			continue;
+		}
+		
+		if (!parseLine(s))
+		{
+			writeInvalidLineToLog(s);
+		}
+	}
+	
+	file.close();
+	return true;
+}
+
+void ExpanderMap::scan()
+{
+	_presentMask = 0;
+	
+	for (size_t kind = 0; kind < 2; ++kind)
+	{
+		const auto baseAddress = (kind == 0) ? pcf8574BaseAddress : pcf8574aBaseAddress;
+		
+		for (uint8_t i = 0; i < addressesPerKind; ++i)
+		{
+			const uint8_t address = baseAddress + i;
+			
+			Wire.beginTransmission(address);
+			if (Wire.endTransmission() != (uint8_t) 0)
+			{
+				continue;
+			}
+			
+			_presentMask |= 1u << getAddressBit(address);
+			
+			LogInfo msg(_logger);
+			msg.addText("Found I2C expander at ");
+			msg.addText(toHex(address));
+		}
+	}
+	
+	auto reportMissing = [this](const std::vector<ExpanderPin>& pins)
+	{
+		uint16_t reportedMask = 0;
+		
+		for (const auto& item : pins)
+		{
+			const auto bit = 1u << getAddressBit(item.address);
+			if ((_presentMask & bit) || (reportedMask & bit))
+			{
+				continue;
+			}
+			
+			reportedMask |= bit;
+			
+			LogError msg(_logger, ILogger::ErrorSeverity::warning);
+			msg.addText("Mapped I2C expander not found at ");
+			msg.addText(toHex(item.address));
+		}
+	};
+	
+	reportMissing(_inputPins);
+	reportMissing(_outputPins);
+}
+
+bool ExpanderMap::isPresent(uint8_t address) const
+{
+	if (!isExpanderAddress(address))
+	{
+		return false;
+	}
+	
+	return (_presentMask & (1u << getAddressBit(address))) != 0;
+}
+
+bool ExpanderMap::assignExpanders(const std::vector<ExpanderPin>& pins, 
+	uint8_t* addresses_out, size_t& expanderCount_out, std::vector<ExpanderChannel>& channels_out)
+{
+	expanderCount_out = 0;
+	channels_out.clear();
+	channels_out.reserve(pins.size());
+	
+	for (const auto& item : pins)
+	{
+		size_t expanderIndex = 0;
+		while ((expanderIndex < expanderCount_out) && (addresses_out[expanderIndex] != item.address))
+		{
+			++expanderIndex;
+		}
+		
+		if (expanderIndex == expanderCount_out)
+		{
+			if (expanderCount_out >= maxExpanderCount)
+			{
+				return false;
+			}
+			
+			addresses_out[expanderCount_out++] = item.address;
+		}
+		
+		ExpanderChannel channel;
+		
+		channel.expanderIndex = expanderIndex;
+		channel.channelNumber = item.pin;
+		
+		channels_out.push_back(channel);
+	}
+	
+	return true;
+}
+
+bool ExpanderMap::parseLine(const std::string& line)
+{
+	size_t pos = 0;
+	std::string word;
+	
+	if (!StringUtils::nextWord(line, pos, word))
+	{
+		return false;
+	}
+	
+	bool isOutput;
+	
+	if (StringUtils::equal(word, "input"))
+	{
+		isOutput = false;
+	}
+	else if (StringUtils::equal(word, "output"))
+	{
+		isOutput = true;
+	}
+	else
+	{
+		return false;
+	}
+	
+	auto ok = true;
+	while (StringUtils::nextWord(line, pos, word))
+	{
+		ok &= parsePins(word, isOutput);
+	}
+	
+	return ok;
+}
+
+// Skipping a pin keeps the rest of the line, so only the channels after it move down by one
+bool ExpanderMap::parsePins(const std::string& word, bool isOutput)
+{
+	const auto separatorPos = word.find(':');
+	if (separatorPos == std::string::npos)
+	{
+		return false;
+	}
+	
+	auto addressText = word.substr(0, separatorPos);
+	const auto pinText = word.substr(separatorPos + 1);
+	
+	if ((addressText.size() > 2) && StringUtils::equal(addressText.substr(0, 2), "0x"))
+	{
+		addressText.erase(0, 2);
+	}
+	
+	unsigned int address;
+	if (StringUtils::parseNumber(addressText, address, 16) != NumberParsingResult::success)
+	{
+		return false;
+	}
+	
+	if ((address > UINT8_MAX) || !isExpanderAddress(static_cast<uint8_t>(address)))
+	{
+		return false;
+	}
+	
+	uint8_t firstPin = 0;
+	uint8_t lastPin = pinsPerExpander - 1;
+	
+	if (pinText != "*")
+	{
+		unsigned int pin;
+		if (StringUtils::parseNumber(pinText, pin) != NumberParsingResult::success)
+		{
+			return false;
+		}
+		
+		if (pin >= pinsPerExpander)
+		{
+			return false;
+		}
+		
+		firstPin = lastPin = static_cast<uint8_t>(pin);
+	}
+	
+	auto& pins = isOutput ? _outputPins : _inputPins;
+	
+	const auto addressBit = static_cast<uint16_t>(1u << getAddressBit(static_cast<uint8_t>(address)));
+	auto& addressMask = isOutput ? _outputAddressMask : _inputAddressMask;
+	const auto otherAddressMask = isOutput ? _inputAddressMask : _outputAddressMask;
+	
+	auto& usedPinMask = _usedPinMasks[getAddressBit(static_cast<uint8_t>(address))];
+	
+	for (auto pin = firstPin; pin <= lastPin; ++pin)
+	{
+		if (pins.size() >= maxChannelCount)
+		{
+			_logger.error("Too many channels in the expander map", ILogger::ErrorSeverity::warning);
+			return false;
+		}
+		
+		if ((otherAddressMask & addressBit) != 0)
+		{
+			writeSkippedPinToLog(static_cast<uint8_t>(address), pin, isOutput ? "the expander is an input one" : "the expander is an output one");
+			continue;
+		}
+		
+		if ((usedPinMask & (1u << pin)) != 0)
+		{
+			writeSkippedPinToLog(static_cast<uint8_t>(address), pin, "the pin is already mapped");
+			continue;
+		}
+		
+		addressMask |= addressBit;
+		usedPinMask |= static_cast<uint8_t>(1u << pin);
+		
+		ExpanderPin item;
+		
+		item.address = static_cast<uint8_t>(address);
+		item.pin = pin;
+		
+		pins.push_back(item);
+	}
+	
+	return true;
+}
+
+void ExpanderMap::writeSkippedPinToLog(uint8_t address, uint8_t pin, const char* reason)
+{
+	LogError msg(_logger, ILogger::ErrorSeverity::warning);
+	
+	msg.addText("Expander pin ");
+	msg.addText(toHex(address));
+	msg.addText(":");
+	msg.addText(std::to_string(pin));
+	msg.addText(" skipped, ");
+	msg.addText(reason);
+}
+
+void ExpanderMap::writeInvalidLineToLog(const std::string& s)
+{
+	LogError msg(_logger, ILogger::ErrorSeverity::warning);
+	
+	msg.addText("Invalid expander map string: ");
+	msg.addText(s);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "log_utils.h"
+
+struct ExpanderPin
+{
+	uint8_t address;
+	uint8_t pin;
+};
+
+struct ExpanderChannel
+{
+	size_t expanderIndex;
+	size_t channelNumber;
+};
+
+// Expander pins of the input and output channels, read from a text file:
+//     input 0x20:5 0x21:3 ...
+//     output 0x24:* ...
+// Every ADDRESS:PIN adds the next channel of the direction, ADDRESS:* adds pins 0..7.
+// A pin maps to one channel and an expander to one direction, repeated pins and pins of
+// an expander of the other direction are logged and skipped.
+// scan() probes the PCF8574 (0x20..0x27) and PCF8574A (0x38..0x3F) addresses and reports 
+// the expanders the map does not match
+class ExpanderMap
+{
+public:
+	static const size_t maxChannelCount = 128;
+	static const size_t maxExpanderCount = 16;
+	
+	void setLogger(ILogger* value_p) { _logger.setLogger(value_p); }
+	
+	void setFilename(String value) { _filename = value; }
+	void setFileSystem(FS* value_p) { _fileSystem_p = value_p; }
+	
+	bool read();
+	void scan();
+	
+	bool isPresent(uint8_t address) const;
+	
+	const std::vector<ExpanderPin>& getInputPins() const { return _inputPins; }
+	const std::vector<ExpanderPin>& getOutputPins() const { return _outputPins; }
+	
+	static bool isExpanderAddress(uint8_t address);
+	
+	// Numbers the expanders of the pins in order of appearance
+	static bool assignExpanders(const std::vector<ExpanderPin>& pins, 
+		uint8_t* addresses_out, size_t& expanderCount_out, std::vector<ExpanderChannel>& channels_out);
+	
+private:
+	bool parseLine(const std::string& line);
+	bool parsePins(const std::string& word, bool isOutput);
+	
+	void writeSkippedPinToLog(uint8_t address, uint8_t pin, const char* reason);
+	
+	void writeInvalidLineToLog(const std::string& s);
+	
+	LoggerHelper _logger;
+	
+	String _filename;
+	FS* _fileSystem_p = nullptr;
+	
+	std::vector<ExpanderPin> _inputPins;
+	std::vector<ExpanderPin> _outputPins;
+	
+	// Bit per address as in the presence mask: the addresses of every direction and
+	// the pins mapped so far
+	static const size_t _addressCount = 16;
+	
+	uint16_t _inputAddressMask = 0;
+	uint16_t _outputAddressMask = 0;
+	uint8_t _usedPinMasks[_addressCount];
+	
+	uint16_t _presentMask = 0;
+};
@@ -0,0 +1,76 @@
+#include <Arduino.h>
+
+#include "gpio_interrupt_source.h"
+
+GpioInterruptSource::GpioInterruptSource() :
+	IInterruptSource(),
+	_isPending(false),
+	_notifiedTask(nullptr)
+{
+}
+
+GpioInterruptSource::~GpioInterruptSource()
+{
+	end();
+}
+
+bool GpioInterruptSource::begin(int pin)
+{
+	end();
+	
+	if (pin < 0)
+	{
+		return false;
+	}
+	
+	_pin = pin;
+	
+	// Treat the line as fired, the state before attaching is unknown
+	_isPending = true;
+	
+	pinMode(_pin, INPUT_PULLUP);
+	attachInterruptArg(digitalPinToInterrupt(_pin), &GpioInterruptSource::onInterrupt, this, FALLING);
+	
+	return true;
+}
+
+void GpioInterruptSource::end()
+{
+	if (_pin < 0)
+	{
+		return;
+	}
+	
+	detachInterrupt(digitalPinToInterrupt(_pin));
+	_pin = -1;
+}
+
+bool GpioInterruptSource::takePending()
+{
+	const auto result = _isPending.exchange(false);
+	return result;
+}
+
+// Runs with the flash cache off during SPIFFS writes: everything it calls must be in IRAM
+// or inlined, SpscQueue::push() is forced inline
+void IRAM_ATTR GpioInterruptSource::onInterrupt(void* arg_p)
+{
+	auto self_p = static_cast<GpioInterruptSource*>(arg_p);
+	
+	self_p->_edgeTimes_usec.push(micros());
+	self_p->_isPending = true;
+	
+	const TaskHandle_t task = self_p->_notifiedTask;
+	if (task == nullptr)
+	{
+		return;
+	}
+	
+	BaseType_t isWoken = pdFALSE;
+	vTaskNotifyGiveFromISR(task, &isWoken);
+	
+	if (isWoken == pdTRUE)
+	{
+		portYIELD_FROM_ISR();
+	}
+}
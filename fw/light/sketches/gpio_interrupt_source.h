@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <atomic>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "spsc_queue.h"
+#include "types.h"
+
+// Falling edge interrupt on a GPIO, e.g. the open-drain INT output of a PCF8574.
+// Every edge queues its micros() time and notifies the task set to read the edge times
+class GpioInterruptSource : public IInterruptSource
+{
+public:
+	static const size_t maxEdgeTimeCount = 32;
+	
+	GpioInterruptSource();
+	~GpioInterruptSource();
+	
+	bool begin(int pin);
+	void end();
+	
+	// The only task to call takeEdgeTime_usec()
+	void setNotifiedTask(TaskHandle_t value) { _notifiedTask = value; }
+	
+	bool takePending() override;
+	bool takeEdgeTime_usec(uint32_t& time_usec_out) override { return _edgeTimes_usec.pop(time_usec_out); }
+	
+private:
+	static void onInterrupt(void* arg_p);
+	
+	int _pin = -1;
+	std::atomic<bool> _isPending;
+	
+	std::atomic<TaskHandle_t> _notifiedTask;
+	
+	// With a full queue the newer edges are lost, the reader wants the earliest one anyway
+	SpscQueue<uint32_t, maxEdgeTimeCount> _edgeTimes_usec;
+};
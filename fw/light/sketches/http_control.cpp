@@ -1,10 +1,13 @@
 #include <cassert>
 
 #include "http_control.h"
+#include "tick_profiler.h"
+#include "input_capture.h"
 
 #define HTTP_OK 200
 #define HTTP_BAD_REQUEST 400
 #define HTTP_INTERNAL_SERVER_ERROR 500
+#define HTTP_SERVICE_UNAVAILABLE 503
 
 bool HttpControl::getStateList(const std::vector<std::string>& names, std::function<DiscreteState(const std::string* name_p)> stateGetter, String& result_out) const
 {
@@ -216,6 +219,263 @@ void HttpControl::outputs_local_off(WebServer& srv)
 	srv.send(HTTP_OK, "text/json", "");
 }
 
+void HttpControl::groups_state_get(WebServer& srv) const
+{
+	assert(_lightController_p != nullptr);
+	
+	_channelNames.clear();
+	
+	_lightController_p->getOutputGroupNames(
+		[this](const std::string* name_p)
+		{
+			this->_channelNames.push_back(*name_p);
+		}
+	);
+	
+	_buf = "";
+	auto ok = getStateList(
+		_channelNames, 
+		[this](const std::string* name_p)
+		{
+			const auto result = this->_lightController_p->getOutputGroupState(*name_p);
+			return result;
+		},
+		_buf);
+	
+	if (!ok)
+	{
+		_logger.error("HttpControl: out of memory", ILogger::ErrorSeverity::error);
+		srv.send(HTTP_INTERNAL_SERVER_ERROR, "text/plain", "Out of memory");
+		return;
+	}
+	
+	srv.send(HTTP_OK, "text/json", _buf);
+}
+
+void HttpControl::groups_state_set(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	const auto& groupName = std::string(srv.arg("group").c_str());
+	if (groupName.empty())
+	{
+		_logger.error("HttpControl set group state failed: no group specified", ILogger::ErrorSeverity::warning);
+		srv.send(HTTP_BAD_REQUEST, "text/plain", "No group specified");
+		
+		return;
+	}
+	
+	if (!_lightController_p->isOutputGroupExists(groupName))
+	{
+		_logger.error("HttpControl set group state failed: invalid group specified", ILogger::ErrorSeverity::warning);
+		srv.send(HTTP_BAD_REQUEST, "text/plain", "Invalid group specified");
+		
+		return;
+	}
+	
+	auto sGroupState = srv.arg("state-on");
+	sGroupState.toLowerCase();
+	
+	auto groupState = DiscreteState::unknown;
+	
+	if (sGroupState == "true")
+	{
+		groupState = DiscreteState::on;
+	}
+	else if (sGroupState == "false")
+	{
+		groupState = DiscreteState::off;
+	}
+	
+	if (groupState == DiscreteState::unknown)
+	{
+		_logger.error("HttpControl set group state failed: state is empty or invalid", ILogger::ErrorSeverity::warning);
+		srv.send(HTTP_BAD_REQUEST, "text/plain", "state-on is empty or invalid");
+		
+		return;
+	}
+	
+	const auto ok = _lightController_p->setOutputGroupState(groupName, groupState);
+	if (!ok)
+	{
+		_logger.error("HttpControl set group state failed", ILogger::ErrorSeverity::error);
+		srv.send(HTTP_INTERNAL_SERVER_ERROR, "text/plain", "");
+		
+		return;
+	}
+	
+	{
+		LogInfo msg(_logger);
+		
+		msg.addText("HTTP API group state set request. ");
+		msg.addText("Group: " + groupName);
+		msg.addText(", state: ");
+		msg.addText(groupState == DiscreteState::on ? "on" : "off");
+	}
+	
+	srv.send(HTTP_OK, "text/json", "");
+}
+
+void HttpControl::rules_reload(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	const auto result = _lightController_p->reloadRules();
+	
+	switch (result)
+	{
+		case RulesReloadResult::success:
+			_logger.info("HTTP API rules reload request. ");
+			srv.send(HTTP_OK, "text/json", "");
+			break;
+		
+		case RulesReloadResult::busy:
+			srv.send(HTTP_SERVICE_UNAVAILABLE, "text/plain", "Previous reload is not applied yet");
+			break;
+		
+		case RulesReloadResult::invalidRules:
+			srv.send(HTTP_BAD_REQUEST, "text/plain", "Invalid rules, see the log. The previous rules are running");
+			break;
+		
+		default:
+			srv.send(HTTP_INTERNAL_SERVER_ERROR, "text/plain", "Failed to read the rules");
+	}
+}
+
+void HttpControl::profile_get(WebServer& srv) const
+{
+	assert(_lightController_p != nullptr);
+	
+	const auto& profiler = _lightController_p->getProfiler();
+	
+	auto ok = true;
+	_buf = "";
+	
+	ok &= _buf.concat("{\n\t\"unit\": \"us\",\n");
+	ok &= _buf.concat("\t\"histogram-base\": 2,\n");
+	ok &= _buf.concat("\t\"stages\": [\n");
+	
+	for (size_t i = 0; i < TickProfiler::stageCount; ++i)
+	{
+		const auto stage = static_cast<TickProfiler::Stage>(i);
+		const auto& stats = profiler.getStats(stage);
+		
+		if (i > 0)
+		{
+			ok &= _buf.concat(",\n");
+		}
+		
+		ok &= _buf.concat("\t\t{ \"name\": \"");
+		ok &= _buf.concat(TickProfiler::getStageName(stage));
+		ok &= _buf.concat("\", \"count\": ");
+		ok &= _buf.concat(stats.count);
+		ok &= _buf.concat(", \"min\": ");
+		ok &= _buf.concat((stats.count > 0) ? stats.min_usec : 0);
+		ok &= _buf.concat(", \"max\": ");
+		ok &= _buf.concat(stats.max_usec);
+		ok &= _buf.concat(", \"mean\": ");
+		ok &= _buf.concat((stats.count > 0) ? static_cast<uint32_t>(stats.total_usec / stats.count) : 0);
+		ok &= _buf.concat(", \"histogram\": [");
+		
+		for (size_t bucket = 0; bucket < TickProfiler::bucketCount; ++bucket)
+		{
+			if (bucket > 0)
+			{
+				ok &= _buf.concat(", ");
+			}
+			
+			ok &= _buf.concat(stats.buckets[bucket]);
+		}
+		
+		ok &= _buf.concat("] }");
+	}
+	
+	ok &= _buf.concat("\n\t]\n}");
+	
+	if (!ok)
+	{
+		_logger.error("HttpControl: out of memory", ILogger::ErrorSeverity::error);
+		srv.send(HTTP_INTERNAL_SERVER_ERROR, "text/plain", "Out of memory");
+		return;
+	}
+	
+	srv.send(HTTP_OK, "text/json", _buf);
+}
+
+void HttpControl::profile_reset(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	_lightController_p->resetProfiler();
+	
+	_logger.info("HTTP API profile reset request. ");
+	
+	srv.send(HTTP_OK, "text/json", "");
+}
+
+void HttpControl::capture_start(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	if (!_lightController_p->startInputCapture())
+	{
+		_logger.error("HttpControl: no memory for the input capture", ILogger::ErrorSeverity::error);
+		srv.send(HTTP_INTERNAL_SERVER_ERROR, "text/plain", "Out of memory");
+		return;
+	}
+	
+	_logger.info("HTTP API input capture start request. ");
+	
+	srv.send(HTTP_OK, "text/json", "");
+}
+
+void HttpControl::capture_stop(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	if (!_lightController_p->stopInputCapture())
+	{
+		srv.send(HTTP_SERVICE_UNAVAILABLE, "text/plain", "Capture is still running");
+		return;
+	}
+	
+	_logger.info("HTTP API input capture stop request. ");
+	
+	srv.send(HTTP_OK, "text/json", "");
+}
+
+void HttpControl::capture_get(WebServer& srv)
+{
+	assert(_lightController_p != nullptr);
+	
+	if (!_lightController_p->stopInputCapture())
+	{
+		srv.send(HTTP_SERVICE_UNAVAILABLE, "text/plain", "Capture is still running");
+		return;
+	}
+	
+	const auto& capture = _lightController_p->getInputCapture();
+	const auto size = capture.getFileSize();
+	
+	srv.setContentLength(size);
+	srv.sendHeader("Content-Disposition", "attachment; filename=\"input_capture.bin\"");
+	srv.send(HTTP_OK, "application/octet-stream", "");
+	
+	uint8_t chunk[512];
+	
+	for (size_t offset = 0; offset < size; )
+	{
+		const auto count = capture.readFile(offset, chunk, sizeof(chunk));
+		if (count == 0)
+		{
+			break;
+		}
+		
+		srv.sendContent(reinterpret_cast<const char*>(chunk), count);
+		offset += count;
+	}
+}
+
 HttpControl::HttpControl()
 {
 	_buf.reserve(1024);
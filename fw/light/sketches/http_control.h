@@ -29,6 +29,21 @@ public:
 	
 	void outputs_local_off(WebServer& srv);
 	
+	void groups_state_get(WebServer& srv) const;
+	void groups_state_set(WebServer& srv);
+	
+	// Replaces the running rules with the ones of the rules file, without a restart
+	void rules_reload(WebServer& srv);
+	
+	void profile_get(WebServer& srv) const;
+	void profile_reset(WebServer& srv);
+	
+	void capture_start(WebServer& srv);
+	void capture_stop(WebServer& srv);
+	
+	// Stops the capture and sends it as a binary file
+	void capture_get(WebServer& srv);
+	
 private:
 	bool getStateList(const std::vector<std::string>& names, std::function<DiscreteState(const std::string* name_p)> stateGetter, String& result_out) const;
 		
@@ -0,0 +1,163 @@
+#include <Arduino.h>
+#include <Wire.h>
+
+#include "i2c_engine.h"
+
+bool I2cEngine::setSampledReads(IInterruptSource* source_p, const uint8_t* addresses, size_t count)
+{
+	if ((_task != nullptr) || (count > I2cSample::maxByteCount))
+	{
+		return false;
+	}
+	
+	_sampleSource_p = source_p;
+	_sampleAddressCount = count;
+	
+	for (size_t i = 0; i < count; ++i)
+	{
+		_sampleAddresses[i] = addresses[i];
+	}
+	
+	return true;
+}
+
+bool I2cEngine::start(int core, int priority)
+{
+	if (_task != nullptr)
+	{
+		return false;
+	}
+	
+	const auto result = xTaskCreatePinnedToCore(&I2cEngine::busTask, "i2c_bus", 4096, this, priority, &_task, core);
+	if (result != pdPASS)
+	{
+		_task = nullptr;
+		return false;
+	}
+	
+	return true;
+}
+
+bool I2cEngine::submit(const I2cTransaction& transaction)
+{
+	return _requests.push(transaction);
+}
+
+void I2cEngine::flush()
+{
+	if (_requests.empty())
+	{
+		return;
+	}
+	
+	if (_task == nullptr)
+	{
+		executePending();
+		return;
+	}
+	
+	xTaskNotifyGive(_task);
+}
+
+void I2cEngine::dispatchCompletions()
+{
+	I2cTransaction transaction;
+	while (_completions.pop(transaction))
+	{
+		if (transaction.callback != nullptr)
+		{
+			transaction.callback(transaction.context_p, transaction);
+		}
+	}
+}
+
+void I2cEngine::busTask(void* arg_p)
+{
+	auto engine_p = static_cast<I2cEngine*>(arg_p);
+	
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		
+		engine_p->readSamples();
+		engine_p->executePending();
+	}
+}
+
+void I2cEngine::executePending()
+{
+	I2cTransaction transaction;
+	while (_requests.pop(transaction))
+	{
+		// An interrupt does not wait for the rest of the batch
+		if (_task != nullptr)
+		{
+			readSamples();
+		}
+		
+		execute(transaction);
+		
+		// Cannot overflow: both queues have the same capacity and the submitter keeps 
+		// at most one transaction of a kind in flight per expander
+		_completions.push(transaction);
+	}
+}
+
+void I2cEngine::readSamples()
+{
+	uint32_t time_usec;
+	if ((_sampleSource_p == nullptr) || !_sampleSource_p->takeEdgeTime_usec(time_usec))
+	{
+		return;
+	}
+	
+	// The read sees the changes of all the interrupts so far, they get the earliest time
+	uint32_t laterTime_usec;
+	while (_sampleSource_p->takeEdgeTime_usec(laterTime_usec))
+	{
+	}
+	
+	I2cSample sample;
+	
+	sample.time_usec = time_usec;
+	sample.okMask = 0;
+	
+	for (size_t i = 0; i < _sampleAddressCount; ++i)
+	{
+		I2cTransaction transaction;
+		
+		transaction.kind = I2cTransaction::Kind::read;
+		transaction.address = _sampleAddresses[i];
+		
+		execute(transaction);
+		
+		sample.bytes[i] = transaction.data;
+		if (transaction.ok)
+		{
+			sample.okMask |= static_cast<uint16_t>(1u << i);
+		}
+	}
+	
+	_samples.push(sample);
+}
+
+void I2cEngine::execute(I2cTransaction& transaction)
+{
+	switch (transaction.kind)
+	{
+		case I2cTransaction::Kind::read:
+			transaction.ok = Wire.requestFrom(transaction.address, (uint8_t) 1) == (uint8_t) 1;
+			transaction.data = transaction.ok ? Wire.read() : 0xFF;
+			break;
+		
+		case I2cTransaction::Kind::write:
+			Wire.beginTransmission(transaction.address);
+			transaction.ok = Wire.write(transaction.data) == 1;
+			transaction.ok = (Wire.endTransmission(true) == (uint8_t) 0) && transaction.ok;
+			break;
+		
+		default:
+			transaction.ok = false;
+			break;
+	}
+}
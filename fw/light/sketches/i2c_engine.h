@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include "spsc_queue.h"
+#include "types.h"
+
+struct I2cTransaction
+{
+	enum class Kind
+	{
+		read,
+		write
+	};
+	
+	using Callback = void (*)(void* context_p, const I2cTransaction& transaction);
+	
+	Kind kind;
+	uint8_t address;
+	uint8_t data;		// Byte to write, or the byte read
+	bool ok;
+	
+	Callback callback;
+	void* context_p;
+};
+
+// Bytes of the sampled expanders read right after an interrupt
+struct I2cSample
+{
+	static const size_t maxByteCount = 16;
+	
+	uint32_t time_usec;		// Of the interrupt
+	uint16_t okMask;		// Bit per expander that answered
+	uint8_t bytes[maxByteCount];
+};
+
+// Runs single byte expander transactions back-to-back on the I2C bus.
+// One task submits transactions and calls flush() once per tick, the bus task then
+// executes the batch while the submitter goes on. Completion callbacks are called
+// by dispatchCompletions() in the submitter task, so they need no locking.
+// Without a started bus task flush() executes the batch in place.
+//
+// The bus task can also sample expanders on an interrupt: woken by it, the task reads
+// them before the next transaction of the batch, so the bytes are at most a transaction
+// and a read older than the interrupt time they are queued with.
+class I2cEngine
+{
+public:
+	static const size_t maxTransactionCount = 64;
+	static const size_t maxSampleCount = 32;
+	
+	// To be called before start(). The interrupt source has to wake the bus task
+	bool setSampledReads(IInterruptSource* source_p, const uint8_t* addresses, size_t count);
+	
+	bool start(int core, int priority);
+	bool isRunning() const { return _task != nullptr; }
+	TaskHandle_t getTask() const { return _task; }
+	
+	// Submitter side
+	bool submit(const I2cTransaction& transaction);
+	void flush();
+	void dispatchCompletions();
+	
+	// Oldest sample not taken yet. With a full queue the newer samples are lost,
+	// the next one still has the bytes as of its read
+	bool takeSample(I2cSample& sample_out) { return _samples.pop(sample_out); }
+	
+private:
+	static void busTask(void* arg_p);
+	
+	void executePending();
+	void readSamples();
+	static void execute(I2cTransaction& transaction);
+	
+	TaskHandle_t _task = nullptr;
+	
+	SpscQueue<I2cTransaction, maxTransactionCount> _requests;
+	SpscQueue<I2cTransaction, maxTransactionCount> _completions;
+	
+	IInterruptSource* _sampleSource_p = nullptr;
+	uint8_t _sampleAddresses[I2cSample::maxByteCount];
+	size_t _sampleAddressCount = 0;
+	
+	SpscQueue<I2cSample, maxSampleCount> _samples;
+};
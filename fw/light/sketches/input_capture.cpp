@@ -0,0 +1,174 @@
+#include <cstring>
+#include <algorithm>
+
+#include "input_capture.h"
+
+InputCapture::InputCapture() :
+    _request(Request::none),
+    _isRunning(false)
+{
+    setLayout(0, 0);
+}
+
+void InputCapture::setBuffer(uint8_t* buffer_p, size_t size)
+{
+    _buffer_p = buffer_p;
+    _bufferSize = (buffer_p != nullptr) ? size : 0;
+
+    _capacity = _bufferSize / _recordSize;
+    _nextIndex = 0;
+    _recordCount = 0;
+    _lostRecordCount = 0;
+
+    updateHeaderCounts();
+}
+
+bool InputCapture::setLayout(size_t expanderCount, size_t channelCount)
+{
+    if ((expanderCount > maxExpanderCount) || (channelCount > UINT16_MAX))
+    {
+        return false;
+    }
+
+    _expanderCount = expanderCount;
+    _recordSize = recordHeaderSize + expanderCount;
+
+    _header.assign(headerSize + 2 * channelCount, 0);
+
+    _header[0] = 'L';
+    _header[1] = 'C';
+    _header[2] = 'A';
+    _header[3] = 'P';
+    _header[4] = formatVersion;
+    _header[5] = static_cast<uint8_t>(expanderCount);
+    writeUint16(&_header[6], static_cast<uint16_t>(channelCount));
+
+    // The records of the previous layout do not fit the new one
+    setBuffer(_buffer_p, _bufferSize);
+
+    return true;
+}
+
+void InputCapture::setChannelPin(size_t channelIndex, uint8_t expanderIndex, uint8_t pin)
+{
+    const auto pos = headerSize + 2 * channelIndex;
+    if (pos + 1 >= _header.size())
+    {
+        return;
+    }
+
+    _header[pos] = expanderIndex;
+    _header[pos + 1] = pin;
+}
+
+void InputCapture::applyRequest()
+{
+    const auto request = _request.exchange(Request::none);
+
+    switch (request)
+    {
+        case Request::start:
+            _nextIndex = 0;
+            _recordCount = 0;
+            _lostRecordCount = 0;
+
+            _isRunning.store(_capacity > 0);
+            break;
+
+        case Request::stop:
+            if (_isRunning.load(std::memory_order_relaxed))
+            {
+                updateHeaderCounts();
+
+                // Publishes the records to the reading task
+                _isRunning.store(false);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void InputCapture::record(int elapsed_msec, const uint8_t* bytes_p, uint16_t connectedMask)
+{
+    const auto elapsed = static_cast<uint16_t>(std::min(std::max(elapsed_msec, 0), static_cast<int>(UINT16_MAX)));
+
+    auto record_p = _buffer_p + _nextIndex * _recordSize;
+
+    writeUint16(record_p, elapsed);
+    writeUint16(record_p + 2, connectedMask);
+    std::memcpy(record_p + recordHeaderSize, bytes_p, _expanderCount);
+
+    if (++_nextIndex == _capacity)
+    {
+        _nextIndex = 0;
+    }
+
+    if (_recordCount < _capacity)
+    {
+        ++_recordCount;
+    }
+    else
+    {
+        ++_lostRecordCount;
+    }
+}
+
+size_t InputCapture::getFileSize() const
+{
+    return _header.size() + _recordCount * _recordSize;
+}
+
+size_t InputCapture::readFile(size_t offset, uint8_t* buffer_p, size_t size) const
+{
+    size_t copied = 0;
+
+    if (offset < _header.size())
+    {
+        const auto count = std::min(size, _header.size() - offset);
+        std::memcpy(buffer_p, _header.data() + offset, count);
+
+        copied += count;
+        offset += count;
+    }
+
+    const auto dataSize = _recordCount * _recordSize;
+
+    // The oldest record follows the newest one once the ring is full
+    const auto oldestPos = ((_recordCount < _capacity) ? 0 : _nextIndex) * _recordSize;
+    const auto ringSize = _capacity * _recordSize;
+
+    while ((copied < size) && (offset < _header.size() + dataSize))
+    {
+        const auto dataOffset = offset - _header.size();
+        const auto pos = (oldestPos + dataOffset) % ringSize;
+
+        // Up to the end of the data or of the ring
+        const auto count = std::min(std::min(size - copied, dataSize - dataOffset), ringSize - pos);
+        std::memcpy(buffer_p + copied, _buffer_p + pos, count);
+
+        copied += count;
+        offset += count;
+    }
+
+    return copied;
+}
+
+void InputCapture::updateHeaderCounts()
+{
+    writeUint32(&_header[8], static_cast<uint32_t>(_recordCount));
+    writeUint32(&_header[12], _lostRecordCount);
+}
+
+void InputCapture::writeUint16(uint8_t* dest_p, uint16_t value)
+{
+    dest_p[0] = static_cast<uint8_t>(value);
+    dest_p[1] = static_cast<uint8_t>(value >> 8);
+}
+
+void InputCapture::writeUint32(uint8_t* dest_p, uint32_t value)
+{
+    writeUint16(dest_p, static_cast<uint16_t>(value));
+    writeUint16(dest_p + 2, static_cast<uint16_t>(value >> 16));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <atomic>
+#include <vector>
+
+// Records the raw expander bytes the control task reads every tick into a ring buffer,
+// so the input filters can be tuned on a host (tools/light_replay --capture).
+// The control task records; other tasks start and stop the capture and read it once
+// it has stopped. Recording a tick copies a few bytes, nothing is allocated.
+//
+// File, little-endian:
+//     header    "LCAP", u8 version, u8 expander count, u16 channel count,
+//               u32 record count, u32 records lost to the ring wrapping around
+//     channels  u8 expander index, u8 pin, for every input channel
+//     records   u16 elapsed msec, u16 connected expanders mask, a byte per expander,
+//               oldest first
+class InputCapture
+{
+public:
+    static const uint8_t formatVersion = 1;
+    static const size_t maxExpanderCount = 16;
+    static const size_t headerSize = 16;
+    static const size_t recordHeaderSize = 4;
+
+    InputCapture();
+
+    // To be set while stopped, the capture does not own the buffer
+    void setBuffer(uint8_t* buffer_p, size_t size);
+    bool hasBuffer() const { return _buffer_p != nullptr; }
+
+    // Channel pins written to the file, to be set while stopped
+    bool setLayout(size_t expanderCount, size_t channelCount);
+    void setChannelPin(size_t channelIndex, uint8_t expanderIndex, uint8_t pin);
+
+    size_t getExpanderCount() const { return _expanderCount; }
+
+    // Safe to call from any task, the control task applies them on its next update().
+    // Starting clears the previous capture
+    void requestStart() { _request.store(Request::start); }
+    void requestStop() { _request.store(Request::stop); }
+
+    // Stopped with no start pending, the capture may be read
+    bool isStopped() const { return !_isRunning.load() && (_request.load() != Request::start); }
+
+    // Control task, applies the requests and returns true if the tick is to be recorded
+    bool update()
+    {
+        if (_request.load(std::memory_order_relaxed) != Request::none)
+        {
+            applyRequest();
+        }
+
+        return _isRunning.load(std::memory_order_relaxed);
+    }
+
+    // Control task, after update() returned true. bytes_p has a byte per expander
+    void record(int elapsed_msec, const uint8_t* bytes_p, uint16_t connectedMask);
+
+    // Of a stopped capture
+    size_t getRecordCount() const { return _recordCount; }
+    size_t getFileSize() const;
+
+    // Copies a part of the file, returns the number of bytes copied
+    size_t readFile(size_t offset, uint8_t* buffer_p, size_t size) const;
+
+private:
+    enum class Request : uint8_t
+    {
+        none,
+        start,
+        stop
+    };
+
+    void applyRequest();
+    void updateHeaderCounts();
+
+    static void writeUint16(uint8_t* dest_p, uint16_t value);
+    static void writeUint32(uint8_t* dest_p, uint32_t value);
+
+    uint8_t* _buffer_p = nullptr;
+    size_t _bufferSize = 0;
+
+    size_t _expanderCount = 0;
+    size_t _recordSize = recordHeaderSize;
+    size_t _capacity = 0;
+
+    std::vector<uint8_t> _header;
+
+    std::atomic<Request> _request;
+    std::atomic<bool> _isRunning;
+
+    // Control task
+    size_t _nextIndex = 0;
+    size_t _recordCount = 0;
+    uint32_t _lostRecordCount = 0;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <atomic>
+
+#include "types.h"
+#include "spsc_queue.h"
+
+struct InputEventRecord
+{
+    uint32_t timestamp_msec;    // LightController time, advanced by the elapsed time of every tick
+    size_t channelIndex;
+    EventType event;
+};
+
+struct OutputChangeRecord
+{
+    uint32_t timestamp_msec;    // As of InputEventRecord
+    size_t channelIndex;
+    DiscreteState state;
+};
+
+// Records of the control task for a single consumer, which drains them at its own pace.
+// The control task never waits for the consumer: records that do not fit are dropped and counted.
+template <typename T, size_t Capacity>
+class ControlTaskQueue
+{
+public:
+    static const size_t capacity = Capacity;
+
+    ControlTaskQueue() :
+        _droppedCount(0)
+    {
+    }
+
+    // Producer side
+    bool push(const T& record)
+    {
+        if (_queue.push(record))
+        {
+            return true;
+        }
+
+        _droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    // Consumer side
+    bool pop(T& record_out) { return _queue.pop(record_out); }
+
+    size_t size() const { return _queue.size(); }
+    bool empty() const { return _queue.empty(); }
+
+    // Total number of records dropped because the queue was full
+    uint32_t getDroppedCount() const { return _droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    SpscQueue<T, Capacity> _queue;
+    std::atomic<uint32_t> _droppedCount;
+};
+
+class InputEventQueue : public ControlTaskQueue<InputEventRecord, 64>
+{
+};
+
+class OutputChangeQueue : public ControlTaskQueue<OutputChangeRecord, 64>
+{
+};
@@ -0,0 +1,437 @@
+#include "input_filter_bank.h"
+
+InputFilterBank::InputFilterBank()
+{
+    setNominalFrequency_hz(_nominalFrequency_hz);
+
+    for (size_t i = 0; i < maxChannelCount; ++i)
+    {
+        _debounces_msec[i] = static_cast<uint16_t>(InputFilterSettings().debounce_msec);
+    }
+
+    setKind(InputFilterKind::acWindow);
+}
+
+bool InputFilterBank::setChannelCount(size_t value)
+{
+    if (value > maxChannelCount)
+    {
+        return false;
+    }
+
+    _channelCount = value;
+    _wordCount = BitUtils::wordCount(value);
+    reset();
+
+    return true;
+}
+
+void InputFilterBank::setKind(InputFilterKind value)
+{
+    for (size_t kind = 0; kind < _kindCount; ++kind)
+    {
+        const auto word = (kind == static_cast<size_t>(value)) ? ~static_cast<Word>(0) : 0;
+
+        for (size_t w = 0; w < maxWordCount; ++w)
+        {
+            _kindMasks[kind][w] = word;
+        }
+    }
+
+    reset();
+}
+
+bool InputFilterBank::setChannelSettings(size_t channelIndex, const InputFilterSettings& value)
+{
+    const auto kindIndex = static_cast<size_t>(value.kind);
+
+    if ((channelIndex >= maxChannelCount) || (kindIndex >= _kindCount) ||
+        (value.debounce_msec < 0) || (value.debounce_msec > UINT16_MAX))
+    {
+        return false;
+    }
+
+    for (size_t kind = 0; kind < _kindCount; ++kind)
+    {
+        BitUtils::assign(_kindMasks[kind], channelIndex, kind == kindIndex);
+    }
+
+    _debounces_msec[channelIndex] = static_cast<uint16_t>(value.debounce_msec);
+    reset();
+
+    return true;
+}
+
+InputFilterKind InputFilterBank::getChannelKind(size_t channelIndex) const
+{
+    for (size_t kind = 0; kind < _kindCount; ++kind)
+    {
+        if (BitUtils::isSet(_kindMasks[kind], channelIndex))
+        {
+            return static_cast<InputFilterKind>(kind);
+        }
+    }
+
+    return InputFilterKind::acWindow;
+}
+
+bool InputFilterBank::hasKind(InputFilterKind value) const
+{
+    const auto mask_p = kindMask(value);
+
+    for (size_t w = 0; w < _wordCount; ++w)
+    {
+        if ((mask_p[w] & BitUtils::validMask(_channelCount, w)) != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void InputFilterBank::setNominalFrequency_hz(int value)
+{
+    _nominalFrequency_hz = value;
+
+    const uint32_t halfPeriod_usec = 500000 / value;
+
+    _minInterval_usec = halfPeriod_usec / 4;
+    _maxInterval_usec = halfPeriod_usec * 3;
+
+    // The deadlines depend on it
+    _nextWindowEnd_msec = _clock_msec;
+    _nextTimeout_msec = _clock_msec;
+}
+
+void InputFilterBank::setPeriod_msec(int value)
+{
+    _period_msec = value;
+    _nextWindowEnd_msec = _clock_msec;
+}
+
+void InputFilterBank::reset()
+{
+    _clock_msec = 0;
+    _nextWindowEnd_msec = 0;
+    _nextTimeout_msec = 0;
+
+    for (size_t i = 0; i < maxChannelCount; ++i)
+    {
+        _edgeCounts[i] = 0;
+        _windowStarts_msec[i] = 0;
+        _lastAcceptedEdges_msec[i] = 0;
+        _lastEdgeTimestamps_usec[i] = 0;
+        _lastRawChanges_msec[i] = 0;
+    }
+
+    for (size_t i = 0; i < maxWordCount; ++i)
+    {
+        _lastKnown[i] = 0;
+        _lastOn[i] = 0;
+        _stableKnown[i] = 0;
+        _stableOn[i] = 0;
+        _lastCounting[i] = 0;
+        _reportedKnown[i] = 0;
+        _reportedOn[i] = 0;
+
+        _isTimedOut[i] = 0;
+        _hasLastEdgeTimestamp[i] = 0;
+        _isTimestamped[i] = 0;
+
+        _changed[i] = 0;
+    }
+
+    _hasChanges = false;
+}
+
+DiscreteState InputFilterBank::getState(size_t channelIndex) const
+{
+    if (!BitUtils::isSet(_stableKnown, channelIndex))
+    {
+        return DiscreteState::unknown;
+    }
+
+    return BitUtils::isSet(_stableOn, channelIndex) ? DiscreteState::on : DiscreteState::off;
+}
+
+void InputFilterBank::addEdge(size_t channelIndex, uint32_t timestamp_usec)
+{
+    if ((channelIndex >= _channelCount) || !BitUtils::isSet(kindMask(InputFilterKind::acEdge), channelIndex))
+    {
+        return;
+    }
+
+    BitUtils::assign(_isTimestamped, channelIndex, true);
+
+    if (!BitUtils::isSet(_hasLastEdgeTimestamp, channelIndex))
+    {
+        BitUtils::assign(_hasLastEdgeTimestamp, channelIndex, true);
+        _lastEdgeTimestamps_usec[channelIndex] = timestamp_usec;
+
+        acceptEdge(channelIndex, _maxInterval_usec + 1);
+        return;
+    }
+
+    const auto interval_usec = timestamp_usec - _lastEdgeTimestamps_usec[channelIndex];
+    if ((_edgeCounts[channelIndex] > 0) && (interval_usec < _minInterval_usec))
+    {
+        return;
+    }
+
+    _lastEdgeTimestamps_usec[channelIndex] = timestamp_usec;
+    acceptEdge(channelIndex, interval_usec);
+}
+
+void InputFilterBank::update(const Word* onWords, const Word* knownWords, int timeElapsed_msec)
+{
+    _clock_msec += static_cast<uint32_t>(timeElapsed_msec);
+
+    // Looking for the timeouts before the raw edges: a channel whose raw edge comes
+    // after the timeout starts counting again
+    if (isReached(_nextTimeout_msec))
+    {
+        findTimeouts();
+    }
+
+    for (size_t w = 0; w < _wordCount; ++w)
+    {
+        const auto knownWord = knownWords[w] & BitUtils::validMask(_channelCount, w);
+        const auto onWord = onWords[w] & knownWord;
+
+        const auto rawMask = kindMask(InputFilterKind::raw)[w];
+
+        _stableKnown[w] = (_stableKnown[w] & ~rawMask) | (knownWord & rawMask);
+        _stableOn[w] = (_stableOn[w] & ~rawMask) | (onWord & rawMask);
+
+        updateWindow(w, onWord, knownWord, timeElapsed_msec);
+        updateEdge(w, onWord, knownWord);
+        updateDebounce(w, onWord, knownWord);
+
+        // Unknown raw states keep the last known one, except for acWindow
+        const auto windowMask = kindMask(InputFilterKind::acWindow)[w];
+
+        _lastKnown[w] = (knownWord & windowMask) | ((_lastKnown[w] | knownWord) & ~windowMask);
+        _lastOn[w] = (onWord & windowMask) | (((_lastOn[w] & ~knownWord) | onWord) & ~windowMask);
+    }
+
+    if (isReached(_nextWindowEnd_msec))
+    {
+        finishWindows();
+    }
+
+    _hasChanges = false;
+
+    for (size_t w = 0; w < _wordCount; ++w)
+    {
+        // Timed out acEdge channels stay off until the next edge
+        _stableKnown[w] |= _isTimedOut[w];
+        _stableOn[w] &= ~_isTimedOut[w];
+
+        // acWindow channels that were not counting this tick have no state
+        const auto notCounting = kindMask(InputFilterKind::acWindow)[w] & ~_lastCounting[w];
+
+        _stableKnown[w] &= ~notCounting;
+        _stableOn[w] &= ~notCounting;
+
+        const auto changed = (_stableKnown[w] ^ _reportedKnown[w]) | (_stableOn[w] ^ _reportedOn[w]);
+
+        _reportedKnown[w] = _stableKnown[w];
+        _reportedOn[w] = _stableOn[w];
+
+        _changed[w] = changed;
+        _hasChanges |= changed != 0;
+    }
+}
+
+void InputFilterBank::updateWindow(size_t wordIndex, Word onWord, Word knownWord, int timeElapsed_msec)
+{
+    const auto channels = kindMask(InputFilterKind::acWindow)[wordIndex] & BitUtils::validMask(_channelCount, wordIndex);
+    if (channels == 0)
+    {
+        return;
+    }
+
+    const auto first = wordIndex * BitUtils::bitsPerWord;
+
+    // A channel counts from the update after its raw state became known
+    const auto counting = _lastKnown[wordIndex] & channels;
+    const auto edges = counting & knownWord & (onWord ^ _lastOn[wordIndex]);
+
+    for (auto paused = channels & ~counting; paused != 0; paused = BitUtils::clearLowestSetBit(paused))
+    {
+        _windowStarts_msec[first + BitUtils::lowestSetBit(paused)] += static_cast<uint32_t>(timeElapsed_msec);
+    }
+
+    for (auto e = edges; e != 0; e = BitUtils::clearLowestSetBit(e))
+    {
+        ++_edgeCounts[first + BitUtils::lowestSetBit(e)];
+    }
+
+    _lastCounting[wordIndex] = counting;
+}
+
+void InputFilterBank::updateEdge(size_t wordIndex, Word onWord, Word knownWord)
+{
+    const auto channels = kindMask(InputFilterKind::acEdge)[wordIndex];
+    const auto first = wordIndex * BitUtils::bitsPerWord;
+
+    // Raw edges have tick resolution only and are not used once the device timestamps the channel
+    const auto edges = channels & _lastKnown[wordIndex] & knownWord & (onWord ^ _lastOn[wordIndex]) & ~_isTimestamped[wordIndex];
+
+    for (auto e = edges; e != 0; e = BitUtils::clearLowestSetBit(e))
+    {
+        const auto i = first + BitUtils::lowestSetBit(e);
+
+        const auto interval_usec = BitUtils::isSet(_isTimedOut, i)
+            ? _maxInterval_usec + 1
+            : (_clock_msec - _lastAcceptedEdges_msec[i]) * 1000;
+
+        acceptEdge(i, interval_usec);
+    }
+}
+
+void InputFilterBank::updateDebounce(size_t wordIndex, Word onWord, Word knownWord)
+{
+    const auto channels = kindMask(InputFilterKind::dcDebounce)[wordIndex] & knownWord;
+    if (channels == 0)
+    {
+        return;
+    }
+
+    const auto first = wordIndex * BitUtils::bitsPerWord;
+
+    // The first known raw state counts as a change
+    const auto rawChanges = channels & (~_lastKnown[wordIndex] | (onWord ^ _lastOn[wordIndex]));
+
+    for (auto c = rawChanges; c != 0; c = BitUtils::clearLowestSetBit(c))
+    {
+        _lastRawChanges_msec[first + BitUtils::lowestSetBit(c)] = _clock_msec;
+    }
+
+    // Only the channels whose raw state differs from the resulting one are waiting
+    const auto waiting = channels & (~_stableKnown[wordIndex] | (onWord ^ _stableOn[wordIndex]));
+
+    for (auto c = waiting; c != 0; c = BitUtils::clearLowestSetBit(c))
+    {
+        const auto bit = BitUtils::lowestSetBit(c);
+        const auto i = first + bit;
+
+        if (_clock_msec - _lastRawChanges_msec[i] >= _debounces_msec[i])
+        {
+            const auto mask = static_cast<Word>(1) << bit;
+
+            _stableKnown[wordIndex] |= mask;
+            _stableOn[wordIndex] = (_stableOn[wordIndex] & ~mask) | (onWord & mask);
+        }
+    }
+}
+
+void InputFilterBank::finishWindows()
+{
+    // Same decisions as InputFilterAc::estimateCurrentState() without the division:
+    // edges * 1000 / duration == 0, or > nominal edges per second * 3 / 4
+    const int32_t onThreshold = _nominalFrequency_hz * 2 * 3 / 4 + 1;
+
+    _nextWindowEnd_msec = _clock_msec + static_cast<uint32_t>(_period_msec);
+
+    for (size_t w = 0; w < _wordCount; ++w)
+    {
+        const auto first = w * BitUtils::bitsPerWord;
+
+        for (auto channels = kindMask(InputFilterKind::acWindow)[w] & BitUtils::validMask(_channelCount, w); channels != 0; channels = BitUtils::clearLowestSetBit(channels))
+        {
+            const auto bit = BitUtils::lowestSetBit(channels);
+            const auto i = first + bit;
+
+            const auto duration_msec = static_cast<int32_t>(_clock_msec - _windowStarts_msec[i]);
+
+            if (((_lastCounting[w] >> bit) & 1) && (duration_msec >= _period_msec))
+            {
+                const auto scaledEdgeCount = _edgeCounts[i] * 1000;
+                const auto mask = static_cast<Word>(1) << bit;
+
+                if (scaledEdgeCount < duration_msec)
+                {
+                    _stableKnown[w] |= mask;
+                    _stableOn[w] &= ~mask;
+                }
+                else if (scaledEdgeCount >= onThreshold * duration_msec)
+                {
+                    _stableKnown[w] |= mask;
+                    _stableOn[w] |= mask;
+                }
+
+                _edgeCounts[i] = 0;
+                _windowStarts_msec[i] = _clock_msec;
+            }
+
+            lowerDeadline(_nextWindowEnd_msec, _windowStarts_msec[i] + static_cast<uint32_t>(_period_msec));
+        }
+    }
+}
+
+void InputFilterBank::findTimeouts()
+{
+    // since last edge * 1000 > max interval, without the overflow
+    const auto timeout_msec = _maxInterval_usec / 1000;
+
+    _nextTimeout_msec = _clock_msec + timeout_msec + 1;
+
+    for (size_t w = 0; w < _wordCount; ++w)
+    {
+        const auto first = w * BitUtils::bitsPerWord;
+
+        for (auto channels = kindMask(InputFilterKind::acEdge)[w] & BitUtils::validMask(_channelCount, w) & ~_isTimedOut[w]; channels != 0; channels = BitUtils::clearLowestSetBit(channels))
+        {
+            const auto bit = BitUtils::lowestSetBit(channels);
+            const auto i = first + bit;
+
+            if (_clock_msec - _lastAcceptedEdges_msec[i] > timeout_msec)
+            {
+                _isTimedOut[w] |= static_cast<Word>(1) << bit;
+                _edgeCounts[i] = 0;
+                continue;
+            }
+
+            lowerDeadline(_nextTimeout_msec, _lastAcceptedEdges_msec[i] + timeout_msec + 1);
+        }
+    }
+}
+
+void InputFilterBank::acceptEdge(size_t channelIndex, uint32_t interval_usec)
+{
+    auto& edgeCount = _edgeCounts[channelIndex];
+
+    if (interval_usec > _maxInterval_usec)
+    {
+        edgeCount = 1;
+    }
+    else if (edgeCount < _edgesToTurnOn)
+    {
+        ++edgeCount;
+    }
+
+    BitUtils::assign(_isTimedOut, channelIndex, false);
+    _lastAcceptedEdges_msec[channelIndex] = _clock_msec;
+
+    // A deadline already reached means a full search on the next update anyway
+    if (!isReached(_nextTimeout_msec))
+    {
+        lowerDeadline(_nextTimeout_msec, _clock_msec + _maxInterval_usec / 1000 + 1);
+    }
+
+    if (edgeCount >= _edgesToTurnOn)
+    {
+        BitUtils::assign(_stableKnown, channelIndex, true);
+        BitUtils::assign(_stableOn, channelIndex, true);
+    }
+}
+
+void InputFilterBank::lowerDeadline(uint32_t& deadline_msec, uint32_t value_msec)
+{
+    if (static_cast<int32_t>(value_msec - deadline_msec) < 0)
+    {
+        deadline_msec = value_msec;
+    }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+
+#include "types.h"
+#include "bit_utils.h"
+
+// Input filters of all channels, updated for all channels at once from packed raw state
+// words. Every channel has its own kind, without a filter object per channel:
+// - acWindow, the edge counting window of InputFilterAc;
+// - acEdge, on after three edges no more than 1.5 mains periods apart and off when no
+//   edge came for that long, edges closer than a quarter half-cycle are bounce;
+// - dcDebounce, the raw state once it held for the debounce time;
+// - raw, the raw state.
+//
+// States are kept as bit words, so a tick costs a few word operations per 32 channels.
+// Per-channel counters are only touched on a raw edge, and the window and timeout
+// checks only run when the earliest deadline of the channels is reached.
+class InputFilterBank
+{
+public:
+    using Word = BitUtils::Word;
+
+    static const size_t maxChannelCount = 128;
+    static const size_t maxWordCount = maxChannelCount / BitUtils::bitsPerWord;
+
+    InputFilterBank();
+
+    size_t getChannelCount() const { return _channelCount; }
+    bool setChannelCount(size_t value);
+
+    // Kind of all channels, resets the filters
+    void setKind(InputFilterKind value);
+
+    // Kind and parameters of one channel, resets the filters
+    bool setChannelSettings(size_t channelIndex, const InputFilterSettings& value);
+
+    InputFilterKind getChannelKind(size_t channelIndex) const;
+    bool hasKind(InputFilterKind value) const;
+
+    int getNominalFrequency_hz() const { return _nominalFrequency_hz; }
+    void setNominalFrequency_hz(int value);
+
+    int getPeriod_msec() const { return _period_msec; }
+    void setPeriod_msec(int value);
+
+    void reset();
+
+    // Timestamped edge of an acEdge channel, every edge in time order before update() of
+    // the tick. From its first timestamped edge on the channel ignores the raw changes
+    void addEdge(size_t channelIndex, uint32_t timestamp_usec);
+
+    // Bit per channel: the raw input is on, the raw input could be read
+    void update(const Word* onWords, const Word* knownWords, int timeElapsed_msec);
+
+    DiscreteState getState(size_t channelIndex) const;
+
+    // Channels whose resulting state changed in the last update()
+    Word getChangedWord(size_t wordIndex) const { return _changed[wordIndex]; }
+    bool hasChanges() const { return _hasChanges; }
+
+private:
+    static const int32_t _edgesToTurnOn = 3;
+
+    static const size_t _kindCount = 4;
+
+    void updateWindow(size_t wordIndex, Word onWord, Word knownWord, int timeElapsed_msec);
+    void updateEdge(size_t wordIndex, Word onWord, Word knownWord);
+    void updateDebounce(size_t wordIndex, Word onWord, Word knownWord);
+
+    void finishWindows();
+    void findTimeouts();
+
+    void acceptEdge(size_t channelIndex, uint32_t interval_usec);
+
+    // Wraparound-safe "time has come" for the tick clock
+    bool isReached(uint32_t deadline_msec) const { return static_cast<int32_t>(_clock_msec - deadline_msec) >= 0; }
+    static void lowerDeadline(uint32_t& deadline_msec, uint32_t value_msec);
+
+    const Word* kindMask(InputFilterKind kind) const { return _kindMasks[static_cast<size_t>(kind)]; }
+
+    size_t _channelCount = 0;
+    size_t _wordCount = 0;
+
+    // Channels of every kind
+    Word _kindMasks[_kindCount][maxWordCount];
+
+    int _period_msec = 75;
+    int _nominalFrequency_hz = 50;
+
+    uint32_t _minInterval_usec = 0;
+    uint32_t _maxInterval_usec = 0;
+
+    // Sum of the elapsed time of all updates
+    uint32_t _clock_msec = 0;
+    uint32_t _nextWindowEnd_msec = 0;
+    uint32_t _nextTimeout_msec = 0;
+
+    // Raw state of the previous update, the last known one for acEdge and dcDebounce
+    Word _lastKnown[maxWordCount];
+    Word _lastOn[maxWordCount];
+
+    // Resulting state, the on bit is clear while the state is unknown
+    Word _stableKnown[maxWordCount];
+    Word _stableOn[maxWordCount];
+
+    // Resulting state as of the previous update, for the change detection
+    Word _reportedKnown[maxWordCount];
+    Word _reportedOn[maxWordCount];
+
+    int32_t _edgeCounts[maxChannelCount];
+
+    // acWindow: start of the edge counting window, moved forward while the channel
+    // is not counting so that the duration does not grow
+    uint32_t _windowStarts_msec[maxChannelCount];
+    Word _lastCounting[maxWordCount];
+
+    // acEdge
+    uint32_t _lastAcceptedEdges_msec[maxChannelCount];
+    uint32_t _lastEdgeTimestamps_usec[maxChannelCount];
+    Word _isTimedOut[maxWordCount];
+    Word _hasLastEdgeTimestamp[maxWordCount];
+    Word _isTimestamped[maxWordCount];
+
+    // dcDebounce
+    uint32_t _lastRawChanges_msec[maxChannelCount];
+    uint16_t _debounces_msec[maxChannelCount];
+
+    Word _changed[maxWordCount];
+    bool _hasChanges = false;
+};
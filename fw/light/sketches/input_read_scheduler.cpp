@@ -0,0 +1,100 @@
+#include "input_read_scheduler.h"
+
+InputReadScheduler::InputReadScheduler()
+{
+    for (size_t i = 0; i < maxExpanderCount; ++i)
+    {
+        _sources_p[i] = nullptr;
+    }
+}
+
+bool InputReadScheduler::setExpanderCount(size_t value)
+{
+    if (value > maxExpanderCount)
+    {
+        return false;
+    }
+
+    _expanderCount = value;
+    _isFullReadRequested = true;
+
+    return true;
+}
+
+bool InputReadScheduler::setInterruptSource(size_t expanderIndex, IInterruptSource* value_p)
+{
+    if (expanderIndex >= maxExpanderCount)
+    {
+        return false;
+    }
+
+    _sources_p[expanderIndex] = value_p;
+    _isFullReadRequested = true;
+
+    return true;
+}
+
+InputReadScheduler::ExpanderMask InputReadScheduler::update(int timeElapsed_msec)
+{
+    _sinceFullRead_msec += timeElapsed_msec;
+
+    if (_isFullReadRequested || (_sinceFullRead_msec >= _fallbackPollPeriod_msec))
+    {
+        _isFullReadRequested = false;
+        _sinceFullRead_msec = 0;
+
+        // Interrupts raised so far are served by this read
+        for (size_t i = 0; i < _expanderCount; ++i)
+        {
+            if (_sources_p[i] != nullptr)
+            {
+                _sources_p[i]->takePending();
+            }
+        }
+
+        return (_expanderCount >= maxExpanderCount) 
+            ? ~static_cast<ExpanderMask>(0) 
+            : (static_cast<ExpanderMask>(1) << _expanderCount) - 1;
+    }
+
+    ExpanderMask result = 0;
+    ExpanderMask checked = 0;
+
+    for (size_t i = 0; i < _expanderCount; ++i)
+    {
+        const auto bit = static_cast<ExpanderMask>(1) << i;
+
+        auto source_p = _sources_p[i];
+        if (source_p == nullptr)
+        {
+            result |= bit;
+            continue;
+        }
+
+        if ((checked & bit) != 0)
+        {
+            continue;
+        }
+
+        // Every source is asked once, the answer applies to all expanders sharing it
+        const auto pending = source_p->takePending();
+
+        for (size_t j = i; j < _expanderCount; ++j)
+        {
+            if (_sources_p[j] != source_p)
+            {
+                continue;
+            }
+
+            const auto sharedBit = static_cast<ExpanderMask>(1) << j;
+
+            checked |= sharedBit;
+            if (pending)
+            {
+                result |= sharedBit;
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include "types.h"
+
+// Decides which input expanders have to be read on a tick.
+// An expander with an interrupt source is read only after its interrupt fired
+// or when the fallback poll period elapsed; an expander without one is read every tick.
+// Several expanders may share one source (wired-OR INT lines), then all of them are read.
+class InputReadScheduler
+{
+public:
+    using ExpanderMask = uint32_t;
+
+    static const size_t maxExpanderCount = 32;
+
+    InputReadScheduler();
+
+    size_t getExpanderCount() const { return _expanderCount; }
+    bool setExpanderCount(size_t value);
+
+    bool setInterruptSource(size_t expanderIndex, IInterruptSource* value_p);
+
+    int getFallbackPollPeriod_msec() const { return _fallbackPollPeriod_msec; }
+    void setFallbackPollPeriod_msec(int value) { _fallbackPollPeriod_msec = value; }
+
+    // Forces all expanders to be read on the next update
+    void requestFullRead() { _isFullReadRequested = true; }
+
+    ExpanderMask update(int timeElapsed_msec);
+
+private:
+    size_t _expanderCount = 0;
+    IInterruptSource* _sources_p[maxExpanderCount];
+
+    int _fallbackPollPeriod_msec = 100;
+    int _sinceFullRead_msec = 0;
+    bool _isFullReadRequested = true;
+};
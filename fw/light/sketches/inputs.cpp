@@ -3,34 +3,102 @@
 #include "string_utils.h"
 #include "inputs.h"
 
-const uint8_t InputDevice::_expanderAddresses[] = 
+InputDevice::InputDevice() :
+	IInputDevice()
+{	
+}
+
+bool InputDevice::setPinMap(const std::vector<ExpanderPin>& value)
 {
-	0x20, 0x21	
-};
+	const auto ok = ExpanderMap::assignExpanders(value, _expanderAddresses, _expanderCount, _channelMap);
+	if (!ok)
+	{
+		_logger.error("Too many input I2C devices", ILogger::ErrorSeverity::error);
+	}
+	
+	_readScheduler.setExpanderCount(_expanderCount);
+	
+	for (size_t i = 0; i < _maxExpanderCount; ++i)
+	{
+		for (size_t pin = 0; pin < _pinsPerExpander; ++pin)
+		{
+			_pinChannels[i][pin] = -1;
+		}
+	}
+	
+	for (size_t i = 0; i < _channelMap.size(); ++i)
+	{
+		const auto& item = _channelMap[i];
+		_pinChannels[item.expanderIndex][item.channelNumber] = static_cast<int16_t>(i);
+	}
+	
+	buildShuffles();
+	
+	return ok;
+}
 
-const std::vector<InputDevice::ChannelHw> InputDevice::_channelMap = 
+void InputDevice::buildShuffles()
 {
-	{ 0, 5 }, // 1
-	{ 1, 3 }, // 2
-	{ 0, 4 }, // 3
-	{ 1, 4 }, // 4
-	{ 0, 0 }, // 5
-	{ 1, 0 }, // 6
-	{ 0, 3 }, // 7
-	{ 1, 5 }, // 8
-	{ 0, 2 }, // 9
-	{ 1, 6 }, // 10 
-	{ 0, 1 }, // 11
-	{ 1, 7 }, // 12
-	{ 0, 7 }, // 13
-	{ 1, 1 }, // 14
-	{ 0, 6 }, // 15
-	{ 1, 2 }, // 16
-};
+	_shuffles.clear();
+	
+	for (size_t i = 0; i < _expanderCount; ++i)
+	{
+		for (size_t pin = 0; pin < _pinsPerExpander; ++pin)
+		{
+			const auto channel = _pinChannels[i][pin];
+			if (channel < 0)
+			{
+				continue;
+			}
+			
+			const auto wordIndex = static_cast<uint8_t>(channel / 32);
+			const auto bit = static_cast<uint8_t>(channel % 32);
+			
+			// Extends the previous run if this pin and channel both follow it
+			if (!_shuffles.empty())
+			{
+				auto& last = _shuffles.back();
+				const auto runLength = static_cast<size_t>(__builtin_popcount(last.mask));
+				
+				if ((last.expanderIndex == i) && (last.wordIndex == wordIndex) && 
+					(last.firstPin + runLength == pin) && (last.firstBit + runLength == bit))
+				{
+					last.mask = static_cast<uint8_t>((last.mask << 1) | 1);
+					continue;
+				}
+			}
+			
+			PinShuffle shuffle;
+			
+			shuffle.expanderIndex = static_cast<uint8_t>(i);
+			shuffle.firstPin = static_cast<uint8_t>(pin);
+			shuffle.mask = 1;
+			shuffle.wordIndex = wordIndex;
+			shuffle.firstBit = bit;
+			
+			_shuffles.push_back(shuffle);
+		}
+	}
+}
 
-InputDevice::InputDevice() :
-	IInputDevice()
-{	
+void InputDevice::setInterruptSource(IInterruptSource* value_p)
+{
+	_interruptSource_p = value_p;
+	
+	for (size_t i = 0; i < _maxExpanderCount; ++i)
+	{
+		_readScheduler.setInterruptSource(i, value_p);
+	}
+}
+
+void InputDevice::setI2cEngine(I2cEngine* value_p)
+{
+	_i2cEngine_p = value_p;
+	
+	if ((_i2cEngine_p != nullptr) && (_interruptSource_p != nullptr))
+	{
+		_i2cEngine_p->setSampledReads(_interruptSource_p, _expanderAddresses, _expanderCount);
+	}
 }
 
 bool InputDevice::getCurrentValue(size_t channelIndex, DiscreteState& curValue_out) const
@@ -54,12 +122,136 @@ bool InputDevice::getCurrentValue(size_t channelIndex, DiscreteState& curValue_o
 	return true;
 }
 
-void InputDevice::update()
+void InputDevice::readAll(uint32_t* onMask_out, uint32_t* validMask_out, size_t wordCount) const
 {
+	for (size_t w = 0; w < wordCount; ++w)
+	{
+		onMask_out[w] = 0;
+		validMask_out[w] = 0;
+	}
+	
+	for (const auto& shuffle : _shuffles)
+	{
+		const auto& expander = _expanders[shuffle.expanderIndex];
+		
+		if ((shuffle.wordIndex >= wordCount) || !expander.connected())
+		{
+			continue;
+		}
+		
+		const auto bits = static_cast<uint32_t>((expander.buffer() >> shuffle.firstPin) & shuffle.mask);
+		
+		onMask_out[shuffle.wordIndex] |= bits << shuffle.firstBit;
+		validMask_out[shuffle.wordIndex] |= static_cast<uint32_t>(shuffle.mask) << shuffle.firstBit;
+	}
+}
+
+bool InputDevice::getChannelPin(size_t channelIndex, ExpanderChannel& pin_out) const
+{
+	if (channelIndex >= _channelMap.size())
+	{
+		return false;
+	}
+	
+	pin_out = _channelMap[channelIndex];
+	return true;
+}
+
+void InputDevice::readExpanderBytes(uint8_t* bytes_out, uint16_t& connectedMask_out) const
+{
+	connectedMask_out = 0;
+	
+	for (size_t i = 0; i < _expanderCount; ++i)
+	{
+		const auto& expander = _expanders[i];
+		
+		bytes_out[i] = expander.buffer();
+		
+		if (expander.connected())
+		{
+			connectedMask_out |= static_cast<uint16_t>(1u << i);
+		}
+	}
+}
+
+void InputDevice::update(int timeElapsed_msec)
+{
+	const auto toRead = _readScheduler.update(timeElapsed_msec);
+	
+	for (size_t i = 0; i < _expanderCount; ++i)
+	{
+		auto& expander = _expanders[i];
+		
+		if ((toRead & (1u << i)) != 0)
+		{
+			expander.markDirty();
+		}
+		
+		if (_i2cEngine_p != nullptr)
+		{
+			expander.requestReadAll(*_i2cEngine_p, true);
+		}
+		else
+		{
+			expander.readAllIfDirty();
+		}
+	}
+	
+	_edges.clear();
+	_takenEdgeCount = 0;
+	
+	I2cSample sample;
+	while ((_i2cEngine_p != nullptr) && _i2cEngine_p->takeSample(sample))
+	{
+		addSampleEdges(sample);
+	}
+}
+
+void InputDevice::addSampleEdges(const I2cSample& sample)
+{
+	// A pin has an edge if both samples read its expander
+	const auto bothMask = static_cast<uint16_t>(sample.okMask & _sampledMask);
+	
 	for (size_t i = 0; i < _expanderCount; ++i)
 	{
-		_expanders[i].readAll();
+		auto changed = static_cast<uint8_t>(sample.bytes[i] ^ _sampledBytes[i]);
+		if ((bothMask & (1u << i)) == 0)
+		{
+			changed = 0;
+		}
+		
+		for (size_t pin = 0; changed != 0; ++pin, changed >>= 1)
+		{
+			const auto channel = _pinChannels[i][pin];
+			if (((changed & 1) == 0) || (channel < 0))
+			{
+				continue;
+			}
+			
+			InputEdge edge;
+			
+			edge.channelIndex = static_cast<uint16_t>(channel);
+			edge.time_usec = sample.time_usec;
+			
+			_edges.push_back(edge);
+		}
+		
+		_sampledBytes[i] = sample.bytes[i];
+	}
+	
+	_sampledMask = sample.okMask;
+}
+
+size_t InputDevice::takeEdges(InputEdge* edges_out, size_t maxCount)
+{
+	size_t count = 0;
+	
+	while ((count < maxCount) && (_takenEdgeCount < _edges.size()))
+	{
+		edges_out[count++] = _edges[_takenEdgeCount++];
 	}
+	
+	return count;
 }
 
 bool InputDevice::getHw(size_t channelIndex, const jm_PCF8574*& device_p_out, size_t& channelNumber_out) const
@@ -10,6 +10,8 @@
 
 #include "types.h"
 #include "log_utils.h"
+#include "input_read_scheduler.h"
+#include "expander_map.h"
 
 class InputDevice : public IInputDevice
 {
@@ -18,28 +20,77 @@ public:
 	
 	void setLogger(ILogger* value_p) { _logger.setLogger(value_p); }
 	
+	// Channel pins in channel order, to be set before initialize()
+	bool setPinMap(const std::vector<ExpanderPin>& value);
+	
 	bool initialize();
 	
+	// INT line shared by all input expanders. Without one every update() reads the expanders
+	void setInterruptSource(IInterruptSource* value_p);
+	
+	// With an engine update() only queues the reads, the values change when it dispatches the results.
+	// With an interrupt source too the engine samples the expanders on every interrupt for the
+	// edge times, so the source is to be set first
+	void setI2cEngine(I2cEngine* value_p);
+	
+	int getFallbackPollPeriod_msec() const { return _readScheduler.getFallbackPollPeriod_msec(); }
+	void setFallbackPollPeriod_msec(int value) { _readScheduler.setFallbackPollPeriod_msec(value); }
+	
 	bool getCurrentValue(size_t channelIndex, DiscreteState& curValue_out) const override;
-	void update();
+	void readAll(uint32_t* onMask_out, uint32_t* validMask_out, size_t wordCount) const override;
+	
+	// Changes seen by the engine samples up to the last update(), with the time of their interrupt
+	size_t takeEdges(InputEdge* edges_out, size_t maxCount) override;
+	void update(int timeElapsed_msec);
 	
 	size_t getChannelCount() const { return _channelMap.size(); }
+	size_t getExpanderCount() const { return _expanderCount; }
+	
+	bool getChannelPin(size_t channelIndex, ExpanderChannel& pin_out) const;
+	
+	// Last read byte of every expander, bit i of connectedMask_out is set if expander i answered
+	void readExpanderBytes(uint8_t* bytes_out, uint16_t& connectedMask_out) const;
 	
 private:
+	// Consecutive pins of an expander that are consecutive channels of one frame word
+	struct PinShuffle
+	{
+		uint8_t expanderIndex;
+		uint8_t firstPin;
+		uint8_t mask;		// Of the pins, from firstPin
+		uint8_t wordIndex;
+		uint8_t firstBit;
+	};
+	
 	bool getHw(size_t channelIndex, const jm_PCF8574 * & device_p_out, size_t& channelNumber_out) const;
+	void addSampleEdges(const I2cSample& sample);
+	void buildShuffles();
 	
-	static const size_t _expanderCount = 2;
+	static const size_t _maxExpanderCount = ExpanderMap::maxExpanderCount;
+	static const size_t _pinsPerExpander = 8;
 	
 	LoggerHelper _logger;
 	
-	jm_PCF8574 _expanders[_expanderCount];
+	jm_PCF8574 _expanders[_maxExpanderCount];
+	uint8_t _expanderAddresses[_maxExpanderCount];
+	size_t _expanderCount = 0;
 	
-	struct ChannelHw
-	{
-		size_t expanderIndex;
-		size_t channelNumber;
-	};	
+	I2cEngine* _i2cEngine_p = nullptr;
+	InputReadScheduler _readScheduler;
+	IInterruptSource* _interruptSource_p = nullptr;
+	
+	std::vector<ExpanderChannel> _channelMap;
+	
+	// Expander bytes to frame words, in expander order
+	std::vector<PinShuffle> _shuffles;
+	
+	// Channel of every expander pin, -1 if unused
+	int16_t _pinChannels[_maxExpanderCount][_pinsPerExpander];
+	
+	// Bytes of the previous engine sample
+	uint8_t _sampledBytes[_maxExpanderCount];
+	uint16_t _sampledMask = 0;
 	
-	static const std::vector<ChannelHw> _channelMap;
-	static const uint8_t _expanderAddresses[_expanderCount];
+	std::vector<InputEdge> _edges;
+	size_t _takenEdgeCount = 0;
 };
\ No newline at end of file
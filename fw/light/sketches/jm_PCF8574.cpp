@@ -50,6 +50,11 @@ bool jm_PCF8574::connected() const
 	return _connected;
 }
 
+uint8_t jm_PCF8574::buffer() const
+{
+	return _buffer;
+}
+
 // ---------------------------------------------------------------------------
 
 bool jm_PCF8574::begin() // return OK
@@ -91,10 +96,31 @@ bool jm_PCF8574::readAll()
 		return false;
 	}	
 	
+	_isDirty = false;
 	_buffer = read();
 	
 	return _buffer != -1;
 }
+
+bool jm_PCF8574::isDirty() const
+{
+	return _isDirty;
+}
+
+void jm_PCF8574::markDirty()
+{
+	_isDirty = true;
+}
+
+bool jm_PCF8574::readAllIfDirty()
+{
+	if (!_isDirty)
+	{
+		return true;
+	}
+	
+	return readAll();
+}
 	
 bool jm_PCF8574::writeAll()
 {
@@ -105,9 +131,83 @@ bool jm_PCF8574::writeAll()
 	
 	const auto result = write(_buffer);
 	
+	_written = (result > 0) ? _buffer : -1;
 	return result > 0;
 }
 
+bool jm_PCF8574::isWritePending() const
+{
+	return _written != _buffer;
+}
+
+bool jm_PCF8574::writeAllIfChanged()
+{
+	if (!isWritePending())
+	{
+		return true;
+	}
+	
+	return writeAll();
+}
+
+bool jm_PCF8574::requestReadAll(I2cEngine& engine, bool onlyIfDirty)
+{
+	if (!_connected) 
+	{
+		return false;
+	}
+	
+	if (_isReadInFlight || (onlyIfDirty && !_isDirty))
+	{
+		return true;
+	}
+	
+	I2cTransaction transaction;
+	
+	transaction.kind = I2cTransaction::Kind::read;
+	transaction.address = _i2c_address;
+	transaction.data = 0xFF;
+	transaction.ok = false;
+	transaction.callback = &jm_PCF8574::onTransactionComplete;
+	transaction.context_p = this;
+	
+	// Interrupts arriving from now on belong to the next read
+	_isDirty = false;
+	_isReadInFlight = engine.submit(transaction);
+	
+	if (!_isReadInFlight)
+	{
+		_isDirty = true;
+	}
+	
+	return _isReadInFlight;
+}
+
+bool jm_PCF8574::requestWriteAll(I2cEngine& engine, bool onlyIfChanged)
+{
+	if (!_connected) 
+	{
+		return false;
+	}
+	
+	if (_isWriteInFlight || (onlyIfChanged && !isWritePending()))
+	{
+		return true;
+	}
+	
+	I2cTransaction transaction;
+	
+	transaction.kind = I2cTransaction::Kind::write;
+	transaction.address = _i2c_address;
+	transaction.data = _buffer;
+	transaction.ok = false;
+	transaction.callback = &jm_PCF8574::onTransactionComplete;
+	transaction.context_p = this;
+	
+	_isWriteInFlight = engine.submit(transaction);
+	return _isWriteInFlight;
+}
+
 int jm_PCF8574::read()
 {
 	if (!_connected) return -1;
@@ -218,6 +318,27 @@ void jm_PCF8574::wait(uint16_t us)
 
 // static functions...
 
+void jm_PCF8574::onTransactionComplete(void * obj, const I2cTransaction& transaction)
+{
+	auto device_p = static_cast<jm_PCF8574*>(obj);
+	
+	if (transaction.kind == I2cTransaction::Kind::read)
+	{
+		device_p->_isReadInFlight = false;
+		device_p->_buffer = transaction.data;
+	}
+	else
+	{
+		device_p->_isWriteInFlight = false;
+		device_p->_written = transaction.ok ? transaction.data : -1;
+	}
+	
+	if (!transaction.ok)
+	{
+		device_p->_connected = false;
+	}
+}
+
 void jm_PCF8574::obj_pinMode(void * obj, uint8_t pin, uint8_t mode)
 {
 	if ((jm_PCF8574 *) obj) ((jm_PCF8574 *) obj)->pin_Mode(pin, mode);
@@ -18,6 +18,8 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "i2c_engine.h"
+
 class jm_PCF8574
 {
 private:
@@ -26,6 +28,12 @@ protected:
 	bool _isBuffered = false;
 	uint8_t _buffer = -1;
 	
+	volatile bool _isDirty = true;	// Inputs may have changed since the last readAll()
+	int _written = -1;				// Byte of the last successful writeAll(), -1 if unknown
+	
+	bool _isReadInFlight = false;	// Queued to an I2cEngine, not completed yet
+	bool _isWriteInFlight = false;
+	
 	uint8_t	_i2c_address;		// Device I2C address
 	bool	_connected;			// Device ready and not errored
 
@@ -43,6 +51,7 @@ public:
 
 	uint8_t i2c_address() const;
 	bool connected() const;
+	uint8_t buffer() const;
 
 	bool begin();
 	bool begin(uint8_t i2c_address);
@@ -50,6 +59,18 @@ public:
 	
 	bool readAll();
 	bool writeAll();
+	
+	bool isDirty() const;
+	void markDirty();			// Safe to call from an ISR
+	bool readAllIfDirty();
+	
+	bool isWritePending() const;
+	bool writeAllIfChanged();
+	
+	// Asynchronous readAll()/writeAll(), the buffer is updated when the engine dispatches
+	// the completion. At most one read and one write are in flight
+	bool requestReadAll(I2cEngine& engine, bool onlyIfDirty);
+	bool requestWriteAll(I2cEngine& engine, bool onlyIfChanged);
 
 	int read();
 	size_t write(uint8_t value);
@@ -64,6 +85,8 @@ public:
 
 	void wait(uint16_t us);
 
+	static void onTransactionComplete(void * obj, const I2cTransaction& transaction);
+
 	static void obj_pinMode(void * obj, uint8_t pin, uint8_t mode);
 	static int obj_digitalRead(void * obj, uint8_t pin);
 	static void obj_digitalWrite(void * obj, uint8_t pin, uint8_t value);
@@ -23,6 +23,7 @@
 
 #include "log_writer.h"
 #include "logger.h"
+#include "sync_logger.h"
 
 #include "default_settings.h"
 #include "settings_reader_ini.h"
@@ -42,6 +43,18 @@ static const String mainSettingsFilename = "/settings.ini";
 #define PIN_I2C_SDA 4
 #define PIN_I2C_SCL 5
 
+// INT line of the input expanders, -1 if it is not wired: inputs are polled every tick then
+#define PIN_INPUTS_INT -1
+
+// Light control shares the application core with loop(), away from the WiFi and Ethernet
+// driver tasks pinned to core 0 (PRO_CPU) at priorities 15..23.
+// The TCP/IP thread (priority 18) may run on either core, so the control task runs above it
+// at 20 and the I2C bus task at 21. Both sleep between ticks, loop() at priority 1 and
+// the AsyncTCP task at 3 get the rest of the core
+#define CONTROL_TASK_CORE ARDUINO_RUNNING_CORE
+#define CONTROL_TASK_PRIORITY (configMAX_PRIORITIES - 5)
+#define CONTROL_PERIOD_MSEC 5
+
 #define PIN_ETHERNET_ENABLE 16
 #define ETH_MDIO_PIN                       18
 #define ETH_TXD0_PIN                       19
@@ -57,7 +70,8 @@ static const String mainSettingsFilename = "/settings.ini";
 #define ETH_CLK_MODE     ETH_CLOCK_GPIO17_OUT
 
 
-static Logger logger;
+static Logger serialLogger;
+static SyncLogger logger;
 static StreamLogWriter logSerialWriter;
 
 static DefaultSettingsCreator defSettingsCreator;
@@ -382,6 +396,10 @@ bool initFtp(const FtpSettings& settings)
 	}
 	
 	ftpServer.setFileSystem(&SPIFFS);
+	ftpServer.setFileWrittenCallback(
+		[](const String& path) {
+			lightController.notifyFileWritten(path);
+		});
 	ftpServer.begin(String(user.c_str()), String(password.c_str()));
 	
 	return true;
@@ -461,6 +479,54 @@ bool initHttpControl(WebServer& srv)
 		[&srv]() {
 			httpControl.outputs_local_off(srv);	
 		});
+	
+	srv.on("/api/v1/groups/get",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.groups_state_get(srv);	
+		});
+	
+	srv.on("/api/v1/groups/set",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.groups_state_set(srv);	
+		});
+	
+	srv.on("/api/v1/rules/reload",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.rules_reload(srv);	
+		});
+	
+	srv.on("/api/v1/profile/get",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.profile_get(srv);	
+		});
+	
+	srv.on("/api/v1/profile/reset",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.profile_reset(srv);	
+		});
+	
+	srv.on("/api/v1/capture/start",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.capture_start(srv);	
+		});
+	
+	srv.on("/api/v1/capture/stop",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.capture_stop(srv);	
+		});
+	
+	srv.on("/api/v1/capture/get",
+		HTTP_GET, 
+		[&srv]() {
+			httpControl.capture_get(srv);	
+		});
 		
 	return true;
 }
@@ -471,7 +537,8 @@ void setup()
 	Serial.begin(115200);
 		
 	logSerialWriter.setStream(&Serial);
-	logger.setWriter(&logSerialWriter);
+	serialLogger.setWriter(&logSerialWriter);
+	logger.setLogger(&serialLogger);
 	
 	logger.trace("Initialization");
 	
@@ -609,10 +676,16 @@ void setup()
 	logger.trace("Initializing HTTP server");
 	httpServer.begin();
 	
+	lightController.setInputInterruptPin(PIN_INPUTS_INT);
 	if (!lightController.initialize(&logger, &SPIFFS, areSettingsEmpty))
 	{
 		logger.error("Failed to initialize light control system", ILogger::ErrorSeverity::error);	
 	}
+	
+	if (!lightController.startControlTask(CONTROL_TASK_CORE, CONTROL_TASK_PRIORITY, CONTROL_PERIOD_MSEC))
+	{
+		logger.error("Failed to start light control task, running it from loop()", ILogger::ErrorSeverity::error);	
+	}
 		
 	
 	logger.info("Initialization completed");
@@ -625,7 +698,7 @@ void loop()
 	const auto curMillis = millis();
 	cnt++;
 	
-	const int delay_msec = 5;
+	const int delay_msec = CONTROL_PERIOD_MSEC;
 	
 	unsigned long dif = curMillis - lastMillis;
 	if (curMillis > lastMillis)
@@ -646,11 +719,17 @@ void loop()
 	
 	if (dif > delay_msec)
 	{
-		lightController.loop(dif);		
+		if (!lightController.isControlTaskRunning())
+		{
+			lightController.loop(dif);		
+		}
+		
+		lightController.dispatchEvents();
 		mqttControl.setTimestamp(curMillis);
 		
 		if (mqttControl.isConnected())
 		{
+			mqttControl.processCommands();
 			mqttControl.sendEvents();
 		}
 		
@@ -1,5 +1,5 @@
 #include <cassert>
-#include <map>
+#include <algorithm>
 
 #include "string_utils.h"
 #include "light_controller.h"
@@ -16,10 +16,17 @@ bool LightController::initialize()
 	_lastOutputStates.resize(_outputChannelCount);
 	std::fill(_lastOutputStates.begin(), _lastOutputStates.end(), DiscreteState::unknown);
 	
+    // The first tick passes every channel on, later ticks only the changed ones
+    _changedInputs.assign(BitUtils::wordCount(_inputChannelCount), ~static_cast<BitUtils::Word>(0));
+    _hasChangedInputs = true;
+    _isOutputRefreshNeeded = true;
+
     _eventDetector.setChannelCount(_inputChannelCount);
+    _eventDetector.setGestureTimes(_gestureTimes);
     _actionManager.setInputChannelCount(_inputChannelCount);
     _actionManager.setOutputChannelCount(_outputChannelCount);
 
+    applyOutputGroups();
     ok &= readRules();
 	
 	return ok;
@@ -27,20 +34,28 @@ bool LightController::initialize()
  
 bool LightController::initializeFilters()
 {
-    if (_inputFilters.size() >= _inputChannelCount)
+    if (!_inputFilters.setChannelCount(_inputChannelCount))
     {
-        _inputFilters.resize(_inputChannelCount);
+        _logger.error("Too many input channels for the filters", ILogger::ErrorSeverity::error);
+        return false;
     }
-    else
-    {
-        size_t needToAdd = _inputChannelCount - _inputFilters.size();
-        _inputFilters.reserve(_inputChannelCount);
 
-        for (size_t i = 0; i < needToAdd; ++i)
+    _inputFilters.setKind(_inputFilterKind);
+    _inputFilters.setPeriod_msec(_inputFilterPeriod_msec);
+    _inputFilters.setNominalFrequency_hz(_nominalFrequency_hz);
+
+    for (const auto& item : _inputFilterSettings)
+    {
+        if ((item.first < _inputChannelCount) && !_inputFilters.setChannelSettings(item.first, item.second))
         {
-            _inputFilters.push_back((PInputFilter)(new InputFilterAc()));
+            LogError msg(_logger, ILogger::ErrorSeverity::warning);
+
+            msg.addText("Invalid filter settings of input channel ");
+            msg.addText(StringUtils::toString(item.first));
         }
     }
+
+    _hasEdgeFilters = _inputFilters.hasKind(InputFilterKind::acEdge);
 	
 	return true;
 }
@@ -71,97 +86,304 @@ bool LightController::readRules()
 	return ruleAdded;
 }
 
+RulesReloadResult LightController::reloadRules(IRulesReader& reader)
+{
+    const auto table_p = _actionManager.getSpareRuleTable();
+    if (table_p == nullptr)
+    {
+        return RulesReloadResult::busy;
+    }
+
+    table_p->clear();
+
+    if (!reader.reset())
+    {
+        _logger.error("Rules reload failed to read the rules", ILogger::ErrorSeverity::warning);
+        return RulesReloadResult::readFailed;
+    }
+
+    // Unlike on initialize() a rule that fails keeps the running rules as they are,
+    // rather than running the rest without it
+    size_t invalidCount = 0;
+
+    while (reader.hasMoreRules())
+    {
+        Rule newRule;
+
+        const auto result = reader.readRule(newRule);
+        if (result == IRulesReader::ReadResult::error)
+        {
+            ++invalidCount;
+        }
+        else if ((result == IRulesReader::ReadResult::success) && (table_p->addRule(newRule) != ActionManagerError::none))
+        {
+            ++invalidCount;
+        }
+    }
+
+    if (invalidCount != 0)
+    {
+        LogError msg(_logger, ILogger::ErrorSeverity::warning);
+
+        msg.addText("Rules reload rejected, invalid rules: ");
+        msg.addText(StringUtils::toString(invalidCount));
+
+        return RulesReloadResult::invalidRules;
+    }
+
+    _actionManager.publishRuleTable(table_p);
+
+    LogInfo msg(_logger);
+
+    msg.addText("Rules reloaded: ");
+    msg.addText(StringUtils::toString(table_p->getRuleCount()));
+
+    return RulesReloadResult::success;
+}
+
+void LightController::applyOutputGroups()
+{
+    _actionManager.clearOutputGroups();
+
+    if (_outputGroups_p == nullptr)
+    {
+        return;
+    }
+
+    BitUtils::Word mask[ActionManager::maxOutputWordCount];
+
+    for (size_t i = 0; i < _outputGroups_p->getGroupCount(); ++i)
+    {
+        _outputGroups_p->getGroupMask(i, mask, ActionManager::maxOutputWordCount);
+
+        if (_actionManager.addOutputGroup(mask, ActionManager::maxOutputWordCount) != ActionManagerError::none)
+        {
+            _logger.error("Too many output groups", ILogger::ErrorSeverity::warning);
+            return;
+        }
+    }
+}
+
+bool LightController::addEventQueue(InputEventQueue& queue)
+{
+    if (_eventQueueCount >= _maxEventQueueCount)
+    {
+        return false;
+    }
+
+    _eventQueues[_eventQueueCount++] = &queue;
+    return true;
+}
+
+void LightController::removeEventQueue(InputEventQueue& queue)
+{
+    for (size_t i = 0; i < _eventQueueCount; ++i)
+    {
+        if (_eventQueues[i] == &queue)
+        {
+            _eventQueues[i] = _eventQueues[--_eventQueueCount];
+            return;
+        }
+    }
+}
+
 void LightController::execute(int time_elapsed_ms)
 {
-    readInputs(time_elapsed_ms);
+    _time_msec += time_elapsed_ms;
 
-    detectEvents(time_elapsed_ms);
-    manageActions(time_elapsed_ms);
+    {
+        ProfileScope scope(_profiler_p, TickProfiler::Stage::readInputs);
+        readInputs(time_elapsed_ms);
+    }
 
-    writeOutputs();
+    {
+        ProfileScope scope(_profiler_p, TickProfiler::Stage::detectEvents);
+        detectEvents(time_elapsed_ms);
+    }
+
+    {
+        ProfileScope scope(_profiler_p, TickProfiler::Stage::manageActions);
+        manageActions(time_elapsed_ms);
+    }
 
-    sendEvents();
-    sendGlobalOff();
+    {
+        ProfileScope scope(_profiler_p, TickProfiler::Stage::writeOutputs);
+        writeOutputs();
+    }
+
+    {
+        ProfileScope scope(_profiler_p, TickProfiler::Stage::sendEvents);
+        sendEvents();
+        sendGlobalOff();
+    }
 }
 
 void LightController::readInputs(int time_elapsed_ms)
 {
-    for (size_t i = 0; i < _inputChannelCount; ++i)
+    // Not more than the filters could take
+    const auto wordCount = BitUtils::wordCount(_inputFilters.getChannelCount());
+
+    if (_inputDevice_p != nullptr)
+    {
+        _inputDevice_p->readAll(_rawOnWords, _rawKnownWords, wordCount);
+    }
+    else
+    {
+        for (size_t w = 0; w < wordCount; ++w)
+        {
+            _rawOnWords[w] = 0;
+            _rawKnownWords[w] = 0;
+        }
+    }
+
+    if ((_inputDevice_p != nullptr) && _hasEdgeFilters)
     {
-        auto& filter_p = _inputFilters[i];
+        feedEdges();
+    }
 
-        DiscreteState state = DiscreteState::unknown;
+    _inputFilters.update(_rawOnWords, _rawKnownWords, time_elapsed_ms);
 
-        if (_inputDevice_p != nullptr)
+    if (!_inputFilters.hasChanges())
+    {
+        return;
+    }
+
+    for (size_t w = 0; w < wordCount; ++w)
+    {
+        auto changed = _inputFilters.getChangedWord(w);
+        if (changed == 0)
         {
-            const auto ok = _inputDevice_p->getCurrentValue(i, state);
-            if (!ok)
-            {
-                state = DiscreteState::unknown;
-            }
+            continue;
+        }
+
+        _changedInputs[w] |= changed;
+        _hasChangedInputs = true;
+
+        while (changed != 0)
+        {
+            const auto i = w * BitUtils::bitsPerWord + BitUtils::lowestSetBit(changed);
+            changed = BitUtils::clearLowestSetBit(changed);
+
+            _lastInputStates[i] = _inputFilters.getState(i);
         }
-	    
-        filter_p->update(state, time_elapsed_ms);
     }
 }
 
+void LightController::feedEdges()
+{
+    InputEdge edges[_edgeBatchSize];
+
+    // Every edge the device timestamped since the previous tick, the bank wants each interval
+    size_t count;
+    do
+    {
+        count = _inputDevice_p->takeEdges(edges, _edgeBatchSize);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            _inputFilters.addEdge(edges[i].channelIndex, edges[i].time_usec);
+        }
+    }
+    while (count == _edgeBatchSize);
+}
+
 void LightController::detectEvents(int time_elapsed_ms)
 {
-    (void)time_elapsed_ms;
+    _eventDetector.advanceTime(time_elapsed_ms);
 
-    for (size_t i = 0; i < _inputChannelCount; ++i)
+    // Nothing changed, nothing left to clear from the previous tick and no gesture to time
+    if (!_hasChangedInputs && !_eventDetector.hasEvents() && !_eventDetector.hasGestures())
     {
-        DiscreteState state;
+        return;
+    }
 
-        state = _inputFilters[i]->resultingState();
-        //_inputDevice_p->getCurrentValue(i, state);
+    if (_hasChangedInputs)
+    {
+        for (size_t w = 0; w < _changedInputs.size(); ++w)
+        {
+            auto changed = _changedInputs[w];
+            _changedInputs[w] = 0;
+
+            while (changed != 0)
+            {
+                const auto i = w * BitUtils::bitsPerWord + BitUtils::lowestSetBit(changed);
+                changed = BitUtils::clearLowestSetBit(changed);
+
+                if (i < _inputChannelCount)
+                {
+                    _eventDetector.setInputState(i, _lastInputStates[i]);
+                    _actionManager.setInputState(i, _lastInputStates[i]);
+                }
+            }
+        }
 
-	    _lastInputStates[i] = state;
-        _eventDetector.setInputState(i, state);
+        _hasChangedInputs = false;
     }
 
     _eventDetector.execute();
 }
 
-void LightController::manageActions(int time_elapsed_ms)
+template <typename F>
+void LightController::forEachEvent(F handler) const
 {
-    (void)time_elapsed_ms;
-
-    for (size_t i = 0; i < _inputChannelCount; ++i)
+    const auto wordCount = _eventDetector.getWordCount();
+    for (size_t w = 0; w < wordCount; ++w)
     {
-        EventType event;
-        const auto ok = _eventDetector.getOutputEvent(i, event) == EventDetectorError::none;
-        if (!ok)
+        BitUtils::Word pending = 0;
+        for (size_t kind = 0; kind < EventDetector::eventKindCount; ++kind)
         {
-            event = EventType::none;
+            pending |= _eventDetector.getEventWord(kind, w);
         }
-	    
-	    if (event != EventType::none)
-	    {
-		    logEvent(i, event);
-		    
-		    for (auto& listener_p : _inputEventListeners)
-		    {
-			    listener_p->inputEventNotification(i, event);
-		    }
-	    }
-	    
-        _actionManager.setInputEvent(i, event);
-    }
 
-    _actionManager.execute();
+        // Channel by channel, the events of a channel in EventType order
+        while (pending != 0)
+        {
+            const auto bit = BitUtils::lowestSetBit(pending);
+            const auto mask = BitUtils::bitMask(bit);
+
+            for (size_t kind = 0; kind < EventDetector::eventKindCount; ++kind)
+            {
+                if ((_eventDetector.getEventWord(kind, w) & mask) != 0)
+                {
+                    handler(w * BitUtils::bitsPerWord + bit, EventDetector::getEventType(kind));
+                }
+            }
+
+            pending = BitUtils::clearLowestSetBit(pending);
+        }
+    }
 }
 
-void LightController::logEvent(int channelIndex, EventType event)
+void LightController::manageActions(int time_elapsed_ms)
 {
-	static const std::map<EventType, std::string> eventTexts = 
-	{
-		{ EventType::none, "none"},
-		{ EventType::fall, "fall"},
-		{ EventType::rise, "rise"}
-	};
-	
-	_logger.info("Input " + StringUtils::toString(channelIndex) + ", " + eventTexts.at(event) + " detected");
+    _actionManager.advanceTime(time_elapsed_ms);
+
+    if (_eventDetector.hasEvents())
+    {
+        forEachEvent(
+            [this](size_t channelIndex, EventType event)
+            {
+                for (auto& listener_p : _inputEventListeners)
+                {
+                    listener_p->inputEventNotification(channelIndex, event);
+                }
+
+                InputEventRecord record;
+
+                record.timestamp_msec = _time_msec;
+                record.channelIndex = channelIndex;
+                record.event = event;
+
+                for (size_t i = 0; i < _eventQueueCount; ++i)
+                {
+                    _eventQueues[i]->push(record);
+                }
+
+                _actionManager.setInputEvent(channelIndex, event);
+            });
+    }
+
+    _actionManager.execute();
 }
 
 void LightController::writeOutputs()
@@ -171,57 +393,81 @@ void LightController::writeOutputs()
         return;
     }
 
-    for (size_t i = 0; i < _outputChannelCount; ++i)
+    if (_isOutputRefreshNeeded)
     {
-        DiscreteState state;
+        for (size_t i = 0; i < _outputChannelCount; ++i)
+        {
+            writeOutput(i, true);
+        }
 
-        const auto ok = _actionManager.getOutputState(i, state) == ActionManagerError::none;
-        if (!ok)
+        _isOutputRefreshNeeded = false;
+        return;
+    }
+
+    if (!_actionManager.hasChangedOutputs())
+    {
+        return;
+    }
+
+    for (size_t w = 0; w < BitUtils::wordCount(_outputChannelCount); ++w)
+    {
+        auto changed = _actionManager.getChangedOutputWord(w);
+
+        while (changed != 0)
         {
-            continue;
+            writeOutput(w * BitUtils::bitsPerWord + BitUtils::lowestSetBit(changed), false);
+            changed = BitUtils::clearLowestSetBit(changed);
         }
-	    	    
-        _outputDevice_p->setCurrentValue(i, state);
-	    if (state != _lastOutputStates[i])
-	    {
-		    logOutputChange(i, state);
-		    _lastOutputStates[i] = state;
-	    }	    
     }
 }
 
-void LightController::logOutputChange(int channelIndex, DiscreteState state)
+void LightController::writeOutput(size_t channelIndex, bool force)
 {
-	static const std::map<DiscreteState, std::string> stateTexts = 
-	{
-		{ DiscreteState::unknown, "UNKNOWN" },
-		{ DiscreteState::on,      "ON"      },
-		{ DiscreteState::off,     "OFF"     }
-	};
-	
-	_logger.info("Output " + StringUtils::toString(channelIndex) + " switched to " + stateTexts.at(state));
+    DiscreteState state;
+
+    const auto ok = _actionManager.getOutputState(channelIndex, state) == ActionManagerError::none;
+    if (!ok)
+    {
+        return;
+    }
+
+    if (state != _lastOutputStates[channelIndex])
+    {
+        if (_outputChangeQueue_p != nullptr)
+        {
+            OutputChangeRecord record;
+
+            record.timestamp_msec = _time_msec;
+            record.channelIndex = channelIndex;
+            record.state = state;
+
+            _outputChangeQueue_p->push(record);
+        }
+
+        _lastOutputStates[channelIndex] = state;
+    }
+    else if (!force)
+    {
+        return;
+    }
+
+    _outputDevice_p->setCurrentValue(channelIndex, state);
 }
 
 void LightController::sendEvents()
 {
-    if (_eventSender_p == nullptr)
+    if ((_eventSender_p == nullptr) || !_eventDetector.hasEvents())
     {
         return;
     }
 
     _eventSender_p->beginSendEvents();
 
-    for (size_t i = 0; i < _inputChannelCount; ++i)
-    {
-        EventType event;
-        const auto ok = _eventDetector.getOutputEvent(i, event) == EventDetectorError::none;
-        if (!ok || (event == EventType::none))
+    forEachEvent(
+        [this](size_t channelIndex, EventType event)
         {
-            continue;
-        }
-
-        _eventSender_p->sendEvent(i, event);
-    }
+            _eventSender_p->sendEvent(channelIndex, event);
+        });
 
     _eventSender_p->endSendEvents();
 }
@@ -252,6 +498,11 @@ void LightController::forceOutput(size_t outputChannelIndex, DiscreteState state
     _actionManager.forceOutput(outputChannelIndex, state);
 }
 
+void LightController::forceOutputGroup(size_t groupIndex, DiscreteState state)
+{
+    _actionManager.forceOutputGroup(groupIndex, state);
+}
+
 void LightController::forceLocalOff()
 {
     _actionManager.forceLocalOff();
@@ -6,13 +6,17 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <memory>
 
 #include "types.h" 
 
 #include "action_manager.h"
 #include "event_detector.h"
-#include "input_filter_ac.h"
+#include "input_filter_bank.h"
+#include "input_event_queue.h"
+#include "tick_profiler.h"
+#include "output_groups.h"
 
 #include "log_utils.h"
 
@@ -24,6 +28,15 @@ public:
 	void registerInputEventListener(IInputEventListener& listener) { _inputEventListeners.push_back(&listener); }
 	void unregisterInputEventListener(IInputEventListener& listener) { _inputEventListeners.remove(&listener); }
 	
+	// Queues receive every input event without blocking the tick.
+	// Register them before execute() may run concurrently
+	bool addEventQueue(InputEventQueue& queue);
+	void removeEventQueue(InputEventQueue& queue);
+	
+	// Optional, receives every output change without blocking the tick.
+	// The tick does not log the events and changes, the consumers of the queues do
+	void setOutputChangeQueue(OutputChangeQueue* value_p) { _outputChangeQueue_p = value_p; }
+	
 	size_t getInputCount() const { return _inputChannelCount; }
 	void setInputCount(size_t value) { _inputChannelCount = value; }
     
@@ -31,36 +44,64 @@ public:
 	void setOutputCount(size_t value) { _outputChannelCount = value; }
 
     void setInputDevice(IInputDevice* value_p) { _inputDevice_p = value_p; }
+
+    // Take effect on initialize(). acEdge uses the edge timestamps of the input device if it has them.
+    // The kind is for the channels without their own settings
+    void setInputFilterKind(InputFilterKind value) { _inputFilterKind = value; }
+    void setInputFilterSettings(size_t channelIndex, const InputFilterSettings& value) { _inputFilterSettings[channelIndex] = value; }
+
+    // AC detector parameters of all channels, take effect on initialize()
+    void setInputFilterPeriod_msec(int value) { _inputFilterPeriod_msec = value; }
+    void setNominalFrequency_hz(int value) { _nominalFrequency_hz = value; }
+
+    // Click and long press timing of all channels, takes effect on initialize()
+    void setGestureTimes(const GestureTimes& value) { _gestureTimes = value; }
+
     void setOutputDevice(IOutputDevice* value_p) { _outputDevice_p = value_p; }
 
     void setRulesReader(IRulesReader* value_p) { _rulesReader_p = value_p; }
+
+    // Optional, groups the rules and forceOutputGroup() refer to by index. Taken on initialize()
+    void setOutputGroups(const OutputGroupList* value_p) { _outputGroups_p = value_p; }
     void setGlobalOffSender(IGlobalOffSender* value_p) { _globalOffSender_p = value_p; }
     void setEventSender(IEventSender* value_p) { _eventSender_p = value_p; }
 
+    // Optional, receives the duration of every execute() stage
+    void setProfiler(TickProfiler* value_p) { _profiler_p = value_p; }
+
     bool initialize();
     void execute(int time_elapsed_ms);
 
+    // Reads the rules into the spare rule table, the next execute() switches to them.
+    // May run on another task than execute(), one reload at a time
+    RulesReloadResult reloadRules(IRulesReader& reader);
+
     void forceOutput(size_t outputChannelIndex, DiscreteState state);
+    void forceOutputGroup(size_t groupIndex, DiscreteState state);
     void forceLocalOff();
 	
 	DiscreteState getInputState(size_t index) const;	
 	DiscreteState getOutputState(size_t index) const;
 
 private:
-    using PInputFilter = std::unique_ptr<InputFilterAc>;
-	
-	void logEvent(int channelIndex, EventType event);
-	void logOutputChange(int channelIndex, DiscreteState state);
+    static const size_t _maxEventQueueCount = 4;
+    static const size_t _edgeBatchSize = 16;
 
     bool initializeFilters();
     bool readRules();
+    void applyOutputGroups();
 
     void readInputs(int time_elapsed_ms);
+    void feedEdges();
     void detectEvents(int time_elapsed_ms);
     void manageActions(int time_elapsed_ms);
     void writeOutputs();
+    void writeOutput(size_t channelIndex, bool force);
     void sendEvents();
     void sendGlobalOff();
+
+    template <typename F>
+    void forEachEvent(F handler) const;
 	
 	LoggerHelper _logger;
 
@@ -68,8 +109,10 @@ private:
     IOutputDevice* _outputDevice_p = nullptr;
 
     IRulesReader* _rulesReader_p = nullptr;
+    const OutputGroupList* _outputGroups_p = nullptr;
     IGlobalOffSender* _globalOffSender_p = nullptr;
     IEventSender* _eventSender_p = nullptr;
+    TickProfiler* _profiler_p = nullptr;
 
     ActionManager _actionManager;
     EventDetector _eventDetector;
@@ -77,9 +120,31 @@ private:
     size_t _inputChannelCount = 0;
     size_t _outputChannelCount = 0;
 
+    InputFilterKind _inputFilterKind = InputFilterKind::acWindow;
+    std::map<size_t, InputFilterSettings> _inputFilterSettings;
+    int _inputFilterPeriod_msec = 75;
+    int _nominalFrequency_hz = 50;
+    GestureTimes _gestureTimes;
+
 	
-    std::vector<PInputFilter> _inputFilters;
+    InputFilterBank _inputFilters;
+    bool _hasEdgeFilters = false;
+
+    // Raw input frame of the tick
+    BitUtils::Word _rawOnWords[InputFilterBank::maxWordCount];
+    BitUtils::Word _rawKnownWords[InputFilterBank::maxWordCount];
 	std::vector<DiscreteState> _lastInputStates;
 	std::vector<DiscreteState> _lastOutputStates;
+
+	// Inputs whose filtered state changed since the last event detection
+	std::vector<BitUtils::Word> _changedInputs;
+	bool _hasChangedInputs = false;
+	bool _isOutputRefreshNeeded = true;
+
+	uint32_t _time_msec = 0;
+
 	std::list<IInputEventListener*> _inputEventListeners;
+	InputEventQueue* _eventQueues[_maxEventQueueCount];
+	size_t _eventQueueCount = 0;
+	OutputChangeQueue* _outputChangeQueue_p = nullptr;
 };
@@ -1,24 +1,45 @@
+#include <list>
+#include <map>
+
 #include "log_utils.h"
+#include "string_utils.h"
 
 #include "default_settings.h"
 #include "light_controller.h"
 #include "inputs.h"
 #include "outputs.h"
 #include "rules_reader.h"
+#include "rules_cache.h"
 #include "channels.h"
 #include "channels_reader.h"
+#include "output_groups.h"
+#include "output_groups_reader.h"
 #include "standard_resolvers.h"
+#include "gpio_interrupt_source.h"
+#include "i2c_engine.h"
+#include "expander_map.h"
+#include "spsc_queue.h"
+#include "input_event_queue.h"
+#include "tick_profiler.h"
+#include "input_capture.h"
 
 #include "main_stuff.h" 
 
 static const String inputChannelParamsFilename = "/input_channels.txt";
 static const String outputChannelParamsFilename = "/output_channels.txt";
 static const String rulesParamsFilename = "/rules.txt";
+static const String rulesCacheFilename = "/rules.bin";
+static const String expandersParamsFilename = "/expanders.txt";
+static const String outputGroupsParamsFilename = "/output_groups.txt";
 
 static LightController lightController;
 static InputDevice inputDevice;
+static GpioInterruptSource inputInterrupt;
 static OutputDevice outputDevice; 
+static I2cEngine i2cEngine;
+static ExpanderMap expanderMap;
 static RulesTextReader rulesReader; 
+static RulesCacheReader rulesCache;
 
 static InputChannelList inputChannelParams;
 static OutputChannelList outputChannelParams;
@@ -26,20 +47,77 @@ static OutputChannelList outputChannelParams;
 static ChannelsReader<InputChannelInfo> inputChannelParamsReader;
 static ChannelsReader<OutputChannelInfo> outputChannelParamsReader;
 
+static OutputGroupList outputGroups;
+static OutputGroupsReader outputGroupsReader;
+
 static StandardResolvers standardResolvers;
 
 static DefaultSettingsCreator defSettingsCreator;
 
+static TickProfiler tickProfiler;
+
+// Allocated on the first start, the capture keeps its records until the next one
+static const size_t inputCaptureSize_psram = 1024 * 1024;
+static const size_t inputCaptureSize_heap = 32 * 1024;
+
+static InputCapture inputCapture;
+static uint8_t inputCaptureBytes[InputCapture::maxExpanderCount];
+
+static uint32_t readCycleCount()
+{
+	return ESP.getCycleCount();
+}
+
+struct ControlCommand
+{
+	enum class Kind
+	{
+		setOutput,
+		setGroup,
+		localOff
+	};
+	
+	Kind kind;
+	size_t channelIndex; // Group index for setGroup
+	DiscreteState state;
+};
+
+// Network task -> control task
+static SpscQueue<ControlCommand, 16> commandQueue;
+
+// Control task -> network task, delivered to inputEventListeners and logged by dispatchEvents()
+static InputEventQueue listenerEventQueue;
+static std::list<IInputEventListener*> inputEventListeners;
+
+// Control task -> network task, logged by dispatchEvents()
+static OutputChangeQueue outputChangeQueue;
+
+// The records of the control task are logged on the network task, off the logger lock of the tick
+static LoggerHelper eventLogger;
+static uint32_t loggedDroppedEventCount = 0;
+static uint32_t loggedDroppedOutputChangeCount = 0;
+
 void LightControllerFacade::registerInputEventListener(IInputEventListener& listener)
 {
-	lightController.registerInputEventListener(listener);
+	inputEventListeners.push_back(&listener);
 }
 
 void LightControllerFacade::unregisterInputEventListener(IInputEventListener& listener)
 {
-	lightController.unregisterInputEventListener(listener);	
+	inputEventListeners.remove(&listener);	
 }		
 
+bool LightControllerFacade::registerInputEventQueue(InputEventQueue& queue)
+{
+	const auto result = lightController.addEventQueue(queue);
+	return result;
+}
+
+void LightControllerFacade::unregisterInputEventQueue(InputEventQueue& queue)
+{
+	lightController.removeEventQueue(queue);
+}
+
 size_t LightControllerFacade::getInputCount() const
 {
 	const auto result = lightController.getInputCount();
@@ -131,15 +209,169 @@ bool LightControllerFacade::setOutputState(const std::string& name, DiscreteStat
 		return false;
 	}
 		
-	lightController.forceOutput(indx, value);
-	return true;
+	ControlCommand command;
+	
+	command.kind = ControlCommand::Kind::setOutput;
+	command.channelIndex = indx;
+	command.state = value;
+	
+	const auto ok = commandQueue.push(command);
+	return ok;
+}
+	
+void LightControllerFacade::getOutputGroupNames(std::function<void(const std::string* name_p)> inserter) const
+{
+	const auto groupCount = outputGroups.getGroupCount();
+	for (size_t i = 0; i < groupCount; ++i)
+	{
+		inserter(&outputGroups.getGroupName(i));
+	}
+}
+
+bool LightControllerFacade::isOutputGroupExists(const std::string& name) const
+{
+	size_t indx;
+	const auto result = outputGroups.resolveChannelName(name, indx);
+	return result;
+}
+
+DiscreteState LightControllerFacade::getOutputGroupState(const std::string& name) const
+{
+	size_t indx;
+	const auto ok = outputGroups.resolveChannelName(name, indx);
+	if (!ok)
+	{
+		return DiscreteState::unknown;
+	}
+	
+	auto isAllOff = true;
+	
+	for (const auto channelIndex : outputGroups.getGroupOutputs(indx))
+	{
+		const auto state = lightController.getOutputState(channelIndex);
+		if (state == DiscreteState::on)
+		{
+			return DiscreteState::on;
+		}
+		
+		isAllOff = isAllOff && (state == DiscreteState::off);
+	}
+	
+	return isAllOff ? DiscreteState::off : DiscreteState::unknown;
+}
+
+bool LightControllerFacade::setOutputGroupState(const std::string& name, DiscreteState value)
+{
+	size_t indx;
+	auto result = outputGroups.resolveChannelName(name, indx);
+	if (!result)
+	{
+		return false;
+	}
+		
+	ControlCommand command;
+	
+	command.kind = ControlCommand::Kind::setGroup;
+	command.channelIndex = indx;
+	command.state = value;
+	
+	const auto ok = commandQueue.push(command);
+	return ok;
 }
 	
 bool LightControllerFacade::localOff()
 {	
-	lightController.forceLocalOff();
+	ControlCommand command;
+	
+	command.kind = ControlCommand::Kind::localOff;
+	command.channelIndex = 0;
+	command.state = DiscreteState::off;
+	
+	const auto ok = commandQueue.push(command);
+	return ok;
+}
+
+// Straight from the rules text: the channel lists stay as read on start, so the rules
+// cache is left for the next start to rebuild
+RulesReloadResult LightControllerFacade::reloadRules()
+{
+	auto result = lightController.reloadRules(rulesReader);
+	
+	// The control task takes the rules of the previous reload on its next tick
+	for (auto i = 0; (i < 10) && (result == RulesReloadResult::busy) && (_controlTask != nullptr); ++i)
+	{
+		vTaskDelay(pdMS_TO_TICKS(_controlPeriod_msec) + 1);
+		result = lightController.reloadRules(rulesReader);
+	}
+	
+	return result;
+}
+
+void LightControllerFacade::notifyFileWritten(const String& path)
+{
+	if (path != rulesParamsFilename)
+	{
+		return;
+	}
+	
+	// Failures are logged by the light controller, the previous rules keep running then
+	reloadRules();
+}
+
+const TickProfiler& LightControllerFacade::getProfiler() const
+{
+	return tickProfiler;
+}
+
+void LightControllerFacade::resetProfiler()
+{
+	tickProfiler.requestReset();
+}
+
+bool LightControllerFacade::startInputCapture()
+{
+	if (!inputCapture.hasBuffer())
+	{
+		const auto isPsram = psramFound();
+		const auto size = isPsram ? inputCaptureSize_psram : inputCaptureSize_heap;
+		
+		const auto buffer_p = static_cast<uint8_t*>(isPsram ? ps_malloc(size) : malloc(size));
+		if (buffer_p == nullptr)
+		{
+			return false;
+		}
+		
+		inputCapture.setBuffer(buffer_p, size);
+	}
+	
+	inputCapture.requestStart();
 	return true;
 }
+
+bool LightControllerFacade::stopInputCapture()
+{
+	inputCapture.requestStop();
+	
+	if (_controlTask == nullptr)
+	{
+		// loop() runs on this task
+		inputCapture.update();
+		return true;
+	}
+	
+	// The control task stops on its next tick
+	for (auto i = 0; (i < 10) && !inputCapture.isStopped(); ++i)
+	{
+		vTaskDelay(pdMS_TO_TICKS(_controlPeriod_msec) + 1);
+	}
+	
+	return inputCapture.isStopped();
+}
+
+const InputCapture& LightControllerFacade::getInputCapture() const
+{
+	return inputCapture;
+}
 	
 bool LightControllerFacade::initialize(ILogger* logger_p, FS* fileSystem_p, bool initializeDefaults)
 {
@@ -155,6 +387,8 @@ bool LightControllerFacade::initialize(ILogger* logger_p, FS* fileSystem_p, bool
 		defSettingsCreator.setInputsFilename(inputChannelParamsFilename);
 		defSettingsCreator.setOutputsFilename(outputChannelParamsFilename);
 		defSettingsCreator.setRulesFilename(rulesParamsFilename);
+		defSettingsCreator.setExpandersFilename(expandersParamsFilename);
+		defSettingsCreator.setOutputGroupsFilename(outputGroupsParamsFilename);
 		defSettingsCreator.setOverwriteIfExists(true);
 		if (!defSettingsCreator.execute())
 		{
@@ -162,9 +396,46 @@ bool LightControllerFacade::initialize(ILogger* logger_p, FS* fileSystem_p, bool
 			return false;
 		}
 	}
+	else
+	{
+		if (!fileSystem_p->exists(expandersParamsFilename))
+		{
+			// Settings made before the expander map existed
+			DefaultSettingsCreator expandersCreator;
+			
+			expandersCreator.setLogger(&logger);
+			expandersCreator.setFileSystem(fileSystem_p);
+			expandersCreator.setExpandersFilename(expandersParamsFilename);
+			expandersCreator.execute();
+		}
+		
+		if (!fileSystem_p->exists(outputGroupsParamsFilename))
+		{
+			// Settings made before the output groups existed
+			DefaultSettingsCreator groupsCreator;
+			
+			groupsCreator.setLogger(&logger);
+			groupsCreator.setFileSystem(fileSystem_p);
+			groupsCreator.setOutputGroupsFilename(outputGroupsParamsFilename);
+			groupsCreator.execute();
+		}
+	}
 	
 	auto ok = true;
 	
+	logger.trace("Reading I2C expanders map");
+	
+	expanderMap.setLogger(logger_p);
+	expanderMap.setFileSystem(fileSystem_p);
+	expanderMap.setFilename(expandersParamsFilename);
+	if (!expanderMap.read())
+	{
+		logger.error("Reading I2C expanders map failed", ILogger::ErrorSeverity::error);
+		ok = false;
+	}
+	
+	expanderMap.scan();
+	
 	logger.trace("Reading input channels parameters");	
 	
 	inputChannelParamsReader.setChannelList(&inputChannelParams);
@@ -186,43 +457,126 @@ bool LightControllerFacade::initialize(ILogger* logger_p, FS* fileSystem_p, bool
 		logger.error("Reading output channels parameters failed", ILogger::ErrorSeverity::error);
 		ok = false;
 	}
+	
+	logger.trace("Reading output groups");
+	
+	outputGroupsReader.setLogger(logger_p);
+	outputGroupsReader.setGroupList(&outputGroups);
+	outputGroupsReader.setOutputChannelResolver(&outputChannelParams);
+	outputGroupsReader.setFileSystem(fileSystem_p);
+	outputGroupsReader.setFilename(outputGroupsParamsFilename);
+	if (!outputGroupsReader.execute())
+	{
+		logger.error("Reading output groups failed", ILogger::ErrorSeverity::error);
+		ok = false;
+	}
 			
 	rulesReader.setLogger(logger_p);
 	rulesReader.setInputChannelResolver(&inputChannelParams);
 	rulesReader.setOutputChannelResolver(&outputChannelParams);
 	rulesReader.setEventResolver(&standardResolvers);
 	rulesReader.setActionResolver(&standardResolvers);
+	rulesReader.setOutputGroupResolver(&outputGroups);
 	rulesReader.setFilename(rulesParamsFilename);
 	rulesReader.setFileSystem(fileSystem_p);
 	
+	rulesCache.setLogger(logger_p);
+	rulesCache.setSourceReader(&rulesReader);
+	rulesCache.setFilename(rulesCacheFilename);
+	rulesCache.setFileSystem(fileSystem_p);
+	rulesCache.addSourceFilename(rulesParamsFilename);
+	rulesCache.addSourceFilename(inputChannelParamsFilename);
+	rulesCache.addSourceFilename(outputChannelParamsFilename);
+	rulesCache.addSourceFilename(outputGroupsParamsFilename);
+	
 	logger.trace("Initializing input channels");	
 	inputDevice.setLogger(logger_p);
+	inputDevice.setPinMap(expanderMap.getInputPins());
+	
+	auto acFilterKind = InputFilterKind::acWindow;
+	
+	if (_inputInterruptPin >= 0)
+	{
+		if (inputInterrupt.begin(_inputInterruptPin))
+		{
+			inputDevice.setInterruptSource(&inputInterrupt);
+			
+			// The bus task samples the inputs on every interrupt, which timestamps each edge
+			acFilterKind = InputFilterKind::acEdge;
+		}
+		else
+		{
+			logger.error("Input interrupt initialization failed, polling inputs", ILogger::ErrorSeverity::warning);
+		}
+	}
+	
 	if (!inputDevice.initialize())
 	{
 		logger.error("Input device initialization failed", ILogger::ErrorSeverity::error);
 		ok = false;
 	}
 	
+	inputCapture.setLayout(inputDevice.getExpanderCount(), inputDevice.getChannelCount());
+	
+	for (size_t i = 0; i < inputDevice.getChannelCount(); ++i)
+	{
+		ExpanderChannel pin;
+		if (inputDevice.getChannelPin(i, pin))
+		{
+			inputCapture.setChannelPin(i, static_cast<uint8_t>(pin.expanderIndex), static_cast<uint8_t>(pin.channelNumber));
+		}
+	}
+	
 	logger.trace("Initializing output channels");	
 	outputDevice.setLogger(logger_p);
+	outputDevice.setPinMap(expanderMap.getOutputPins());
 	if (!outputDevice.initialize())
 	{
 		logger.error("Output device initialization failed", ILogger::ErrorSeverity::error);
 		ok = false;
 	}
 	
+	inputDevice.setI2cEngine(&i2cEngine);
+	outputDevice.setI2cEngine(&i2cEngine);
+	
 	const auto inputCount = inputDevice.getChannelCount();
 	const auto outputCount = outputDevice.getChannelCount();
 		
 	lightController.setLogger(logger_p);
+	eventLogger.setLogger(logger_p);
 	
 	lightController.setInputCount(inputCount);
 	lightController.setOutputCount(outputCount);
 	
+	lightController.setInputFilterKind(acFilterKind);
+	
+	for (size_t i = 0; i < inputCount; ++i)
+	{
+		// Channels missing from the list get the AC detector
+		InputChannelInfo info;
+		inputChannelParams.getChannelInfo(i, info);
+		
+		auto filter = info.filter;
+		if (filter.kind == InputFilterKind::acWindow)
+		{
+			filter.kind = acFilterKind;
+		}
+		
+		lightController.setInputFilterSettings(i, filter);
+	}
+	
 	lightController.setInputDevice(&inputDevice);
 	lightController.setOutputDevice(&outputDevice);
 	
-	lightController.setRulesReader(&rulesReader);
+	lightController.setRulesReader(&rulesCache);
+	lightController.setOutputGroups(&outputGroups);
+	
+	// The control task stays on one core, so the core cycle counter is monotonic for it
+	tickProfiler.setClock(readCycleCount, getCpuFrequencyMhz());
+	lightController.setProfiler(&tickProfiler);
+	lightController.removeEventQueue(listenerEventQueue);
+	lightController.addEventQueue(listenerEventQueue);
+	lightController.setOutputChangeQueue(&outputChangeQueue);
 			
 	logger.trace("Initializing rules manager");
 	if (!lightController.initialize())
@@ -236,7 +590,168 @@ bool LightControllerFacade::initialize(ILogger* logger_p, FS* fileSystem_p, bool
 
 void LightControllerFacade::loop(int timeElapsed_msec)
 {
-	inputDevice.update();
+	ControlCommand command;
+	while (commandQueue.pop(command))
+	{
+		switch (command.kind)
+		{
+			case ControlCommand::Kind::setOutput:
+				lightController.forceOutput(command.channelIndex, command.state);
+				break;
+			
+			case ControlCommand::Kind::setGroup:
+				lightController.forceOutputGroup(command.channelIndex, command.state);
+				break;
+			
+			case ControlCommand::Kind::localOff:
+				lightController.forceLocalOff();
+				break;
+			
+			default:
+				break;
+		}
+	}
+	
+	ProfileScope tickScope(&tickProfiler, TickProfiler::Stage::tick);
+	
+	// Expander reads and writes queued on the previous tick
+	i2cEngine.dispatchCompletions();
+	
+	{
+		ProfileScope scope(&tickProfiler, TickProfiler::Stage::inputDeviceUpdate);
+		inputDevice.update(timeElapsed_msec);
+	}
+	
+	// The raw input of this tick
+	if (inputCapture.update())
+	{
+		uint16_t connectedMask;
+		inputDevice.readExpanderBytes(inputCaptureBytes, connectedMask);
+		
+		inputCapture.record(timeElapsed_msec, inputCaptureBytes, connectedMask);
+	}
+	
 	lightController.execute(timeElapsed_msec);
-	outputDevice.update();
-}
\ No newline at end of file
+	
+	{
+		ProfileScope scope(&tickProfiler, TickProfiler::Stage::outputDeviceUpdate);
+		outputDevice.update(timeElapsed_msec);
+	}
+	
+	i2cEngine.flush();
+}
+
+static void logInputEvent(const InputEventRecord& record)
+{
+	static const std::map<EventType, std::string> eventTexts = 
+	{
+		{ EventType::none,        "none"},
+		{ EventType::fall,        "fall"},
+		{ EventType::rise,        "rise"},
+		{ EventType::click,       "click"},
+		{ EventType::doubleClick, "double click"},
+		{ EventType::longPress,   "long press"},
+		{ EventType::holdRepeat,  "hold repeat"}
+	};
+	
+	eventLogger.info("Input " + StringUtils::toString(record.channelIndex) + ", " + eventTexts.at(record.event) + " detected");
+}
+
+static void logOutputChange(const OutputChangeRecord& record)
+{
+	static const std::map<DiscreteState, std::string> stateTexts = 
+	{
+		{ DiscreteState::unknown, "UNKNOWN" },
+		{ DiscreteState::on,      "ON"      },
+		{ DiscreteState::off,     "OFF"     }
+	};
+	
+	eventLogger.info("Output " + StringUtils::toString(record.channelIndex) + " switched to " + stateTexts.at(record.state));
+}
+
+// Logs the records dropped since the last call, if any
+static void logDroppedCount(const char* what, uint32_t droppedCount, uint32_t& loggedCount)
+{
+	if (droppedCount == loggedCount)
+	{
+		return;
+	}
+	
+	LogError msg(eventLogger, ILogger::ErrorSeverity::warning);
+	
+	msg.addText(what);
+	msg.addText(" dropped: ");
+	msg.addText(StringUtils::toString(droppedCount - loggedCount));
+	
+	loggedCount = droppedCount;
+}
+
+void LightControllerFacade::dispatchEvents()
+{
+	InputEventRecord record;
+	while (listenerEventQueue.pop(record))
+	{
+		logInputEvent(record);
+		
+		for (auto listener_p : inputEventListeners)
+		{
+			listener_p->inputEventNotification(record.channelIndex, record.event);
+		}
+	}
+	
+	OutputChangeRecord change;
+	while (outputChangeQueue.pop(change))
+	{
+		logOutputChange(change);
+	}
+	
+	logDroppedCount("Input events", listenerEventQueue.getDroppedCount(), loggedDroppedEventCount);
+	logDroppedCount("Output changes", outputChangeQueue.getDroppedCount(), loggedDroppedOutputChangeCount);
+}
+
+bool LightControllerFacade::startControlTask(int core, int priority, int period_msec)
+{
+	if (_controlTask != nullptr)
+	{
+		return false;
+	}
+	
+	_controlPeriod_msec = period_msec;
+	
+	// Expander transactions run in their own task next to the control one.
+	// If it cannot be created the engine executes them at the end of each tick
+	// and the acEdge filters get no edge times, only the changes the ticks see
+	if (i2cEngine.start(core, priority + 1))
+	{
+		inputInterrupt.setNotifiedTask(i2cEngine.getTask());
+	}
+	
+	const auto result = xTaskCreatePinnedToCore(&LightControllerFacade::controlTask, "light_control", 8192, this, priority, &_controlTask, core);
+	if (result != pdPASS)
+	{
+		_controlTask = nullptr;
+		return false;
+	}
+	
+	return true;
+}
+
+void LightControllerFacade::controlTask(void* arg_p)
+{
+	auto facade_p = static_cast<LightControllerFacade*>(arg_p);
+	
+	const auto period = pdMS_TO_TICKS(facade_p->_controlPeriod_msec);
+	auto lastWake = xTaskGetTickCount();
+	auto lastMillis = millis();
+	
+	for (;;)
+	{
+		vTaskDelayUntil(&lastWake, period > 0 ? period : 1);
+		
+		const auto curMillis = millis();
+		const int elapsed_msec = curMillis - lastMillis;
+		lastMillis = curMillis;
+		
+		facade_p->loop(elapsed_msec);
+	}
+}
@@ -8,6 +8,9 @@
 
 #include <FS.h>
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
 #include "types.h"
 
 class LightControllerFacade : public ILightControllerFacade
@@ -16,6 +19,9 @@ public:
 	void registerInputEventListener(IInputEventListener& listener) override;
 	void unregisterInputEventListener(IInputEventListener& listener) override;
 	
+	bool registerInputEventQueue(InputEventQueue& queue) override;
+	void unregisterInputEventQueue(InputEventQueue& queue) override;
+	
 	size_t getInputCount() const override;
 	virtual size_t getOutputCount() const override;
 	
@@ -30,8 +36,48 @@ public:
 	DiscreteState getOutputState(const std::string& name) const override;
 	bool setOutputState(const std::string& name, DiscreteState value) override;
 	
+	void getOutputGroupNames(std::function<void(const std::string* name_p)> inserter) const override;
+	bool isOutputGroupExists(const std::string& name) const override;
+	
+	DiscreteState getOutputGroupState(const std::string& name) const override;
+	bool setOutputGroupState(const std::string& name, DiscreteState value) override;
+	
 	bool localOff() override;
 	
+	RulesReloadResult reloadRules() override;
+	
+	// Reloads the rules if the file is the rules file, for the FTP server
+	void notifyFileWritten(const String& path);
+	
+	const TickProfiler& getProfiler() const override;
+	void resetProfiler() override;
+	
+	bool startInputCapture() override;
+	bool stopInputCapture() override;
+	const InputCapture& getInputCapture() const override;
+	
+	void setInputInterruptPin(int value) { _inputInterruptPin = value; }
+	
 	bool initialize(ILogger* logger_p, FS* fileSystem_p, bool initializeDefaults);
 	void loop(int timeElapsed_msec);
+	
+	// Calls loop() every period_msec from a task pinned to the core, the I2C transactions
+	// of the expanders run in another task on the same core.
+	// Output commands and input events then cross between the tasks through lock-free queues.
+	// The bus task gets priority + 1; to keep the tick free of network jitter the priority
+	// must be above the TCP/IP and network driver tasks that may run on the core
+	bool startControlTask(int core, int priority, int period_msec);
+	bool isControlTaskRunning() const { return _controlTask != nullptr; }
+	
+	// Delivers queued input events to the registered listeners and logs them with the output changes,
+	// to be called from the network task
+	void dispatchEvents();
+	
+private:
+	static void controlTask(void* arg_p);
+	
+	int _inputInterruptPin = -1;
+	
+	TaskHandle_t _controlTask = nullptr;
+	int _controlPeriod_msec = 5;
 };
\ No newline at end of file
@@ -1,3 +1,7 @@
+#include <cstring>
+
+#include "string_utils.h"
+
 #include "mqtt_control.h"
 
 MqttControl::MqttControl()
@@ -24,45 +28,38 @@ void MqttControl::setLightController(ILightControllerFacade* value_p)
 {  
 	if (_lightController_p != nullptr) 
 	{
-		_lightController_p->unregisterInputEventListener(*this);
+		_lightController_p->unregisterInputEventQueue(_eventQueue);
 	}
 		
 	_lightController_p = value_p; 
 	
 	if (_lightController_p != nullptr)
 	{
-		_lightController_p->registerInputEventListener(*this);
-	}
-}
-
-void MqttControl::inputEventNotification(size_t channelIndex, EventType event)
-{
-	if (_inputEvents.size() < _maxEventCount)
-	{
-		InputEventInfo info;
-		
-		info.channelIndex = channelIndex;
-		info.event = event;
-		 
-		_inputEvents.push_back(info);
+		if (!_lightController_p->registerInputEventQueue(_eventQueue))
+		{
+			_logger.error("MqttControl: Failed to subscribe to input events", ILogger::ErrorSeverity::error);
+		}
 	}
 }
 
-void MqttControl::prepareMessage(std::ostream& stream) const
+void MqttControl::prepareMessage(std::ostream& stream, uint32_t droppedCount) const
 {
 /* JSON message example
 {
   "source-id": "light.bedroom",
   "source-ip": "192.168.1.6",
   "timestamp": 321,
+  "dropped-events": 0,
   "events": [
       {
         "channel-index": 0,
-        "event": "rise"
+        "event": "rise",
+        "time": 300
       },
       {
         "channel": 1,
-        "event": "fall"
+        "event": "fall",
+        "time": 315
       }
     ]
 }
@@ -84,6 +81,11 @@ void MqttControl::prepareMessage(std::ostream& stream) const
 		stream << "\"timestamp\":\"" << _timestamp << "\",";
 	}
 	
+	if (droppedCount != 0)
+	{
+		stream << "\"dropped-events\":" << droppedCount << ",";
+	}
+	
 	stream << "\"events\":[";
 	
 	for (const auto& eventInfo : _inputEvents)
@@ -99,6 +101,22 @@ void MqttControl::prepareMessage(std::ostream& stream) const
 			sEvent = "fall";
 			break;
 			
+			case EventType::click:
+			sEvent = "click";
+			break;
+			
+			case EventType::doubleClick:
+			sEvent = "double_click";
+			break;
+			
+			case EventType::longPress:
+			sEvent = "long_press";
+			break;
+			
+			case EventType::holdRepeat:
+			sEvent = "hold_repeat";
+			break;
+			
 			default:
 			continue;
 		}
@@ -106,6 +124,7 @@ void MqttControl::prepareMessage(std::ostream& stream) const
 		stream << "{";
 		stream << "\"channel-index\":" << eventInfo.channelIndex << ",";
 		stream << "\"event\":" << sEvent << ",";
+		stream << "\"time\":" << eventInfo.timestamp_msec;
 		stream << "}";		
 	}
 	
@@ -114,17 +133,34 @@ void MqttControl::prepareMessage(std::ostream& stream) const
 
 void MqttControl::sendEvents()
 {	
-	if (_inputEvents.empty())
+	const auto droppedCount = _eventQueue.getDroppedCount();
+	const auto newDroppedCount = droppedCount - _reportedDroppedCount;
+	
+	if (_eventQueue.empty() && (newDroppedCount == 0))
 	{
 		return;
 	}
 	
+	_inputEvents.clear();
+	
+	InputEventRecord record;
+	while ((_inputEvents.size() < _maxEventCount) && _eventQueue.pop(record))
+	{
+		_inputEvents.push_back(record);
+	}
+	
 	_stringStream.str(std::string());
-	prepareMessage(_stringStream);
+	prepareMessage(_stringStream, newDroppedCount);
 	_inputEvents.clear();
 	
 	_mqttClient.publish(_inputControlTopic.c_str(), 0, false, _stringStream.str().c_str());
 	
+	if (newDroppedCount != 0)
+	{
+		_logger.error("MqttControl: " + StringUtils::toString(newDroppedCount) + " event(s) dropped", ILogger::ErrorSeverity::warning);
+		_reportedDroppedCount = droppedCount;
+	}
+	
 	_logger.info("MqttControl: Event(s) published");
 }
 
@@ -267,22 +303,96 @@ void MqttControl::onMqttUnsubscribe(uint16_t packetId)
 	
 }
 
-void MqttControl::onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total) {
-	/*Serial.println("Publish received.");
-	Serial.print("  topic: ");
-	Serial.println(topic);
-	Serial.print("  qos: ");
-	Serial.println(properties.qos);
-	Serial.print("  dup: ");
-	Serial.println(properties.dup);
-	Serial.print("  retain: ");
-	Serial.println(properties.retain);
-	Serial.print("  len: ");
-	Serial.println(len);
-	Serial.print("  index: ");
-	Serial.println(index);
-	Serial.print("  total: ");
-	Serial.println(total);*/
+void MqttControl::onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total) 
+{
+	if (_outputControlTopic != topic)
+	{
+		return;
+	}
+	
+	// Commands are short, they arrive in one piece
+	if ((index != 0) || (len != total) || (len > _maxCommandLength))
+	{
+		_logger.error("MqttControl: Command is too long", ILogger::ErrorSeverity::warning);
+		return;
+	}
+	
+	CommandMessage message;
+	
+	memcpy(message.text, payload, len);
+	message.text[len] = '\0';
+	
+	if (!_commandQueue.push(message))
+	{
+		_logger.error("MqttControl: Command dropped", ILogger::ErrorSeverity::warning);
+	}
+}
+
+void MqttControl::processCommands()
+{
+	CommandMessage message;
+	while (_commandQueue.pop(message))
+	{
+		const std::string text(message.text);
+		
+		if (!applyCommand(text))
+		{
+			_logger.error("MqttControl: Invalid command: " + text, ILogger::ErrorSeverity::warning);
+		}
+	}
+}
+
+bool MqttControl::applyCommand(const std::string& text)
+{
+	if (_lightController_p == nullptr)
+	{
+		return false;
+	}
+	
+	std::vector<std::string> words;
+	
+	size_t pos = 0;
+	std::string word;
+	
+	while (StringUtils::nextWord(text, pos, word) && (words.size() < 4))
+	{
+		words.push_back(word);
+	}
+	
+	const auto isGroup = (words.size() == 3) && StringUtils::equal(words[0], "group");
+	if (!isGroup && (words.size() != 2))
+	{
+		return false;
+	}
+	
+	const auto& name = words[words.size() - 2];
+	const auto& sState = words[words.size() - 1];
+	
+	auto state = DiscreteState::unknown;
+	
+	if (StringUtils::equal(sState, "on"))
+	{
+		state = DiscreteState::on;
+	}
+	else if (StringUtils::equal(sState, "off"))
+	{
+		state = DiscreteState::off;
+	}
+	else
+	{
+		return false;
+	}
+	
+	const auto ok = isGroup ? 
+		_lightController_p->setOutputGroupState(name, state) : 
+		_lightController_p->setOutputState(name, state);
+		
+	if (ok)
+	{
+		_logger.info("MqttControl: Command applied: " + text);
+	}
+	
+	return ok;
 }
 
 void MqttControl::onMqttPublish(uint16_t packetId) {
@@ -14,8 +14,10 @@
 
 #include "types.h"
 #include "log_utils.h"
+#include "input_event_queue.h"
+#include "spsc_queue.h"
 
-class MqttControl : public IInputEventListener
+class MqttControl
 {
 public:
 	MqttControl();
@@ -51,26 +53,30 @@ public:
 	size_t getTimestamp() const { return _timestamp; }
 	void setTimestamp(size_t value) { _timestamp = value; }
 	
+	// Maximal number of events in one message
 	size_t getMaxEventCount() const { return _maxEventCount; }
 	void setMaxEventCount(size_t value) { _maxEventCount = value; }
 	
+	// Events lost because they were not sent in time
+	uint32_t getDroppedEventCount() const { return _eventQueue.getDroppedCount(); }
+	
 	size_t getMaxMessageSize() const { return _maxMessageSize; }
 	void setMaxMessageSize(size_t value) { _maxMessageSize = value; }
 	
 	void sendEvents();
 	
+	// Applies the commands received on the output control topic, a command per message:
+	//     OUTPUT_CHANNEL on|off
+	//     group GROUP_NAME on|off
+	// To be called from the network task, the messages arrive on the MQTT client task
+	void processCommands();
+	
 	bool connect();
 	void disconnect();
 	
 	bool isConnected() const { return _state == State::connected; }
 	
 private:	
-	struct InputEventInfo
-	{
-		size_t channelIndex;
-		EventType event;
-	};
-	
 	enum class State
 	{
 		disconnected,
@@ -79,11 +85,9 @@ private:
 		disconnecting
 	};
 	
-using InputMessages = std::vector<InputEventInfo>;
-	
-	void prepareMessage(std::ostream& stream) const;
+using InputMessages = std::vector<InputEventRecord>;
 	
-	void inputEventNotification(size_t channelIndex, EventType event) override;
+	void prepareMessage(std::ostream& stream, uint32_t droppedCount) const;
 	
 	void onMqttConnect(bool sessionPresent);
 	void onMqttDisconnect(AsyncMqttClientDisconnectReason reason);
@@ -91,6 +95,15 @@ using InputMessages = std::vector<InputEventInfo>;
 	void onMqttUnsubscribe(uint16_t packetId);
 	void onMqttMessage(char* topic, char* payload, AsyncMqttClientMessageProperties properties, size_t len, size_t index, size_t total);
 	void onMqttPublish(uint16_t packetId);
+	
+	bool applyCommand(const std::string& text);
+	
+	static const size_t _maxCommandLength = 95;
+	
+	struct CommandMessage
+	{
+		char text[_maxCommandLength + 1];
+	};
 		
 	mutable LoggerHelper _logger;
 	ILightControllerFacade* _lightController_p = nullptr;
@@ -113,7 +126,13 @@ using InputMessages = std::vector<InputEventInfo>;
 	
 	AsyncMqttClient _mqttClient;
 	
+	InputEventQueue _eventQueue;
+	
+	// MQTT client task -> network task
+	SpscQueue<CommandMessage, 8> _commandQueue;
+	
 	InputMessages _inputEvents;
+	uint32_t _reportedDroppedCount = 0;
 	
 	std::stringstream _stringStream;
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "string_utils.h"
+#include "bit_utils.h"
+
+#include "output_groups.h"
+
+OutputGroupList::ParseResult OutputGroupList::parseGroup(const std::string& line, const IChannelNameResolver& outputResolver)
+{
+    size_t pos = 0;
+    std::string name;
+
+    if (!StringUtils::nextWord(line, pos, name))
+    {
+        return ParseResult::syntaxError;
+    }
+
+    std::vector<size_t> outputs;
+    std::string curWord;
+
+    while (StringUtils::nextWord(line, pos, curWord))
+    {
+        size_t channelIndex;
+        if (!outputResolver.resolveChannelName(curWord, channelIndex))
+        {
+            return ParseResult::invalidOutput;
+        }
+
+        outputs.push_back(channelIndex);
+    }
+
+    if (outputs.empty())
+    {
+        return ParseResult::syntaxError;
+    }
+
+    size_t groupIndex;
+    if (resolveChannelName(name, groupIndex))
+    {
+        return ParseResult::duplicateName;
+    }
+
+    if (!addGroup(name, outputs))
+    {
+        return ParseResult::tooManyGroups;
+    }
+
+    return ParseResult::success;
+}
+
+bool OutputGroupList::addGroup(const std::string& name, const std::vector<size_t>& outputChannelIndexes)
+{
+    if (_groups.size() >= maxGroupCount)
+    {
+        return false;
+    }
+
+    Group group;
+
+    group.name = name;
+    group.outputChannelIndexes = outputChannelIndexes;
+
+    _groups.push_back(group);
+    return true;
+}
+
+void OutputGroupList::getGroupMask(size_t groupIndex, uint32_t* mask_out, size_t wordCount) const
+{
+    for (size_t w = 0; w < wordCount; ++w)
+    {
+        mask_out[w] = 0;
+    }
+
+    for (const auto channelIndex : _groups[groupIndex].outputChannelIndexes)
+    {
+        if (BitUtils::wordIndex(channelIndex) < wordCount)
+        {
+            BitUtils::assign(mask_out, channelIndex, true);
+        }
+    }
+}
+
+bool OutputGroupList::resolveChannelName(const std::string& channelName, size_t& channelIndex_out) const
+{
+    for (size_t i = 0; i < _groups.size(); ++i)
+    {
+        if (StringUtils::equal(_groups[i].name, channelName))
+        {
+            channelIndex_out = i;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+// Named sets of outputs, group indexes follow the order the groups were added.
+// Resolves group names for the rules and the network controls; there are few groups,
+// so they are looked up one by one
+class OutputGroupList : public IChannelNameResolver
+{
+public:
+    static const size_t maxGroupCount = 64;
+
+    enum class ParseResult
+    {
+        success,
+        syntaxError,
+        invalidOutput,
+        duplicateName,
+        tooManyGroups
+    };
+
+    // GROUP_NAME OUTPUT_CHANNEL [OUTPUT_CHANNEL]...
+    ParseResult parseGroup(const std::string& line, const IChannelNameResolver& outputResolver);
+
+    bool addGroup(const std::string& name, const std::vector<size_t>& outputChannelIndexes);
+    void clear() { _groups.clear(); }
+
+    size_t getGroupCount() const { return _groups.size(); }
+    const std::string& getGroupName(size_t groupIndex) const { return _groups[groupIndex].name; }
+    const std::vector<size_t>& getGroupOutputs(size_t groupIndex) const { return _groups[groupIndex].outputChannelIndexes; }
+
+    // Bit per output in 32-bit words, wordCount words are filled
+    void getGroupMask(size_t groupIndex, uint32_t* mask_out, size_t wordCount) const;
+
+    bool resolveChannelName(const std::string& channelName, size_t& channelIndex_out) const override;
+
+private:
+    struct Group
+    {
+        std::string name;
+        std::vector<size_t> outputChannelIndexes;
+    };
+
+    std::vector<Group> _groups;
+};
@@ -0,0 +1,67 @@
+#include <cassert>
+#include <map>
+
+#include "string_utils.h"
+
+#include "output_groups_reader.h"
+
+bool OutputGroupsReader::execute()
+{
+	assert(_fileSystem_p != nullptr);
+	assert(_groupList_p != nullptr);
+	assert(_outputChannelResolver_p != nullptr);
+	
+	_groupList_p->clear();
+	
+	auto file = _fileSystem_p->open(_filename);
+	if (!file)
+	{
+		LogError msg(_logger, ILogger::ErrorSeverity::error);
+		
+		msg.addText("Failed to open file ");
+		msg.addText(std::string(_filename.c_str()));
+		
+		return false;
+	}
+	
+	while (file.available() > 0)
+	{
+		auto line = file.readStringUntil('\n');
+		std::string s(line.c_str());
+		
+		StringUtils::trim(s);
+		
+		if (s.empty() || (s.substr(0, 2) == "//"))
+		{
+			continue;
+		}
+		
+		const auto result = _groupList_p->parseGroup(s, *_outputChannelResolver_p);
+		if (result != OutputGroupList::ParseResult::success)
+		{
+			writeInvalidGroupToLog(s, result);
+		}
+	}
+	
+	file.close();
+	return true;
+}
+
+void OutputGroupsReader::writeInvalidGroupToLog(const std::string& s, OutputGroupList::ParseResult result)
+{
+	static const std::map<OutputGroupList::ParseResult, std::string> resultTexts = 
+	{
+		{ OutputGroupList::ParseResult::syntaxError,   "syntax error"},
+		{ OutputGroupList::ParseResult::invalidOutput, "invalid output"},
+		{ OutputGroupList::ParseResult::duplicateName, "duplicate name"},
+		{ OutputGroupList::ParseResult::tooManyGroups, "too many groups"},
+	};
+	
+	LogError msg(_logger, ILogger::ErrorSeverity::warning);
+	
+	msg.addText("Invalid output group string: ");
+	msg.addText(s);
+	msg.addText(" (");
+	msg.addText(resultTexts.at(result));
+	msg.addText(")");
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "types.h"
+#include "output_groups.h"
+#include "log_utils.h"
+
+// Reads the output groups from a text file, a group per line:
+//     hallway hall_light stairs_light porch_light
+class OutputGroupsReader
+{
+public:
+	void setLogger(ILogger* value_p) { _logger.setLogger(value_p); }
+	
+	void setFilename(String value) { _filename = value; }
+	void setFileSystem(FS* value_p) { _fileSystem_p = value_p; }
+	
+	void setGroupList(OutputGroupList* value_p) { _groupList_p = value_p; }
+	void setOutputChannelResolver(IChannelNameResolver* value_p) { _outputChannelResolver_p = value_p; }
+	
+	bool execute();
+	
+private:
+	void writeInvalidGroupToLog(const std::string& s, OutputGroupList::ParseResult result);
+	
+	LoggerHelper _logger;
+	
+	String _filename;
+	FS* _fileSystem_p = nullptr;
+	
+	OutputGroupList* _groupList_p = nullptr;
+	IChannelNameResolver* _outputChannelResolver_p = nullptr;
+};
@@ -3,28 +3,22 @@
 #include "string_utils.h"
 #include "outputs.h"
 
-const uint8_t OutputDevice::_expanderAddresses[] = 
-{
-	0x24
-};
-
-const std::vector<OutputDevice::ChannelHw> OutputDevice::_channelMap = 
-{
-	{ 0, 5 },  // 1
-	{ 0, 4 },  // 2
-	{ 0, 0 },  // 3
-	{ 0, 3 },  // 4
-	{ 0, 2 },  // 5
-	{ 0, 1 },  // 6
-	{ 0, 7 },  // 7
-	{ 0, 6 }   // 8	
-};
-
 OutputDevice::OutputDevice() : 
 	IOutputDevice()
 {	
 }
 
+bool OutputDevice::setPinMap(const std::vector<ExpanderPin>& value)
+{
+	const auto ok = ExpanderMap::assignExpanders(value, _expanderAddresses, _expanderCount, _channelMap);
+	if (!ok)
+	{
+		_logger.error("Too many output I2C devices", ILogger::ErrorSeverity::error);
+	}
+	
+	return ok;
+}
+
 void OutputDevice::setCurrentValue(size_t channelIndex, DiscreteState curValue_out)
 {
 	jm_PCF8574* device_p;	
@@ -44,11 +38,36 @@ void OutputDevice::setCurrentValue(size_t channelIndex, DiscreteState curValue_o
 	device_p->digital_Write(channelNumber, state);
 }
 
-void OutputDevice::update()
+void OutputDevice::update(int timeElapsed_msec)
 {
+	// Rewrites the relays from time to time in case an expander glitched
+	auto isRefreshNeeded = false;
+	if (_refreshPeriod_msec > 0)
+	{
+		_sinceRefresh_msec += timeElapsed_msec;
+		if (_sinceRefresh_msec >= _refreshPeriod_msec)
+		{
+			_sinceRefresh_msec = 0;
+			isRefreshNeeded = true;
+		}
+	}
+	
 	for (size_t i = 0; i < _expanderCount; ++i)
 	{
-		_expanders[i].writeAll();
+		auto& expander = _expanders[i];
+		
+		if (_i2cEngine_p != nullptr)
+		{
+			expander.requestWriteAll(*_i2cEngine_p, !isRefreshNeeded);
+		}
+		else if (isRefreshNeeded)
+		{
+			expander.writeAll();
+		}
+		else
+		{
+			expander.writeAllIfChanged();
+		}
 	}
 }
 
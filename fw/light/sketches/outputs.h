@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "jm_PCF8574.h"
+#include "expander_map.h"
 
 #include "types.h"
 #include "log_utils.h"
@@ -18,28 +19,39 @@ public:
 	
 	void setLogger(ILogger* value_p) { _logger.setLogger(value_p); }
 	
+	// Channel pins in channel order, to be set before initialize()
+	bool setPinMap(const std::vector<ExpanderPin>& value);
+	
 	bool initialize();
 	
 	void setCurrentValue(size_t channelIndex, DiscreteState value) override;
-	void update();
+	// Writes only the expanders whose outputs changed, and all of them once per refresh period
+	void update(int timeElapsed_msec);
+	
+	// 0 disables the periodic refresh
+	int getRefreshPeriod_msec() const { return _refreshPeriod_msec; }
+	void setRefreshPeriod_msec(int value) { _refreshPeriod_msec = value; }
+	
+	// With an engine update() only queues the writes
+	void setI2cEngine(I2cEngine* value_p) { _i2cEngine_p = value_p; }
 	
 	size_t getChannelCount() const { return _channelMap.size(); }
 	
 private:
 	bool getHw(size_t channelIndex, jm_PCF8574 * & device_p_out, size_t& channelNumber_out);
 	
-	static const size_t _expanderCount = 1;
+	static const size_t _maxExpanderCount = ExpanderMap::maxExpanderCount;
 	
 	LoggerHelper _logger;
 	
-	jm_PCF8574 _expanders[_expanderCount];
+	int _refreshPeriod_msec = 1000;
+	int _sinceRefresh_msec = 0;
+	
+	jm_PCF8574 _expanders[_maxExpanderCount];
+	uint8_t _expanderAddresses[_maxExpanderCount];
+	size_t _expanderCount = 0;
 	
-	struct ChannelHw
-	{
-		size_t expanderIndex;
-		size_t channelNumber;
-	};	
+	I2cEngine* _i2cEngine_p = nullptr;
 	
-	static const std::vector<ChannelHw> _channelMap;
-	static const uint8_t _expanderAddresses[_expanderCount];
+	std::vector<ExpanderChannel> _channelMap;
 };
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "rule_compiler.h"
+
+bool RuleCompiler::compile(const Rule& rule, std::vector<uint8_t>& code_out)
+{
+    const auto size = code_out.size();
+    auto ok = true;
+
+    for (const auto& guard : rule.guards)
+    {
+        ok = ok && compileGuard(guard, code_out);
+    }
+
+    for (const auto& action : rule.actions)
+    {
+        ok = ok && compileAction(action, code_out);
+    }
+
+    if (!ok)
+    {
+        code_out.resize(size);
+        return false;
+    }
+
+    code_out.push_back(static_cast<uint8_t>(RuleOpcode::end));
+    return true;
+}
+
+bool RuleCompiler::compileGuard(const RuleGuard& guard, std::vector<uint8_t>& code)
+{
+    if ((guard.channelIndex > maxChannelIndex) || (guard.state == DiscreteState::unknown))
+    {
+        return false;
+    }
+
+    const auto isOn = guard.state == DiscreteState::on;
+
+    RuleOpcode opcode;
+    if (guard.source == GuardSource::output)
+    {
+        opcode = isOn ? RuleOpcode::testOutputOn : RuleOpcode::testOutputOff;
+    }
+    else
+    {
+        opcode = isOn ? RuleOpcode::testInputOn : RuleOpcode::testInputOff;
+    }
+
+    code.push_back(static_cast<uint8_t>(opcode));
+    code.push_back(static_cast<uint8_t>(guard.channelIndex));
+
+    return true;
+}
+
+bool RuleCompiler::compileAction(const RuleAction& action, std::vector<uint8_t>& code)
+{
+    switch (action.actionType)
+    {
+        case ActionType::none:
+            return true;
+
+        case ActionType::localOff:
+            code.push_back(static_cast<uint8_t>(RuleOpcode::localOff));
+            return true;
+
+        case ActionType::globalOff:
+            code.push_back(static_cast<uint8_t>(RuleOpcode::globalOff));
+            return true;
+
+        default:
+            break;
+    }
+
+    if (action.outputChannelIndex > maxChannelIndex)
+    {
+        return false;
+    }
+
+    RuleOpcode opcode;
+    auto isTimed = false;
+
+    switch (action.actionType)
+    {
+        case ActionType::turnOn:
+            opcode = RuleOpcode::turnOn;
+            break;
+
+        case ActionType::turnOff:
+            opcode = RuleOpcode::turnOff;
+            break;
+
+        case ActionType::toggle:
+            opcode = RuleOpcode::toggle;
+            break;
+
+        case ActionType::onFor:
+            opcode = RuleOpcode::onFor;
+            isTimed = true;
+            break;
+
+        case ActionType::offAfter:
+            opcode = RuleOpcode::offAfter;
+            isTimed = true;
+            break;
+
+        case ActionType::pulse:
+            opcode = RuleOpcode::pulse;
+            isTimed = true;
+            break;
+
+        case ActionType::groupOn:
+            opcode = RuleOpcode::groupOn;
+            break;
+
+        case ActionType::groupOff:
+            opcode = RuleOpcode::groupOff;
+            break;
+
+        case ActionType::groupToggle:
+            opcode = RuleOpcode::groupToggle;
+            break;
+
+        default:
+            return false;
+    }
+
+    code.push_back(static_cast<uint8_t>(opcode));
+    code.push_back(static_cast<uint8_t>(action.outputChannelIndex));
+
+    if (isTimed)
+    {
+        appendUint32(code, action.duration_msec);
+    }
+
+    return true;
+}
+
+void RuleCompiler::appendUint32(std::vector<uint8_t>& code, uint32_t value)
+{
+    code.push_back(static_cast<uint8_t>(value));
+    code.push_back(static_cast<uint8_t>(value >> 8));
+    code.push_back(static_cast<uint8_t>(value >> 16));
+    code.push_back(static_cast<uint8_t>(value >> 24));
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <vector>
+
+#include "types.h"
+
+// Opcodes of the compiled rules. A rule compiles to its guards, as tests that end the
+// rule when they fail, then its actions in order, then end.
+// Operands follow the opcode: a channel or output group byte and, for the timed actions,
+// a little-endian u32 duration
+enum class RuleOpcode : uint8_t
+{
+    end,
+
+    testOutputOn,   // channel
+    testOutputOff,  // channel
+    testInputOn,    // channel
+    testInputOff,   // channel
+
+    turnOn,         // channel
+    turnOff,        // channel
+    toggle,         // channel
+
+    onFor,          // channel, duration
+    offAfter,       // channel, duration
+    pulse,          // channel, duration
+
+    localOff,
+    globalOff,
+
+    groupOn,        // group
+    groupOff,       // group
+    groupToggle     // group
+};
+
+class RuleCompiler
+{
+public:
+    static const size_t opcodeCount = 16;
+    static const size_t maxChannelIndex = UINT8_MAX;
+
+    // Appends the code of the rule, leaves code_out as is if the rule cannot be compiled
+    static bool compile(const Rule& rule, std::vector<uint8_t>& code_out);
+
+    static uint32_t readUint32(const uint8_t* data_p)
+    {
+        return static_cast<uint32_t>(data_p[0]) | (static_cast<uint32_t>(data_p[1]) << 8) |
+            (static_cast<uint32_t>(data_p[2]) << 16) | (static_cast<uint32_t>(data_p[3]) << 24);
+    }
+
+private:
+    static bool compileGuard(const RuleGuard& guard, std::vector<uint8_t>& code);
+    static bool compileAction(const RuleAction& action, std::vector<uint8_t>& code);
+
+    static void appendUint32(std::vector<uint8_t>& code, uint32_t value);
+};
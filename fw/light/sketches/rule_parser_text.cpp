@@ -1,5 +1,7 @@
 #include "string_utils.h"
 
+#include "timer_wheel.h"
+
 #include "rule_parser_text.h"
 
 enum class ParsingState
@@ -8,13 +10,20 @@ enum class ParsingState
     waitEvent,
     waitOutput,
     waitAction,
-    finished
+    waitOutputOrGuard,
+    waitGuardSource,
+    waitGuardChannel,
+    waitGuardIs,
+    waitGuardState,
+    waitGuardAnd
 };
 
 RuleTextParser::RuleTextParser()
 {
 }
 
+// INPUT EVENT OUTPUT ACTION [OUTPUT ACTION]... [if GUARD [and GUARD]...] [// comment]
+// GUARD: output|input CHANNEL is on|off
 bool RuleTextParser::parse(const std::string& text, Rule& result_out)
 {
 	assert(_inputChannelResolver_p != nullptr);
@@ -32,20 +41,32 @@ bool RuleTextParser::parse(const std::string& text, Rule& result_out)
         return false;
     }
 
-    result_out.action.actionType = ActionType::none;
-    result_out.action.outputChannelIndex = 0;
-
     result_out.condition.eventType = EventType::none;
     result_out.condition.inputChannelIndex = 0;
 
+    result_out.actions.clear();
+    result_out.guards.clear();
+
+    RuleAction emptyAction;
+
+    emptyAction.actionType = ActionType::none;
+    emptyAction.outputChannelIndex = 0;
+    emptyAction.duration_msec = 0;
+
+    RuleGuard emptyGuard;
+
+    emptyGuard.source = GuardSource::output;
+    emptyGuard.channelIndex = 0;
+    emptyGuard.state = DiscreteState::unknown;
+
     size_t pos = 0;
     ParsingState state = ParsingState::waitInput;
     std::string curWord;
 
     auto terminate = false;
-    while (StringUtils::nextWord(text, pos, curWord))
+    while (!terminate && StringUtils::nextWord(text, pos, curWord))
     {
-        if (terminate || (state == ParsingState::finished))
+        if (curWord.compare(0, 2, "//") == 0)
         {
             break;
         }
@@ -62,14 +83,61 @@ bool RuleTextParser::parse(const std::string& text, Rule& result_out)
                 state = ParsingState::waitOutput;
                 break;
 
+            case ParsingState::waitOutputOrGuard:
+                if (StringUtils::equal(curWord, "if"))
+                {
+                    result_out.guards.push_back(emptyGuard);
+                    state = ParsingState::waitGuardSource;
+                    break;
+                }
+
+                // Not a guard but one more action
+                // Fall through
             case ParsingState::waitOutput:
-                readOutput(curWord, result_out);
+                result_out.actions.push_back(emptyAction);
+                _outputName = curWord;
                 state = ParsingState::waitAction;
                 break;
 
             case ParsingState::waitAction:
-                readAction(curWord, result_out);
-                state = ParsingState::finished;
+                readAction(curWord, result_out.actions.back());
+                state = ParsingState::waitOutputOrGuard;
+                break;
+
+            case ParsingState::waitGuardSource:
+                readGuardSource(curWord, result_out.guards.back());
+                state = ParsingState::waitGuardChannel;
+                break;
+
+            case ParsingState::waitGuardChannel:
+                readGuardChannel(curWord, result_out.guards.back());
+                state = ParsingState::waitGuardIs;
+                break;
+
+            case ParsingState::waitGuardIs:
+                if (!StringUtils::equal(curWord, "is"))
+                {
+                    _errors.insert(RuleParserError::invalidGuard);
+                }
+
+                state = ParsingState::waitGuardState;
+                break;
+
+            case ParsingState::waitGuardState:
+                readGuardState(curWord, result_out.guards.back());
+                state = ParsingState::waitGuardAnd;
+                break;
+
+            case ParsingState::waitGuardAnd:
+                if (StringUtils::equal(curWord, "and"))
+                {
+                    result_out.guards.push_back(emptyGuard);
+                    state = ParsingState::waitGuardSource;
+                    break;
+                }
+
+                _errors.insert(RuleParserError::parsingError);
+                terminate = true;
                 break;
 
             default:
@@ -79,16 +147,8 @@ bool RuleTextParser::parse(const std::string& text, Rule& result_out)
         }
     }
 
-    if (
-            (result_out.action.actionType == ActionType::localOff)
-            ||
-            (result_out.action.actionType == ActionType::globalOff)
-       )
-    {
-        _errors.erase(RuleParserError::invalidOutputChannel);
-    }
-
-    if (state != ParsingState::finished)
+    // Complete after an action or a guard
+    if ((state != ParsingState::waitOutputOrGuard) && (state != ParsingState::waitGuardAnd))
     {
         _errors.insert(RuleParserError::parsingError);
     }
@@ -128,34 +188,168 @@ bool RuleTextParser::readEvent(const std::string& text, Rule& rule)
     return true;
 }
 
-bool RuleTextParser::readOutput(const std::string& text, Rule& rule)
+// The output of a group action is a group, local_off and global_off take anything
+bool RuleTextParser::resolveOutput(RuleAction& action)
 {
+    if (isOutputlessAction(action.actionType))
+    {
+        return true;
+    }
+
+    const auto resolver_p = isGroupAction(action.actionType) ? _outputGroupResolver_p : _outputChannelResolver_p;
+
     size_t channelIndex;
-    const auto ok = _outputChannelResolver_p->resolveChannelName(text, channelIndex);
+    if ((resolver_p == nullptr) || !resolver_p->resolveChannelName(_outputName, channelIndex))
+    {
+        _errors.insert(RuleParserError::invalidOutputChannel);
+        return false;
+    }
+
+    action.outputChannelIndex = channelIndex;
+
+    return true;
+}
+
+// ACTION or, for the timed actions, ACTION:DURATION
+bool RuleTextParser::readAction(const std::string& text, RuleAction& action)
+{
+    const auto separatorPos = text.find(':');
+
+    ActionType actionType;
+    const auto ok = _actionResolver_p->resolveActionName(text.substr(0, separatorPos), actionType);
+
+    action.actionType = ok ? actionType : ActionType::none;
+    resolveOutput(action);
 
     if (!ok)
     {
-        _errors.insert(RuleParserError::invalidOutputChannel);
+        _errors.insert(RuleParserError::invalidAction);
         return false;
     }
 
-    rule.action.outputChannelIndex = channelIndex;
+    const auto hasDuration = separatorPos != std::string::npos;
+    if (hasDuration != isTimedAction(actionType))
+    {
+        _errors.insert(RuleParserError::invalidDuration);
+        return false;
+    }
+
+    if (hasDuration && !parseDuration(text.substr(separatorPos + 1), action.duration_msec))
+    {
+        _errors.insert(RuleParserError::invalidDuration);
+        return false;
+    }
 
     return true;
 }
 
-bool RuleTextParser::readAction(const std::string& text, Rule& rule)
+bool RuleTextParser::isTimedAction(ActionType action)
 {
-    ActionType action;
-    const auto ok = _actionResolver_p->resolveActionName(text, action);
+    return (action == ActionType::onFor) || (action == ActionType::offAfter) || (action == ActionType::pulse);
+}
+
+bool RuleTextParser::isOutputlessAction(ActionType action)
+{
+    return (action == ActionType::localOff) || (action == ActionType::globalOff);
+}
+
+bool RuleTextParser::isGroupAction(ActionType action)
+{
+    return (action == ActionType::groupOn) || (action == ActionType::groupOff) || (action == ActionType::groupToggle);
+}
+
+bool RuleTextParser::readGuardSource(const std::string& text, RuleGuard& guard)
+{
+    if (StringUtils::equal(text, "output"))
+    {
+        guard.source = GuardSource::output;
+    }
+    else if (StringUtils::equal(text, "input"))
+    {
+        guard.source = GuardSource::input;
+    }
+    else
+    {
+        _errors.insert(RuleParserError::invalidGuard);
+        return false;
+    }
+
+    return true;
+}
+
+bool RuleTextParser::readGuardChannel(const std::string& text, RuleGuard& guard)
+{
+    const auto resolver_p = (guard.source == GuardSource::input) ? _inputChannelResolver_p : _outputChannelResolver_p;
+
+    size_t channelIndex;
+    const auto ok = resolver_p->resolveChannelName(text, channelIndex);
 
     if (!ok)
     {
-        _errors.insert(RuleParserError::invalidEvent);
+        _errors.insert(RuleParserError::invalidGuard);
         return false;
     }
 
-    rule.action.actionType = action;
+    guard.channelIndex = channelIndex;
+
+    return true;
+}
+
+bool RuleTextParser::readGuardState(const std::string& text, RuleGuard& guard)
+{
+    if (StringUtils::equal(text, "on"))
+    {
+        guard.state = DiscreteState::on;
+    }
+    else if (StringUtils::equal(text, "off"))
+    {
+        guard.state = DiscreteState::off;
+    }
+    else
+    {
+        _errors.insert(RuleParserError::invalidGuard);
+        return false;
+    }
+
+    return true;
+}
+
+// NUMBER with an optional unit: ms, s (the default) or m
+bool RuleTextParser::parseDuration(const std::string& text, uint32_t& result_out)
+{
+    const auto unitPos = text.find_first_not_of("0123456789");
+    const auto unit = (unitPos == std::string::npos) ? std::string() : text.substr(unitPos);
+
+    uint32_t unit_msec;
+    if (unit.empty() || StringUtils::equal(unit, "s"))
+    {
+        unit_msec = 1000;
+    }
+    else if (StringUtils::equal(unit, "ms"))
+    {
+        unit_msec = 1;
+    }
+    else if (StringUtils::equal(unit, "m"))
+    {
+        unit_msec = 60 * 1000;
+    }
+    else
+    {
+        return false;
+    }
+
+    unsigned int value;
+    if ((StringUtils::parseNumber(text.substr(0, unitPos), value) != NumberParsingResult::success) || (value == 0))
+    {
+        return false;
+    }
+
+    // Not longer than the timers can count
+    if (value > TimerWheel::maxDelay_msec / unit_msec)
+    {
+        return false;
+    }
 
+    result_out = value * unit_msec;
     return true;
 }
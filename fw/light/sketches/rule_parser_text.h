@@ -18,7 +18,9 @@ enum class RuleParserError
     invalidInputChannel,
     invalidOutputChannel,
     invalidEvent,
-    invalidAction
+    invalidAction,
+    invalidDuration,
+    invalidGuard
 };
 
 class RuleTextParser
@@ -30,6 +32,7 @@ public:
 		
     void setInputChannelResolver(IChannelNameResolver* value_p) { _inputChannelResolver_p = value_p; }
     void setOutputChannelResolver(IChannelNameResolver* value_p) { _outputChannelResolver_p = value_p; }
+    void setOutputGroupResolver(IChannelNameResolver* value_p) { _outputGroupResolver_p = value_p; }
     void setEventResolver(IEventNameResolver* value_p) { _eventResolver_p = value_p; }
     void setActionResolver(IActionNameResolver* value_p) { _actionResolver_p = value_p; }
  
@@ -39,14 +42,27 @@ public:
 private:
     bool readInput(const std::string& text, Rule& rule);
     bool readEvent(const std::string& text, Rule& rule);
-    bool readOutput(const std::string& text, Rule& rule);
-    bool readAction(const std::string& text, Rule& rule);
+    bool readAction(const std::string& text, RuleAction& action);
+    bool resolveOutput(RuleAction& action);
+
+    bool readGuardSource(const std::string& text, RuleGuard& guard);
+    bool readGuardChannel(const std::string& text, RuleGuard& guard);
+    bool readGuardState(const std::string& text, RuleGuard& guard);
+
+    static bool isTimedAction(ActionType action);
+    static bool isOutputlessAction(ActionType action);
+    static bool isGroupAction(ActionType action);
+    static bool parseDuration(const std::string& text, uint32_t& result_out);
 
     IChannelNameResolver* _inputChannelResolver_p = nullptr;
     IChannelNameResolver* _outputChannelResolver_p = nullptr;
+    IChannelNameResolver* _outputGroupResolver_p = nullptr;    // Optional
 
     IEventNameResolver* _eventResolver_p = nullptr;
     IActionNameResolver* _actionResolver_p = nullptr;
 	
     Errors _errors;
+
+    // Output or group of the current action, resolved once its action type is known
+    std::string _outputName;
 };
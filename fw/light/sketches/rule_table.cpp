@@ -0,0 +1,99 @@
+#include "rule_compiler.h"
+
+#include "rule_table.h"
+
+ActionManagerError RuleTable::addRule(const Rule& rule)
+{
+    if (_rules.size() >= maxRuleCount)
+    {
+        return ActionManagerError::tooManyRules;
+    }
+
+    const auto codeOffset = _ruleCode.size();
+    if (!RuleCompiler::compile(rule, _ruleCode))
+    {
+        return ActionManagerError::invalidChannelIndex;
+    }
+
+    if (_ruleCode.size() > maxCodeSize)
+    {
+        _ruleCode.resize(codeOffset);
+        return ActionManagerError::tooManyRules;
+    }
+
+    RuleEntry entry;
+
+    entry.condition = rule.condition;
+    entry.codeOffset = static_cast<uint16_t>(codeOffset);
+
+    _rules.push_back(entry);
+    _isIndexBuilt = false;
+
+    return ActionManagerError::none;
+}
+
+void RuleTable::clear()
+{
+    _rules.clear();
+    _ruleCode.clear();
+
+    _isIndexBuilt = false;
+}
+
+void RuleTable::buildIndex(size_t inputChannelCount)
+{
+    const auto keyCount = inputChannelCount * eventSlotCount;
+
+    _ruleSpans.assign(keyCount + 1, 0);
+    _ruleIndex.clear();
+
+    std::vector<size_t> keys(_rules.size(), keyCount);
+
+    for (size_t i = 0; i < _rules.size(); ++i)
+    {
+        const auto& condition = _rules[i].condition;
+
+        size_t slot;
+        if ((condition.inputChannelIndex >= inputChannelCount) || !getEventSlot(condition.eventType, slot))
+        {
+            continue;
+        }
+
+        keys[i] = getKey(condition.inputChannelIndex, slot);
+        ++_ruleSpans[keys[i] + 1];
+    }
+
+    for (size_t k = 0; k < keyCount; ++k)
+    {
+        _ruleSpans[k + 1] += _ruleSpans[k];
+    }
+
+    _ruleIndex.resize(_ruleSpans[keyCount]);
+
+    std::vector<RuleNumber> fill(_ruleSpans.begin(), _ruleSpans.end() - 1);
+    for (size_t i = 0; i < _rules.size(); ++i)
+    {
+        if (keys[i] == keyCount)
+        {
+            continue;
+        }
+
+        _ruleIndex[fill[keys[i]]++] = static_cast<RuleNumber>(i);
+    }
+
+    _indexedInputChannelCount = inputChannelCount;
+    _isIndexBuilt = true;
+}
+
+bool RuleTable::getEventSlot(EventType event, size_t& slot_out)
+{
+    // Slots follow EventType, none has none
+    const auto value = static_cast<size_t>(event);
+    if ((value == 0) || (value > eventSlotCount))
+    {
+        return false;
+    }
+
+    slot_out = value - 1;
+    return true;
+}
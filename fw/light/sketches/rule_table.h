@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <vector>
+
+#include "types.h"
+
+// Compiled rules with their lookup index. The action manager runs one table and keeps
+// a spare one, so a new set of rules can be built while the current one runs
+class RuleTable
+{
+public:
+    using RuleNumber = uint16_t;
+
+    static const size_t maxRuleCount = 128;
+    static const size_t maxCodeSize = 4096;
+
+    // Events rules can be bound to, EventType::none excluded
+    static const size_t eventSlotCount = 6;
+
+    ActionManagerError addRule(const Rule& rule);
+    void clear();
+
+    size_t getRuleCount() const { return _rules.size(); }
+
+    // Groups the rules by (input channel, event), needed again after the rules
+    // or the channel count change
+    void buildIndex(size_t inputChannelCount);
+    bool isIndexBuilt(size_t inputChannelCount) const { return _isIndexBuilt && (_indexedInputChannelCount == inputChannelCount); }
+
+    // Rules bound to the key, in the order they were added
+    const RuleNumber* getKeyRules(size_t key, size_t& count_out) const
+    {
+        const auto first = _ruleSpans[key];
+
+        count_out = _ruleSpans[key + 1] - first;
+        return _ruleIndex.data() + first;
+    }
+
+    const uint8_t* getRuleCode(RuleNumber ruleNumber) const { return _ruleCode.data() + _rules[ruleNumber].codeOffset; }
+
+    static size_t getKey(size_t inputChannelIndex, size_t eventSlot) { return inputChannelIndex * eventSlotCount + eventSlot; }
+    static bool getEventSlot(EventType event, size_t& slot_out);
+
+private:
+    struct RuleEntry
+    {
+        RuleCondition condition;
+        uint16_t codeOffset;
+    };
+
+    // Code of all the rules back to back, see RuleCompiler
+    std::vector<RuleEntry> _rules;
+    std::vector<uint8_t> _ruleCode;
+
+    // The rules for key k are _rules[_ruleIndex[i]] for i in [_ruleSpans[k], _ruleSpans[k + 1])
+    std::vector<RuleNumber> _ruleIndex;
+    std::vector<RuleNumber> _ruleSpans;
+    size_t _indexedInputChannelCount = 0;
+    bool _isIndexBuilt = false;
+};
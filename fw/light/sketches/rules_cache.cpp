@@ -0,0 +1,320 @@
+#include <cassert>
+#include <cstring>
+
+#include "rules_cache.h"
+
+static const uint32_t fnvOffsetBasis = 2166136261u;
+static const uint32_t fnvPrime = 16777619u;
+
+static void hashBytes(uint32_t& hash, const uint8_t* data_p, size_t size)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= data_p[i];
+		hash *= fnvPrime;
+	}
+}
+
+bool RulesCacheReader::addSourceFilename(String value)
+{
+	if (_sourceCount >= _maxSourceCount)
+	{
+		return false;
+	}
+	
+	_sourceFilenames[_sourceCount++] = value;
+	return true;
+}
+
+IRulesReader::ReadResult RulesCacheReader::readRule(Rule& result_out)
+{
+	// The data was checked by load() or built by compile()
+	if (_readPos >= _data.size())
+	{
+		return ReadResult::noData;
+	}
+	
+	RuleRecord record;
+	std::memcpy(&record, &_data[_readPos], sizeof(record));
+	_readPos += sizeof(record);
+	
+	result_out.condition.inputChannelIndex = record.inputChannelIndex;
+	result_out.condition.eventType = static_cast<EventType>(record.eventType);
+	
+	result_out.actions.resize(record.actionCount);
+	for (auto& action : result_out.actions)
+	{
+		ActionRecord actionRecord;
+		std::memcpy(&actionRecord, &_data[_readPos], sizeof(actionRecord));
+		_readPos += sizeof(actionRecord);
+		
+		action.outputChannelIndex = actionRecord.outputChannelIndex;
+		action.actionType = static_cast<ActionType>(actionRecord.actionType);
+		action.duration_msec = actionRecord.duration_msec;
+	}
+	
+	result_out.guards.resize(record.guardCount);
+	for (auto& guard : result_out.guards)
+	{
+		GuardRecord guardRecord;
+		std::memcpy(&guardRecord, &_data[_readPos], sizeof(guardRecord));
+		_readPos += sizeof(guardRecord);
+		
+		guard.channelIndex = guardRecord.channelIndex;
+		guard.source = static_cast<GuardSource>(guardRecord.source);
+		guard.state = static_cast<DiscreteState>(guardRecord.state);
+	}
+	
+	return ReadResult::success;
+}
+
+bool RulesCacheReader::reset()
+{
+	assert(_fileSystem_p != nullptr);
+	assert(_sourceReader_p != nullptr);
+	
+	_data.clear();
+	_ruleCount = 0;
+	_readPos = 0;
+	
+	uint32_t sourceHash = 0;
+	const auto isHashValid = hashSources(sourceHash);
+	
+	if (isHashValid && load(sourceHash))
+	{
+		_logger.trace("Rules loaded from the compiled cache");
+		return true;
+	}
+	
+	_logger.info("Compiling rules");
+	if (!compile())
+	{
+		return false;
+	}
+	
+	if (isHashValid && !save(sourceHash))
+	{
+		_logger.error("Failed to write the compiled rules cache", ILogger::ErrorSeverity::warning);
+	}
+	
+	return true;
+}
+
+bool RulesCacheReader::hashSources(uint32_t& hash_out) const
+{
+	uint8_t buf[128];
+	
+	const uint16_t version = _version;
+	
+	auto hash = fnvOffsetBasis;
+	hashBytes(hash, reinterpret_cast<const uint8_t*>(&version), sizeof(version));
+	
+	for (size_t i = 0; i < _sourceCount; ++i)
+	{
+		auto file = _fileSystem_p->open(_sourceFilenames[i], "r");
+		if (!file)
+		{
+			return false;
+		}
+		
+		const uint32_t size = file.size();
+		hashBytes(hash, reinterpret_cast<const uint8_t*>(&size), sizeof(size));
+		
+		size_t readCount;
+		while ((readCount = file.read(buf, sizeof(buf))) > 0)
+		{
+			hashBytes(hash, buf, readCount);
+		}
+		
+		file.close();
+	}
+	
+	hash_out = hash;
+	return true;
+}
+
+bool RulesCacheReader::load(uint32_t sourceHash)
+{
+	auto file = _fileSystem_p->open(_filename, "r");
+	if (!file)
+	{
+		return false;
+	}
+	
+	Header header;
+	auto ok = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header);
+	
+	ok = ok && (header.signature == _signature);
+	ok = ok && (header.version == _version);
+	ok = ok && (header.recordSize == sizeof(RuleRecord));
+	ok = ok && (header.sourceHash == sourceHash);
+	ok = ok && (file.size() >= sizeof(Header));
+	
+	if (ok)
+	{
+		const size_t dataSize = file.size() - sizeof(Header);
+		
+		_data.resize(dataSize);
+		ok = file.read(_data.data(), dataSize) == dataSize;
+	}
+	
+	file.close();
+	
+	// Every record must be complete, and there must be as many rules as the header says
+	size_t pos = 0;
+	while (ok && (pos < _data.size()))
+	{
+		const auto ruleSize = getRuleSize(pos);
+		
+		ok = ruleSize != 0;
+		pos += ruleSize;
+		++_ruleCount;
+	}
+	
+	ok = ok && (_ruleCount == header.ruleCount);
+	
+	if (!ok)
+	{
+		_data.clear();
+		_ruleCount = 0;
+	}
+	
+	return ok;
+}
+
+bool RulesCacheReader::compile()
+{
+	if (!_sourceReader_p->reset())
+	{
+		return false;
+	}
+	
+	while (_sourceReader_p->hasMoreRules())
+	{
+		Rule rule;
+		if (_sourceReader_p->readRule(rule) != ReadResult::success)
+		{
+			continue;
+		}
+		
+		if (!appendRule(rule))
+		{
+			_logger.error("Rule does not fit the compiled rules", ILogger::ErrorSeverity::warning);
+		}
+	}
+	
+	return true;
+}
+
+bool RulesCacheReader::save(uint32_t sourceHash)
+{
+	auto file = _fileSystem_p->open(_filename, "w");
+	if (!file)
+	{
+		return false;
+	}
+	
+	Header header;
+	
+	header.signature = _signature;
+	header.version = _version;
+	header.recordSize = sizeof(RuleRecord);
+	header.sourceHash = sourceHash;
+	header.ruleCount = _ruleCount;
+	
+	const auto dataSize = _data.size();
+	
+	auto ok = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) == sizeof(header);
+	ok = ok && (file.write(_data.data(), dataSize) == dataSize);
+	
+	file.close();
+	
+	// A truncated file would fail the size check anyway, but do not leave it behind
+	if (!ok)
+	{
+		_fileSystem_p->remove(_filename);
+	}
+	
+	return ok;
+}
+
+
+size_t RulesCacheReader::getRuleSize(size_t pos) const
+{
+	if (_data.size() - pos < sizeof(RuleRecord))
+	{
+		return 0;
+	}
+	
+	RuleRecord record;
+	std::memcpy(&record, &_data[pos], sizeof(record));
+	
+	const auto size = sizeof(RuleRecord) + record.actionCount * sizeof(ActionRecord) + record.guardCount * sizeof(GuardRecord);
+	
+	return (_data.size() - pos >= size) ? size : 0;
+}
+
+bool RulesCacheReader::appendRule(const Rule& rule)
+{
+	auto fits = rule.condition.inputChannelIndex <= UINT16_MAX;
+	fits = fits && (rule.actions.size() <= UINT8_MAX);
+	fits = fits && (rule.guards.size() <= UINT8_MAX);
+	
+	for (const auto& action : rule.actions)
+	{
+		fits = fits && (action.outputChannelIndex <= UINT16_MAX);
+	}
+	
+	for (const auto& guard : rule.guards)
+	{
+		fits = fits && (guard.channelIndex <= UINT16_MAX);
+	}
+	
+	if (!fits)
+	{
+		return false;
+	}
+	
+	RuleRecord record;
+	
+	record.inputChannelIndex = static_cast<uint16_t>(rule.condition.inputChannelIndex);
+	record.eventType = static_cast<uint8_t>(rule.condition.eventType);
+	record.actionCount = static_cast<uint8_t>(rule.actions.size());
+	record.guardCount = static_cast<uint8_t>(rule.guards.size());
+	std::memset(record.reserved, 0, sizeof(record.reserved));
+	
+	appendRecord(record);
+	
+	for (const auto& action : rule.actions)
+	{
+		ActionRecord actionRecord;
+		
+		actionRecord.outputChannelIndex = static_cast<uint16_t>(action.outputChannelIndex);
+		actionRecord.actionType = static_cast<uint8_t>(action.actionType);
+		actionRecord.reserved = 0;
+		actionRecord.duration_msec = action.duration_msec;
+		
+		appendRecord(actionRecord);
+	}
+	
+	for (const auto& guard : rule.guards)
+	{
+		GuardRecord guardRecord;
+		
+		guardRecord.channelIndex = static_cast<uint16_t>(guard.channelIndex);
+		guardRecord.source = static_cast<uint8_t>(guard.source);
+		guardRecord.state = static_cast<uint8_t>(guard.state);
+		
+		appendRecord(guardRecord);
+	}
+	
+	++_ruleCount;
+	return true;
+}
+
+template <typename T>
+void RulesCacheReader::appendRecord(const T& record)
+{
+	const auto bytes_p = reinterpret_cast<const uint8_t*>(&record);
+	_data.insert(_data.end(), bytes_p, bytes_p + sizeof(record));
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <vector>
+
+#include <Arduino.h>
+#include <FS.h>
+
+#include "types.h"
+#include "log_utils.h"
+
+// Serves the rules from a compiled binary file: a header with the hash of the source
+// files followed by packed rule records. The file is bulk-read on reset() and
+// rebuilt from the source reader only when the hash of the sources differs.
+// A rule record is followed by the records of its actions and guards
+class RulesCacheReader : public IRulesReader
+{
+public:
+	void setLogger(ILogger* value_p) { _logger.setLogger(value_p); }
+	
+	void setSourceReader(IRulesReader* value_p) { _sourceReader_p = value_p; }
+	
+	void setFilename(String value) { _filename = value; }
+	void setFileSystem(FS* value_p) { _fileSystem_p = value_p; }
+	
+	// Files the compiled rules depend on: the rules text and the channel lists
+	bool addSourceFilename(String value);
+	
+	ReadResult readRule(Rule& result_out) override;
+	bool hasMoreRules() const override { return _readPos < _data.size(); }
+	bool reset() override;
+	
+private:
+	struct Header
+	{
+		uint32_t signature;
+		uint16_t version;
+		uint16_t recordSize;
+		uint32_t sourceHash;
+		uint32_t ruleCount;
+	};
+	
+	struct RuleRecord
+	{
+		uint16_t inputChannelIndex;
+		uint8_t eventType;
+		uint8_t actionCount;
+		uint8_t guardCount;
+		uint8_t reserved[3];
+	};
+	
+	struct ActionRecord
+	{
+		uint16_t outputChannelIndex;
+		uint8_t actionType;
+		uint8_t reserved;
+		uint32_t duration_msec;
+	};
+	
+	struct GuardRecord
+	{
+		uint16_t channelIndex;
+		uint8_t source;
+		uint8_t state;
+	};
+	
+	static const uint32_t _signature = 0x4C555252; // "RRUL"
+	static const uint16_t _version = 3;
+	static const size_t _maxSourceCount = 4;
+	
+	bool hashSources(uint32_t& hash_out) const;
+	bool load(uint32_t sourceHash);
+	bool compile();
+	bool save(uint32_t sourceHash);
+	
+	// Size of the rule at pos with its actions and guards, 0 if it does not fit the data
+	size_t getRuleSize(size_t pos) const;
+	bool appendRule(const Rule& rule);
+	
+	template <typename T>
+	void appendRecord(const T& record);
+	
+	LoggerHelper _logger;
+	
+	IRulesReader* _sourceReader_p = nullptr;
+	
+	String _filename;
+	FS* _fileSystem_p = nullptr;
+	
+	String _sourceFilenames[_maxSourceCount];
+	size_t _sourceCount = 0;
+	
+	std::vector<uint8_t> _data;
+	size_t _ruleCount = 0;
+	size_t _readPos = 0;
+};
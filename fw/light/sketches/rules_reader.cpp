@@ -31,6 +31,11 @@ void RulesTextReader::setActionResolver(IActionNameResolver* value_p)
 	_ruleParser.setActionResolver(value_p);
 }
 
+void RulesTextReader::setOutputGroupResolver(IChannelNameResolver* value_p)
+{
+	_ruleParser.setOutputGroupResolver(value_p);
+}
+
 
 IRulesReader::ReadResult RulesTextReader::readRule(Rule& result_out)
 {
@@ -118,7 +123,9 @@ void RulesTextReader::writeParserErrorsToLog(const std::string& ruleText)
 	{
 		{ RuleParserError::internalError,        "internal error"},
 		{ RuleParserError::invalidAction,        "invalid action"},
+		{ RuleParserError::invalidDuration,      "invalid duration"},
 		{ RuleParserError::invalidEvent,         "invalid event"},
+		{ RuleParserError::invalidGuard,         "invalid guard"},
 		{ RuleParserError::invalidInputChannel,  "invalid input"},
 		{ RuleParserError::invalidOutputChannel, "invalid output"},
 		{ RuleParserError::parsingError,         "syntax error"},
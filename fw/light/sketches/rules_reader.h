@@ -21,6 +21,7 @@ public:
 	void setOutputChannelResolver(IChannelNameResolver* value_p);
 	void setEventResolver(IEventNameResolver* value_p);
 	void setActionResolver(IActionNameResolver* value_p);
+	void setOutputGroupResolver(IChannelNameResolver* value_p);
 		
 	void setFilename(String value) { _filename = value; }
 	void setFileSystem(FS* value_p) { _fileSystem_p = value_p; }
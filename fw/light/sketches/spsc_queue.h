@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <atomic>
+
+// Fixed capacity lock-free queue for exactly one producer and one consumer,
+// which may run on different cores. push() and pop() never block or allocate.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() :
+        _head(0),
+        _tail(0)
+    {
+    }
+
+    static size_t capacity() { return Capacity; }
+
+    // Producer side. Returns false if the queue is full.
+    // Always inlined, so an IRAM interrupt handler may push while the flash cache is off
+    __attribute__((always_inline)) bool push(const T& item)
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        const auto head = _head.load(std::memory_order_acquire);
+
+        if (tail - head >= Capacity)
+        {
+            return false;
+        }
+
+        _items[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty
+    bool pop(T& item_out)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        const auto tail = _tail.load(std::memory_order_acquire);
+
+        if (head == tail)
+        {
+            return false;
+        }
+
+        item_out = _items[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t size() const
+    {
+        const auto tail = _tail.load(std::memory_order_acquire);
+        const auto head = _head.load(std::memory_order_acquire);
+
+        return tail - head;
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    T _items[Capacity];
+
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+};
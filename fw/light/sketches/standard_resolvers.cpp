@@ -5,17 +5,27 @@
 
 const std::map<std::string, EventType> StandardResolvers::_eventTypes =
 {
-    { "rise", EventType::rise },
-    { "fall", EventType::fall }
+    { "rise",         EventType::rise        },
+    { "fall",         EventType::fall        },
+    { "click",        EventType::click       },
+    { "double_click", EventType::doubleClick },
+    { "long_press",   EventType::longPress   },
+    { "hold_repeat",  EventType::holdRepeat  }
 };
 
 const std::map<std::string, ActionType> StandardResolvers::_actionTypes =
 {
-    { "turn_on",    ActionType::turnOn    },
-    { "turn_off",   ActionType::turnOff   },
-    { "toggle",     ActionType::toggle    },
-    { "local_off",  ActionType::localOff  },
-    { "global_off", ActionType::globalOff }
+    { "turn_on",      ActionType::turnOn      },
+    { "turn_off",     ActionType::turnOff     },
+    { "toggle",       ActionType::toggle      },
+    { "local_off",    ActionType::localOff    },
+    { "global_off",   ActionType::globalOff   },
+    { "on_for",       ActionType::onFor       },
+    { "off_after",    ActionType::offAfter    },
+    { "pulse",        ActionType::pulse       },
+    { "group_on",     ActionType::groupOn     },
+    { "group_off",    ActionType::groupOff    },
+    { "group_toggle", ActionType::groupToggle }
 };
 
 StandardResolvers::StandardResolvers() :
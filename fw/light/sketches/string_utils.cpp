@@ -32,6 +32,19 @@ bool StringUtils::equal(const std::string &v1, const std::string &v2, bool caseI
     return true;
 }
 
+uint32_t StringUtils::hashCaseInsensitive(const std::string &s)
+{
+    uint32_t hash = 2166136261u;
+    
+    for (const auto ch : s)
+    {
+        hash ^= static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(ch)));
+        hash *= 16777619u;
+    }
+    
+    return hash;
+}
+
 /*std::string StringUtils::toString(unsigned int value)
 {
     const auto& result = std::to_string(value);
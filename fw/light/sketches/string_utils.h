@@ -19,6 +19,9 @@ class StringUtils
 public:	
     static bool equal(const std::string &v1, const std::string &v2, bool caseInsensitive = true);
     
+    // FNV-1a of the lowercased text, computed in place
+    static uint32_t hashCaseInsensitive(const std::string &s);
+    
     /*static std::string toString(unsigned int value);*/
     static std::string toString(int value);
 	
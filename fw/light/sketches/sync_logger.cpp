@@ -0,0 +1,82 @@
+#include "sync_logger.h"
+
+SyncLogger::SyncLogger() :
+	ILogger()
+{
+	_mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+SyncLogger::~SyncLogger()
+{
+	vSemaphoreDelete(_mutex);
+}
+
+void SyncLogger::trace(const std::string& text, bool isFinal)
+{
+	lock();
+	
+	if (_logger_p != nullptr)
+	{
+		_logger_p->trace(text, isFinal);
+	}
+	
+	unlock(isFinal);
+}
+
+void SyncLogger::error(const std::string& text, ILogger::ErrorSeverity severity, bool isFinal)
+{
+	lock();
+	
+	if (_logger_p != nullptr)
+	{
+		_logger_p->error(text, severity, isFinal);
+	}
+	
+	unlock(isFinal);
+}
+
+void SyncLogger::info(const std::string& text, bool isFinal)
+{
+	lock();
+	
+	if (_logger_p != nullptr)
+	{
+		_logger_p->info(text, isFinal);
+	}
+	
+	unlock(isFinal);
+}
+
+void SyncLogger::endMessage()
+{
+	lock();
+	
+	if (_logger_p != nullptr)
+	{
+		_logger_p->endMessage();
+	}
+	
+	unlock(true);
+}
+
+void SyncLogger::lock()
+{
+	xSemaphoreTakeRecursive(_mutex, portMAX_DELAY);
+	
+	// Only the owner of the mutex gets here
+	++_lockDepth;
+}
+
+void SyncLogger::unlock(bool isFinal)
+{
+	if (!isFinal)
+	{
+		return;
+	}
+	
+	while (_lockDepth > 0)
+	{
+		--_lockDepth;
+		xSemaphoreGiveRecursive(_mutex);
+	}
+}
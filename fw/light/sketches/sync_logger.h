@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdbool>
+
+#include <string>
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "types.h"
+
+// Serializes messages written to a logger from several tasks.
+// A message built from several parts keeps the lock until its final part.
+class SyncLogger : public ILogger
+{
+public:
+	SyncLogger();
+	~SyncLogger();
+	
+	void setLogger(ILogger* value_p) { _logger_p = value_p; }
+	
+	void trace(const std::string& text, bool isFinal = true) override;
+	void error(const std::string& text, ILogger::ErrorSeverity severity, bool isFinal = true) override;
+	void info(const std::string& text, bool isFinal = true) override;
+	
+	void endMessage() override;
+	
+private:
+	void lock();
+	void unlock(bool isFinal);
+	
+	ILogger* _logger_p = nullptr;
+	
+	SemaphoreHandle_t _mutex;
+	size_t _lockDepth = 0;
+};
@@ -0,0 +1,88 @@
+#include "tick_profiler.h"
+
+TickProfiler::TickProfiler() :
+    _isResetRequested(false)
+{
+    reset();
+}
+
+void TickProfiler::setClock(ClockFunction value, uint32_t ticksPerMicrosecond)
+{
+    _clock = value;
+    _ticksPerMicrosecond = (ticksPerMicrosecond > 0) ? ticksPerMicrosecond : 1;
+}
+
+void TickProfiler::record(Stage stage, uint32_t startTicks)
+{
+    if (_clock == nullptr)
+    {
+        return;
+    }
+
+    const auto duration_usec = (_clock() - startTicks) / _ticksPerMicrosecond;
+
+    if (_isResetRequested.exchange(false))
+    {
+        reset();
+    }
+
+    auto& stats = _stats[static_cast<size_t>(stage)];
+
+    ++stats.count;
+    stats.total_usec += duration_usec;
+
+    if (duration_usec < stats.min_usec)
+    {
+        stats.min_usec = duration_usec;
+    }
+
+    if (duration_usec > stats.max_usec)
+    {
+        stats.max_usec = duration_usec;
+    }
+
+    size_t bucket = 0;
+    if (duration_usec > 1)
+    {
+        bucket = 31 - static_cast<size_t>(__builtin_clz(duration_usec));
+    }
+
+    if (bucket >= bucketCount)
+    {
+        bucket = bucketCount - 1;
+    }
+
+    ++stats.buckets[bucket];
+}
+
+const char* TickProfiler::getStageName(Stage stage)
+{
+    switch (stage)
+    {
+        case Stage::tick:               return "tick";
+        case Stage::inputDeviceUpdate:  return "input-device-update";
+        case Stage::readInputs:         return "read-inputs";
+        case Stage::detectEvents:       return "detect-events";
+        case Stage::manageActions:      return "manage-actions";
+        case Stage::writeOutputs:       return "write-outputs";
+        case Stage::sendEvents:         return "send-events";
+        case Stage::outputDeviceUpdate: return "output-device-update";
+        default:                        return "unknown";
+    }
+}
+
+void TickProfiler::reset()
+{
+    for (auto& stats : _stats)
+    {
+        stats.count = 0;
+        stats.min_usec = UINT32_MAX;
+        stats.max_usec = 0;
+        stats.total_usec = 0;
+
+        for (auto& bucket : stats.buckets)
+        {
+            bucket = 0;
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <atomic>
+
+// Duration statistics of the control tick stages.
+// Timing is taken from a clock function set by the platform (cycle counter or
+// microsecond timer); without a clock the profiler records nothing.
+// Statistics are written by the control task only, readers on other tasks may see
+// a stage in the middle of an update, which is acceptable for diagnostics.
+class TickProfiler
+{
+public:
+    enum class Stage
+    {
+        tick,
+        inputDeviceUpdate,
+        readInputs,
+        detectEvents,
+        manageActions,
+        writeOutputs,
+        sendEvents,
+        outputDeviceUpdate,
+
+        count
+    };
+
+    static const size_t stageCount = static_cast<size_t>(Stage::count);
+
+    // Bucket i counts durations of [2^i, 2^(i+1)) microseconds, bucket 0 also counts 0
+    static const size_t bucketCount = 20;
+
+    using ClockFunction = uint32_t (*)();
+
+    struct StageStats
+    {
+        uint32_t count;
+        uint32_t min_usec;
+        uint32_t max_usec;
+        uint64_t total_usec;
+        uint32_t buckets[bucketCount];
+    };
+
+    TickProfiler();
+
+    void setClock(ClockFunction value, uint32_t ticksPerMicrosecond = 1);
+    bool isEnabled() const { return _clock != nullptr; }
+
+    uint32_t now() const { return (_clock != nullptr) ? _clock() : 0; }
+    void record(Stage stage, uint32_t startTicks);
+
+    // Clears the statistics before the next record, safe to call from any task
+    void requestReset() { _isResetRequested = true; }
+
+    static const char* getStageName(Stage stage);
+    const StageStats& getStats(Stage stage) const { return _stats[static_cast<size_t>(stage)]; }
+
+private:
+    void reset();
+
+    ClockFunction _clock = nullptr;
+    uint32_t _ticksPerMicrosecond = 1;
+
+    std::atomic<bool> _isResetRequested;
+
+    StageStats _stats[stageCount];
+};
+
+class ProfileScope
+{
+public:
+    ProfileScope(TickProfiler* profiler_p, TickProfiler::Stage stage) :
+        _profiler_p(profiler_p),
+        _stage(stage),
+        _start((profiler_p != nullptr) ? profiler_p->now() : 0)
+    {
+    }
+
+    ~ProfileScope()
+    {
+        if (_profiler_p != nullptr)
+        {
+            _profiler_p->record(_stage, _start);
+        }
+    }
+
+private:
+    TickProfiler* _profiler_p;
+    TickProfiler::Stage _stage;
+    uint32_t _start;
+};
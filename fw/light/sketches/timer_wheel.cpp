@@ -0,0 +1,159 @@
+#include "timer_wheel.h"
+
+// Slot numbers wrap around together with the clock
+static_assert((0x100000000ull % (TimerWheel::slotDuration_msec * TimerWheel::slotCount)) == 0, "Slots must divide the clock range");
+
+TimerWheel::TimerWheel()
+{
+    for (auto& head : _heads)
+    {
+        head = _none;
+    }
+}
+
+bool TimerWheel::setCapacity(size_t value)
+{
+    if (value > maxCapacity)
+    {
+        return false;
+    }
+
+    Node node;
+
+    node.deadline_msec = 0;
+    node.prev = _none;
+    node.next = _none;
+    node.slot = _none;
+
+    _nodes.assign(value, node);
+
+    for (auto& head : _heads)
+    {
+        head = _none;
+    }
+
+    _pendingCount = 0;
+    return true;
+}
+
+void TimerWheel::start(size_t timerIndex, uint32_t delay_msec)
+{
+    if (timerIndex >= _nodes.size())
+    {
+        return;
+    }
+
+    const auto index = static_cast<uint16_t>(timerIndex);
+
+    if (_nodes[index].slot != _none)
+    {
+        unlink(index);
+    }
+
+    const auto deadline_msec = _now_msec + ((delay_msec < maxDelay_msec) ? delay_msec : maxDelay_msec);
+
+    _nodes[index].deadline_msec = deadline_msec;
+    link(index, static_cast<uint16_t>(getSlotNumber(deadline_msec) % slotCount));
+}
+
+void TimerWheel::cancel(size_t timerIndex)
+{
+    if (isPending(timerIndex))
+    {
+        unlink(static_cast<uint16_t>(timerIndex));
+    }
+}
+
+void TimerWheel::cancelAll()
+{
+    if (_pendingCount == 0)
+    {
+        return;
+    }
+
+    for (auto& node : _nodes)
+    {
+        node.slot = _none;
+    }
+
+    for (auto& head : _heads)
+    {
+        head = _none;
+    }
+
+    _pendingCount = 0;
+}
+
+void TimerWheel::link(uint16_t index, uint16_t list)
+{
+    auto& node = _nodes[index];
+
+    node.slot = list;
+    node.prev = _none;
+    node.next = _heads[list];
+
+    if (node.next != _none)
+    {
+        _nodes[node.next].prev = index;
+    }
+
+    _heads[list] = index;
+    ++_pendingCount;
+}
+
+void TimerWheel::unlink(uint16_t index)
+{
+    auto& node = _nodes[index];
+
+    if (node.prev != _none)
+    {
+        _nodes[node.prev].next = node.next;
+    }
+    else
+    {
+        _heads[node.slot] = node.next;
+    }
+
+    if (node.next != _none)
+    {
+        _nodes[node.next].prev = node.prev;
+    }
+
+    node.slot = _none;
+    --_pendingCount;
+}
+
+void TimerWheel::collectExpired()
+{
+    const auto last = getSlotNumber(_now_msec);
+
+    // From the last visited slot, which may still hold timers due later in it,
+    // but not more than a revolution
+    auto count = last - _cursor + 1;
+    if (count > slotCount)
+    {
+        count = slotCount;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        const auto slot = static_cast<uint16_t>((last - i) % slotCount);
+        auto index = _heads[slot];
+
+        while (index != _none)
+        {
+            const auto next = _nodes[index].next;
+
+            // Wraparound safe
+            if (static_cast<int32_t>(_nodes[index].deadline_msec - _now_msec) <= 0)
+            {
+                unlink(index);
+                link(index, _expiredList);
+            }
+
+            index = next;
+        }
+    }
+
+    _cursor = last;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdbool>
+
+#include <vector>
+
+// Hashed timing wheel: a pending timer hangs in the slot its deadline falls into, so
+// starting, restarting and cancelling a timer are O(1) and a tick only visits the slots
+// its elapsed time passed over. Timers longer than a revolution stay in their slot for
+// more revolutions, which only costs a visit per revolution.
+// Timers are identified by index; their nodes are allocated once by setCapacity().
+class TimerWheel
+{
+public:
+    static const size_t maxCapacity = 0xFFFE;
+    static const uint32_t maxDelay_msec = 0x7FFFFFFF;
+
+    static const uint32_t slotDuration_msec = 8;
+    static const size_t slotCount = 512;
+
+    TimerWheel();
+
+    // Cancels every timer
+    bool setCapacity(size_t value);
+    size_t getCapacity() const { return _nodes.size(); }
+
+    // Restarts a pending timer
+    void start(size_t timerIndex, uint32_t delay_msec);
+    void cancel(size_t timerIndex);
+    void cancelAll();
+
+    bool isPending(size_t timerIndex) const { return (timerIndex < _nodes.size()) && (_nodes[timerIndex].slot != _none); }
+    size_t getPendingCount() const { return _pendingCount; }
+
+    // Advances the clock and calls onExpired(timerIndex) for every timer that is due.
+    // onExpired may start and cancel timers
+    template <typename F>
+    void advance(uint32_t elapsed_msec, F onExpired);
+
+private:
+    struct Node
+    {
+        uint32_t deadline_msec;
+        uint16_t prev;
+        uint16_t next;
+        uint16_t slot;
+    };
+
+    static const uint16_t _none = 0xFFFF;
+
+    // Extra list of the due timers, filled before onExpired is called for them
+    static const uint16_t _expiredList = slotCount;
+
+    static uint32_t getSlotNumber(uint32_t time_msec) { return time_msec / slotDuration_msec; }
+
+    void link(uint16_t index, uint16_t list);
+    void unlink(uint16_t index);
+    void collectExpired();
+
+    std::vector<Node> _nodes;
+    uint16_t _heads[slotCount + 1];
+
+    size_t _pendingCount = 0;
+
+    uint32_t _now_msec = 0;
+    uint32_t _cursor = 0;   // Slot number of the last visited slot
+};
+
+template <typename F>
+void TimerWheel::advance(uint32_t elapsed_msec, F onExpired)
+{
+    _now_msec += elapsed_msec;
+
+    if (_pendingCount == 0)
+    {
+        _cursor = getSlotNumber(_now_msec);
+        return;
+    }
+
+    collectExpired();
+
+    while (_heads[_expiredList] != _none)
+    {
+        const auto index = _heads[_expiredList];
+        unlink(index);
+
+        onExpired(static_cast<size_t>(index));
+    }
+}
@@ -13,7 +13,13 @@ enum class EventType
 {
     none,
     rise,
-    fall 
+    fall,
+
+    // Gestures, timed by GestureTimes
+    click,          // Short press, after the double click time passed without a second one
+    doubleClick,    // Second short press within the double click time
+    longPress,      // Held for the long press time
+    holdRepeat      // Every repeat time while held after a long press
 };
 
 enum class ActionType
@@ -23,7 +29,18 @@ enum class ActionType
     turnOff,
     toggle,
     localOff,
-    globalOff
+    globalOff,
+
+    // Timed by RuleAction::duration_msec, the output is turned off when it runs out.
+    // Any other action on the output cancels the timer
+    onFor,      // On now, a repeated action restarts the timer
+    offAfter,   // Left as is now, a repeated action restarts the timer
+    pulse,      // On now, repeated actions are ignored until the timer runs out
+
+    // RuleAction::outputChannelIndex is the index of the output group
+    groupOn,
+    groupOff,
+    groupToggle // Off if any output of the group is on, on otherwise
 };
 
 enum class DiscreteState
@@ -33,6 +50,27 @@ enum class DiscreteState
     off
 };
 
+enum class InputFilterKind
+{
+    acWindow,   // Edges counted over a fixed window
+    acEdge,     // Intervals between (timestamped) edges
+    dcDebounce, // Raw state that stayed the same for the debounce time
+    raw         // Raw state as is
+};
+
+struct InputFilterSettings
+{
+    InputFilterKind kind = InputFilterKind::acWindow;
+    int debounce_msec = 10;     // dcDebounce only
+};
+
+struct GestureTimes
+{
+    int longPress_msec = 700;
+    int doubleClick_msec = 350;     // 0: clicks are reported on release, no double clicks
+    int holdRepeat_msec = 300;      // 0: no repeats
+};
+
 struct RuleCondition
 {
     size_t inputChannelIndex;
@@ -41,14 +79,31 @@ struct RuleCondition
 
 struct RuleAction
 {
-    size_t outputChannelIndex;
+    size_t outputChannelIndex;  // Output group index for the group actions
     ActionType actionType;
+    uint32_t duration_msec;     // Timed actions only
 };
 
+enum class GuardSource
+{
+    output,
+    input
+};
+
+// The rule only runs if the channel is in the state, unknown states fail every guard
+struct RuleGuard
+{
+    GuardSource source;
+    size_t channelIndex;
+    DiscreteState state;
+};
+
+// The actions run in order if every guard holds
 struct Rule
 {
     RuleCondition condition;
-    RuleAction action;
+    std::vector<RuleAction> actions;
+    std::vector<RuleGuard> guards;
 };
 
 enum class ActionManagerError
@@ -56,7 +111,16 @@ enum class ActionManagerError
     none,
     invalidChannelIndex,
     tooManyChannels,
-    tooManyRules
+    tooManyRules,
+    tooManyGroups
+};
+
+enum class RulesReloadResult
+{
+    success,
+    busy,           // The previous reload is not taken by the control task yet
+    readFailed,
+    invalidRules    // Some rules cannot be parsed or added, the running rules are kept
 };
 
 enum class EventDetectorError
@@ -118,6 +182,10 @@ public:
 
     virtual ActionManagerError addRule(const Rule& rule) = 0;
     virtual ActionManagerError clearRules() = 0;
+
+    // Bit per output in 32-bit words, group indexes follow the order the groups are added
+    virtual ActionManagerError addOutputGroup(const uint32_t* mask, size_t wordCount) = 0;
+    virtual ActionManagerError clearOutputGroups() = 0;
 };
 
 class IInputFilter
@@ -214,12 +282,40 @@ public:
     virtual void sendGlobalOff() = 0;
 };
 
+// Raw change of an input channel
+struct InputEdge
+{
+    uint16_t channelIndex;
+    uint32_t time_usec;     // By a free-running microsecond clock
+};
+
 class IInputDevice
 {
 public:
     virtual ~IInputDevice() = default;
 
     virtual bool getCurrentValue(size_t channelIndex, DiscreteState& curValue_out) const = 0;
+
+    // Whole input frame, bit per channel in 32-bit words: the input is on, the input could be read.
+    // Fills wordCount words of both, channels the device does not have are not valid
+    virtual void readAll(uint32_t* onMask_out, uint32_t* validMask_out, size_t wordCount) const = 0;
+
+    // Raw changes since the previous call, oldest first. Fills up to maxCount edges and
+    // returns their number, 0 if the device does not timestamp the changes
+    virtual size_t takeEdges(InputEdge* edges_out, size_t maxCount) = 0;
+};
+
+class IInterruptSource
+{
+public:
+    virtual ~IInterruptSource() = default;
+
+    // Returns true if the interrupt fired since the previous call
+    virtual bool takePending() = 0;
+
+    // Time of the oldest interrupt not taken yet by a free-running microsecond clock,
+    // false if there is none. The queue is independent of takePending()
+    virtual bool takeEdgeTime_usec(uint32_t& time_usec_out) = 0;
 };
 
 class IOutputDevice
@@ -269,6 +365,10 @@ public:
 	virtual void clear() = 0;
 };
 
+class InputEventQueue;
+class TickProfiler;
+class InputCapture;
+
 class ILightControllerFacade
 {
 public:
@@ -277,6 +377,9 @@ public:
 	virtual void registerInputEventListener(IInputEventListener& listener) = 0;
 	virtual void unregisterInputEventListener(IInputEventListener& listener) = 0;
 	
+	virtual bool registerInputEventQueue(InputEventQueue& queue) = 0;
+	virtual void unregisterInputEventQueue(InputEventQueue& queue) = 0;
+	
 	virtual size_t getInputCount() const = 0;
 	virtual size_t getOutputCount() const = 0;
 	
@@ -291,5 +394,25 @@ public:
 	virtual DiscreteState getOutputState(const std::string& name) const = 0;
 	virtual bool setOutputState(const std::string& name, DiscreteState value) = 0;
 	
+	virtual void getOutputGroupNames(std::function<void(const std::string* name_p)> inserter) const = 0;
+	virtual bool isOutputGroupExists(const std::string& name) const = 0;
+	
+	// On if any output of the group is on, off if all are off
+	virtual DiscreteState getOutputGroupState(const std::string& name) const = 0;
+	virtual bool setOutputGroupState(const std::string& name, DiscreteState value) = 0;
+	
 	virtual bool localOff() = 0;
+	
+	// Parses the rules file again on the calling task, the new rules replace the running ones
+	// between two control ticks. The output states and the running timers are kept
+	virtual RulesReloadResult reloadRules() = 0;
+	
+	virtual const TickProfiler& getProfiler() const = 0;
+	virtual void resetProfiler() = 0;
+	
+	// Raw input capture. Stopping returns true once the control task no longer records,
+	// the capture may be read then
+	virtual bool startInputCapture() = 0;
+	virtual bool stopInputCapture() = 0;
+	virtual const InputCapture& getInputCapture() const = 0;
 };
\ No newline at end of file
@@ -0,0 +1,227 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "action_manager.h"
+
+namespace
+{
+
+const int tick_msec = 10;
+
+// Output 0 is the timed one, group 0 holds outputs 0 and 1.
+// Every input has one rule, bound to its rise
+class ActionManagerTest : public testing::Test
+{
+protected:
+    ActionManagerTest()
+    {
+        _manager.setInputChannelCount(8);
+        _manager.setOutputChannelCount(4);
+
+        const uint32_t groupMask[] = { 0x3 };
+        _manager.addOutputGroup(groupMask, 1);
+    }
+
+    static RuleAction makeAction(size_t outputChannelIndex, ActionType actionType, uint32_t duration_msec = 0)
+    {
+        RuleAction result;
+
+        result.outputChannelIndex = outputChannelIndex;
+        result.actionType = actionType;
+        result.duration_msec = duration_msec;
+
+        return result;
+    }
+
+    void addRule(size_t inputChannelIndex, const RuleAction& action)
+    {
+        Rule rule;
+
+        rule.condition.inputChannelIndex = inputChannelIndex;
+        rule.condition.eventType = EventType::rise;
+        rule.actions.push_back(action);
+
+        ASSERT_EQ(_manager.addRule(rule), ActionManagerError::none);
+    }
+
+    // The event in a tick of its own
+    void fire(size_t inputChannelIndex)
+    {
+        _manager.setInputEvent(inputChannelIndex, EventType::rise);
+        run(tick_msec);
+    }
+
+    void run(int duration_msec)
+    {
+        for (int elapsed_msec = 0; elapsed_msec < duration_msec; elapsed_msec += tick_msec)
+        {
+            _manager.advanceTime(tick_msec);
+            _manager.execute();
+        }
+    }
+
+    DiscreteState getState(size_t outputChannelIndex)
+    {
+        DiscreteState result;
+        _manager.getOutputState(outputChannelIndex, result);
+
+        return result;
+    }
+
+    ActionManager _manager;
+};
+
+} // namespace
+
+TEST_F(ActionManagerTest, OnForRestarts)
+{
+    addRule(0, makeAction(0, ActionType::onFor, 100));
+
+    fire(0);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+
+    run(50);
+    fire(0);
+
+    // 150 ms after the first one, 90 after the second
+    run(90);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+
+    run(tick_msec);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 0u);
+}
+
+TEST_F(ActionManagerTest, PulseIsIgnoredWhileItsTimerRuns)
+{
+    addRule(0, makeAction(0, ActionType::pulse, 100));
+
+    fire(0);
+    run(50);
+    fire(0);
+
+    run(30);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+
+    // 100 ms after the first one
+    run(tick_msec);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+
+    // And starts again once it ran out
+    fire(0);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 1u);
+}
+
+TEST_F(ActionManagerTest, OffAfterKeepsTheCurrentState)
+{
+    addRule(0, makeAction(0, ActionType::offAfter, 100));
+    addRule(1, makeAction(0, ActionType::turnOn));
+    addRule(2, makeAction(0, ActionType::turnOff));
+
+    // Unknown stays unknown until the timer runs out
+    fire(0);
+    EXPECT_EQ(getState(0), DiscreteState::unknown);
+
+    run(100);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+
+    fire(1);
+    fire(0);
+    run(90);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+
+    run(tick_msec);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+
+    fire(2);
+    fire(0);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 1u);
+
+    // Restarted too
+    run(50);
+    fire(0);
+    run(80);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 1u);
+}
+
+// Input 0 starts the timer, input 1 is the untimed action
+TEST_F(ActionManagerTest, UntimedActionsCancelTheTimer)
+{
+    const RuleAction cancellers[] = {
+        makeAction(0, ActionType::turnOn),
+        makeAction(0, ActionType::turnOff),
+        makeAction(0, ActionType::toggle),
+        makeAction(0, ActionType::groupOn),
+        makeAction(0, ActionType::groupOff),
+        makeAction(0, ActionType::groupToggle),
+        makeAction(0, ActionType::localOff),
+        makeAction(0, ActionType::globalOff),
+    };
+
+    for (const auto& canceller : cancellers)
+    {
+        _manager.clearRules();
+
+        addRule(0, makeAction(0, ActionType::onFor, 100));
+        addRule(1, canceller);
+
+        fire(0);
+        ASSERT_EQ(_manager.getPendingTimerCount(), 1u);
+
+        fire(1);
+        EXPECT_EQ(_manager.getPendingTimerCount(), 0u) << "action " << static_cast<int>(canceller.actionType);
+
+        // The timer is gone, the state of the action stays past its deadline
+        const auto state = getState(0);
+
+        run(200);
+        EXPECT_EQ(getState(0), state) << "action " << static_cast<int>(canceller.actionType);
+    }
+}
+
+TEST_F(ActionManagerTest, TurnOnOutlivesAnOnForItCancelled)
+{
+    addRule(0, makeAction(0, ActionType::onFor, 100));
+    addRule(1, makeAction(0, ActionType::turnOn));
+
+    fire(0);
+    fire(1);
+
+    run(200);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+}
+
+TEST_F(ActionManagerTest, ForcingCancelsTheTimer)
+{
+    addRule(0, makeAction(0, ActionType::onFor, 100));
+
+    fire(0);
+    _manager.forceOutput(0, DiscreteState::on);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 0u);
+
+    fire(0);
+    _manager.forceOutputGroup(0, DiscreteState::off);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 0u);
+
+    fire(0);
+    _manager.forceLocalOff();
+    run(tick_msec);
+    EXPECT_EQ(_manager.getPendingTimerCount(), 0u);
+    EXPECT_EQ(getState(0), DiscreteState::off);
+}
+
+TEST_F(ActionManagerTest, ForcingOtherOutputsKeepsTheTimer)
+{
+    addRule(0, makeAction(0, ActionType::onFor, 100));
+
+    fire(0);
+    _manager.forceOutput(1, DiscreteState::on);
+    run(tick_msec);
+
+    EXPECT_EQ(_manager.getPendingTimerCount(), 1u);
+    EXPECT_EQ(getState(0), DiscreteState::on);
+}
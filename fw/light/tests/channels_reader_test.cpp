@@ -0,0 +1,110 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include <FS.h>
+
+#include "channels_reader.h"
+
+namespace
+{
+
+const char* const channelsFilename = "/input_channels.txt";
+
+// One channel per line, the channel of a rejected filter keeps its number and gets the AC filter
+class InputChannelsReaderTest : public testing::Test
+{
+protected:
+    void read(const char* text)
+    {
+        _fileSystem.setFile(channelsFilename, text);
+
+        ChannelsReader<InputChannelInfo> reader;
+
+        reader.setFilename(channelsFilename);
+        reader.setFileSystem(&_fileSystem);
+        reader.setChannelList(&_channels);
+
+        ASSERT_TRUE(reader.execute());
+    }
+
+    InputFilterSettings getFilter(size_t channelIndex) const
+    {
+        InputChannelInfo info;
+        EXPECT_TRUE(_channels.getChannelInfo(channelIndex, info)) << channelIndex;
+
+        return info.filter;
+    }
+
+    void expectAc(size_t channelIndex) const
+    {
+        const auto filter = getFilter(channelIndex);
+
+        EXPECT_EQ(filter.kind, InputFilterKind::acWindow) << channelIndex;
+        EXPECT_EQ(filter.debounce_msec, InputFilterSettings().debounce_msec) << channelIndex;
+    }
+
+    FS _fileSystem;
+    ChannelList<InputChannelInfo> _channels;
+};
+
+} // namespace
+
+TEST_F(InputChannelsReaderTest, FilterKinds)
+{
+    read(
+        "hall_switch\n"
+        "room_switch ac\n"
+        "door_contact dc\n"
+        "button dc:15\n"
+        "sensor raw\n"
+        "pump DC:0\n");
+
+    expectAc(0);
+    expectAc(1);
+
+    EXPECT_EQ(getFilter(2).kind, InputFilterKind::dcDebounce);
+    EXPECT_EQ(getFilter(2).debounce_msec, InputFilterSettings().debounce_msec);
+
+    EXPECT_EQ(getFilter(3).kind, InputFilterKind::dcDebounce);
+    EXPECT_EQ(getFilter(3).debounce_msec, 15);
+
+    EXPECT_EQ(getFilter(4).kind, InputFilterKind::raw);
+
+    EXPECT_EQ(getFilter(5).kind, InputFilterKind::dcDebounce);
+    EXPECT_EQ(getFilter(5).debounce_msec, 0);
+}
+
+TEST_F(InputChannelsReaderTest, LongestDebounce)
+{
+    read("button dc:65535\n");
+
+    EXPECT_EQ(getFilter(0).kind, InputFilterKind::dcDebounce);
+    EXPECT_EQ(getFilter(0).debounce_msec, 65535);
+}
+
+TEST_F(InputChannelsReaderTest, InvalidFiltersFallBackToAc)
+{
+    read(
+        "a raw:5\n"
+        "b dc:\n"
+        "c dc:70000\n"
+        "d ac:5\n"
+        "e dc:-5\n"
+        "f dc:15ms\n"
+        "g analog\n"
+        "h dc:15 raw\n"
+        "last dc:15\n");
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        expectAc(i);
+    }
+
+    // Not renumbered
+    std::string name;
+    ASSERT_TRUE(_channels.getChannelName(8, name));
+    EXPECT_EQ(name, "last");
+    EXPECT_EQ(getFilter(8).debounce_msec, 15);
+}
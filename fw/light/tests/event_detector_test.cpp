@@ -0,0 +1,305 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <ostream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "event_detector.h"
+
+namespace
+{
+
+const int tick_msec = 10;
+
+struct DetectedEvent
+{
+    uint32_t time_msec;
+    size_t channelIndex;
+    EventType eventType;
+
+    bool operator==(const DetectedEvent& other) const
+    {
+        return (time_msec == other.time_msec) && (channelIndex == other.channelIndex) && (eventType == other.eventType);
+    }
+};
+
+void PrintTo(const DetectedEvent& event, std::ostream* stream_p)
+{
+    *stream_p << "{" << event.time_msec << " ms, channel " << event.channelIndex << ", event " << static_cast<int>(event.eventType) << "}";
+}
+
+// Scripted switch presses: the states set between run() calls are seen from the next tick on,
+// the events are recorded with the time of the tick that reported them
+class GestureScript
+{
+public:
+    explicit GestureScript(const GestureTimes& gestureTimes = GestureTimes(), size_t channelCount = 2)
+    {
+        _detector.setChannelCount(channelCount);
+        _detector.setGestureTimes(gestureTimes);
+
+        _states.assign(channelCount, DiscreteState::off);
+    }
+
+    void set(size_t channelIndex, DiscreteState value) { _states[channelIndex] = value; }
+    void press(size_t channelIndex) { set(channelIndex, DiscreteState::on); }
+    void release(size_t channelIndex) { set(channelIndex, DiscreteState::off); }
+
+    void run(int duration_msec, int step_msec = tick_msec)
+    {
+        for (int elapsed_msec = 0; elapsed_msec < duration_msec; elapsed_msec += step_msec)
+        {
+            _time_msec += static_cast<uint32_t>(step_msec);
+            _detector.advanceTime(step_msec);
+
+            for (size_t i = 0; i < _states.size(); ++i)
+            {
+                _detector.setInputState(i, _states[i]);
+            }
+
+            _detector.execute();
+            collectEvents();
+        }
+    }
+
+    const std::vector<DetectedEvent>& getEvents() const { return _events; }
+
+private:
+    void collectEvents()
+    {
+        for (size_t kind = 0; kind < EventDetector::eventKindCount; ++kind)
+        {
+            for (size_t i = 0; i < _states.size(); ++i)
+            {
+                const auto word = _detector.getEventWord(kind, i / BitUtils::bitsPerWord);
+
+                if ((word & BitUtils::bitMask(i % BitUtils::bitsPerWord)) != 0)
+                {
+                    _events.push_back({ _time_msec, i, EventDetector::getEventType(kind) });
+                }
+            }
+        }
+    }
+
+    EventDetector _detector;
+    std::vector<DiscreteState> _states;
+
+    uint32_t _time_msec = 0;
+    std::vector<DetectedEvent> _events;
+};
+
+GestureTimes makeGestureTimes(int longPress_msec, int doubleClick_msec, int holdRepeat_msec)
+{
+    GestureTimes result;
+
+    result.longPress_msec = longPress_msec;
+    result.doubleClick_msec = doubleClick_msec;
+    result.holdRepeat_msec = holdRepeat_msec;
+
+    return result;
+}
+
+} // namespace
+
+TEST(EventDetectorTest, ClickIsReportedWhenTheDoubleClickTimeEnds)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(1000);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 460, 0, EventType::click },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, ClickIsReportedOnReleaseWithoutDoubleClicks)
+{
+    GestureScript script(makeGestureTimes(700, 0, 300));
+
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(1000);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 110, 0, EventType::click },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, SecondPressInTimeIsADoubleClick)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(200);
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(1000);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 310, 0, EventType::rise },
+        { 410, 0, EventType::fall },
+        { 410, 0, EventType::doubleClick },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, LateSecondPressIsAnotherClick)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(400);
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(1000);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 460, 0, EventType::click },
+        { 510, 0, EventType::rise },
+        { 610, 0, EventType::fall },
+        { 960, 0, EventType::click },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, HeldPressRepeatsAfterTheLongPress)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(1400);
+    script.release(0);
+    script.run(1000);
+
+    // No click after a long press
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 710, 0, EventType::longPress },
+        { 1010, 0, EventType::holdRepeat },
+        { 1310, 0, EventType::holdRepeat },
+        { 1410, 0, EventType::fall },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, LongPressOfTheSecondPress)
+{
+    GestureScript script(makeGestureTimes(700, 350, 0));
+
+    script.press(0);
+    script.run(100);
+    script.release(0);
+    script.run(100);
+    script.press(0);
+    script.run(1500);
+    script.release(0);
+    script.run(1000);
+
+    // Neither a click nor a double click, and no repeats when they are off
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 210, 0, EventType::rise },
+        { 910, 0, EventType::longPress },
+        { 1710, 0, EventType::fall },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, RepeatsKeepTheirCadenceOverLongTicks)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(710);
+
+    // A 250 ms tick ends at 960 ms, before the first repeat is due
+    script.run(250, 250);
+    script.run(100);
+
+    // A tick longer than a repeat period reports one repeat and restarts the cadence
+    script.run(700, 700);
+    script.run(300);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 710, 0, EventType::longPress },
+        { 1010, 0, EventType::holdRepeat },
+        { 1760, 0, EventType::holdRepeat },
+        { 2060, 0, EventType::holdRepeat },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, UnknownStateDropsTheGesture)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(100);
+    script.set(0, DiscreteState::unknown);
+    script.run(1000);
+    script.release(0);
+    script.run(1000);
+
+    // Neither a fall nor a click or a long press from the unknown state
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
+
+TEST(EventDetectorTest, ChannelsAreTimedApart)
+{
+    GestureScript script;
+
+    script.press(0);
+    script.run(50);
+    script.press(1);
+    script.run(50);
+    script.release(0);
+    script.run(800);
+    script.release(1);
+    script.run(1000);
+
+    const std::vector<DetectedEvent> expected {
+        { 10, 0, EventType::rise },
+        { 60, 1, EventType::rise },
+        { 110, 0, EventType::fall },
+        { 460, 0, EventType::click },
+        { 760, 1, EventType::longPress },
+        { 910, 1, EventType::fall },
+    };
+
+    EXPECT_EQ(script.getEvents(), expected);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+
+// Host stand-in for the parts of the Arduino core the file readers use
+
+class String
+{
+public:
+    String() = default;
+    String(const char* value_p) : _value(value_p) {}
+    String(const std::string& value) : _value(value) {}
+
+    const char* c_str() const { return _value.c_str(); }
+    size_t length() const { return _value.size(); }
+
+    bool operator==(const String& other) const { return _value == other._value; }
+
+private:
+    std::string _value;
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+// Host stand-in for the Arduino file system API, the files live in memory
+
+namespace fs
+{
+
+using FileData = std::vector<uint8_t>;
+
+class File
+{
+public:
+    File() = default;
+    explicit File(const std::shared_ptr<FileData>& data_p) : _data_p(data_p) {}
+
+    explicit operator bool() const { return _data_p != nullptr; }
+
+    size_t size() const { return (_data_p != nullptr) ? _data_p->size() : 0; }
+    int available() const { return static_cast<int>(size() - _position); }
+
+    size_t read(uint8_t* buffer_p, size_t size)
+    {
+        size_t count = 0;
+
+        while ((count < size) && (available() > 0))
+        {
+            buffer_p[count++] = (*_data_p)[_position++];
+        }
+
+        return count;
+    }
+
+    size_t write(const uint8_t* buffer_p, size_t size)
+    {
+        if (_data_p == nullptr)
+        {
+            return 0;
+        }
+
+        _data_p->insert(_data_p->end(), buffer_p, buffer_p + size);
+        return size;
+    }
+
+    String readStringUntil(char terminator)
+    {
+        std::string result;
+
+        while (available() > 0)
+        {
+            const auto ch = static_cast<char>((*_data_p)[_position++]);
+            if (ch == terminator)
+            {
+                break;
+            }
+
+            result += ch;
+        }
+
+        return String(result);
+    }
+
+    void close()
+    {
+        _data_p.reset();
+        _position = 0;
+    }
+
+private:
+    std::shared_ptr<FileData> _data_p;
+    size_t _position = 0;
+};
+
+class FS
+{
+public:
+    // "r" opens an existing file, "w" creates or truncates one
+    File open(const String& path, const char* mode = "r")
+    {
+        const std::string name = path.c_str();
+
+        if (std::string(mode) == "w")
+        {
+            _files[name] = std::make_shared<FileData>();
+        }
+
+        const auto it = _files.find(name);
+        return (it != _files.end()) ? File(it->second) : File();
+    }
+
+    bool exists(const String& path) const { return _files.count(path.c_str()) != 0; }
+    bool remove(const String& path) { return _files.erase(path.c_str()) != 0; }
+
+    // Test side
+    void setFile(const std::string& path, const std::string& text) { _files[path] = std::make_shared<FileData>(text.begin(), text.end()); }
+    FileData& getFile(const std::string& path) { return *_files.at(path); }
+
+private:
+    std::map<std::string, std::shared_ptr<FileData>> _files;
+};
+
+} // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,399 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "input_filter_ac.h"
+#include "input_filter_bank.h"
+
+namespace
+{
+
+// Raw samples of every channel of a tick, packed for InputFilterBank::update()
+class RawWords
+{
+public:
+    RawWords()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for (size_t w = 0; w < InputFilterBank::maxWordCount; ++w)
+        {
+            _on[w] = 0;
+            _known[w] = 0;
+        }
+    }
+
+    void set(size_t channelIndex, DiscreteState value)
+    {
+        BitUtils::assign(_on, channelIndex, value == DiscreteState::on);
+        BitUtils::assign(_known, channelIndex, value != DiscreteState::unknown);
+    }
+
+    void update(InputFilterBank& bank, int timeElapsed_msec) const { bank.update(_on, _known, timeElapsed_msec); }
+
+private:
+    BitUtils::Word _on[InputFilterBank::maxWordCount];
+    BitUtils::Word _known[InputFilterBank::maxWordCount];
+};
+
+// Raw samples of an input that the load switches between mains on, off, bouncing and unreadable
+class RandomTrace
+{
+public:
+    explicit RandomTrace(std::mt19937& random) :
+        _random(random)
+    {
+    }
+
+    DiscreteState next()
+    {
+        if (std::uniform_int_distribution<int>(0, 99)(_random) < 3)
+        {
+            _mode = std::uniform_int_distribution<int>(0, 3)(_random);
+        }
+
+        if (std::uniform_int_distribution<int>(0, 99)(_random) < 2)
+        {
+            return DiscreteState::unknown;
+        }
+
+        // Edge probability in percent: mains, steady, bouncing, steady again
+        static const int edgePercents[] = { 90, 0, 30, 0 };
+
+        if (std::uniform_int_distribution<int>(0, 99)(_random) < edgePercents[_mode])
+        {
+            _isOn = !_isOn;
+        }
+
+        return _isOn ? DiscreteState::on : DiscreteState::off;
+    }
+
+private:
+    std::mt19937& _random;
+
+    int _mode = 0;
+    bool _isOn = false;
+};
+
+// Timestamped edges of an acEdge channel at 50 Hz: the interval threshold is 30 ms,
+// edges closer than 2.5 ms are bounce
+class AcEdgeBankTest : public testing::Test
+{
+protected:
+    AcEdgeBankTest()
+    {
+        _bank.setChannelCount(2);
+        _bank.setKind(InputFilterKind::acEdge);
+        _bank.setNominalFrequency_hz(50);
+
+        _raw.set(0, DiscreteState::off);
+        _raw.set(1, DiscreteState::off);
+    }
+
+    // A tick of tick_msec, with the edges of the channel at the given offsets into it
+    void tick(size_t channelIndex, const std::vector<uint32_t>& edgeOffsets_usec)
+    {
+        for (const auto offset_usec : edgeOffsets_usec)
+        {
+            _bank.addEdge(channelIndex, _time_usec + offset_usec);
+        }
+
+        _time_usec += tick_msec * 1000;
+        _raw.update(_bank, tick_msec);
+    }
+
+    void idle(int duration_msec)
+    {
+        for (int elapsed_msec = 0; elapsed_msec < duration_msec; elapsed_msec += tick_msec)
+        {
+            tick(0, {});
+        }
+    }
+
+    static const int tick_msec = 5;
+
+    InputFilterBank _bank;
+    RawWords _raw;
+
+    // Starts away from zero, timestamps are arbitrary
+    uint32_t _time_usec = 1000000;
+};
+
+InputFilterSettings makeSettings(InputFilterKind kind, int debounce_msec = 10)
+{
+    InputFilterSettings result;
+
+    result.kind = kind;
+    result.debounce_msec = debounce_msec;
+
+    return result;
+}
+
+} // namespace
+
+// 40 channels, so the second word is a partial one
+TEST(InputFilterBankTest, AcWindowMatchesInputFilterAc)
+{
+    const size_t channelCount = 40;
+
+    std::mt19937 random(20240611);
+    std::uniform_int_distribution<int> elapsedTimes_msec(1, 20);
+
+    InputFilterBank bank;
+
+    bank.setChannelCount(channelCount);
+    bank.setKind(InputFilterKind::acWindow);
+
+    std::vector<InputFilterAc> filters(channelCount);
+    std::vector<RandomTrace> traces(channelCount, RandomTrace(random));
+
+    RawWords raw;
+    size_t changeCount = 0;
+
+    for (int t = 0; t < 20000; ++t)
+    {
+        const auto elapsed_msec = elapsedTimes_msec(random);
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            const auto value = traces[i].next();
+
+            raw.set(i, value);
+            filters[i].update(value, elapsed_msec);
+        }
+
+        raw.update(bank, elapsed_msec);
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            ASSERT_EQ(bank.getState(i), filters[i].resultingState()) << "tick " << t << ", channel " << i;
+        }
+
+        changeCount += bank.hasChanges() ? 1 : 0;
+    }
+
+    // The traces did move the states
+    EXPECT_GT(changeCount, 100u);
+}
+
+TEST_F(AcEdgeBankTest, OnAfterThreeEdgesWithinTheInterval)
+{
+    tick(0, { 1000 });
+    EXPECT_NE(_bank.getState(0), DiscreteState::on);
+
+    tick(0, {});
+    tick(0, { 1000 });
+    EXPECT_NE(_bank.getState(0), DiscreteState::on);
+
+    // 30 ms after the previous one is still in time
+    idle(25);
+    tick(0, { 1000 });
+    EXPECT_EQ(_bank.getState(0), DiscreteState::on);
+}
+
+TEST_F(AcEdgeBankTest, LateEdgeStartsCountingAgain)
+{
+    tick(0, { 1000 });
+    tick(0, { 1000 });
+
+    // 30.001 ms
+    idle(25);
+    tick(0, { 1001 });
+    tick(0, { 1000 });
+    EXPECT_NE(_bank.getState(0), DiscreteState::on);
+
+    tick(0, { 1000 });
+    EXPECT_EQ(_bank.getState(0), DiscreteState::on);
+}
+
+TEST_F(AcEdgeBankTest, BounceIsNotCounted)
+{
+    tick(0, { 1000, 2000, 3000 });
+    tick(0, { 1000 });
+    EXPECT_NE(_bank.getState(0), DiscreteState::on);
+
+    tick(0, { 1000 });
+    EXPECT_EQ(_bank.getState(0), DiscreteState::on);
+}
+
+TEST_F(AcEdgeBankTest, OffWhenNoEdgeCameForTheInterval)
+{
+    tick(0, { 0, 2500 });
+    tick(0, { 0 });
+    ASSERT_EQ(_bank.getState(0), DiscreteState::on);
+
+    // The last edge was accepted at 5 ms, off once more than 30 ms passed
+    idle(25);
+    EXPECT_EQ(_bank.getState(0), DiscreteState::on);
+
+    idle(5);
+    EXPECT_EQ(_bank.getState(0), DiscreteState::off);
+
+    // And on again after three edges
+    tick(0, { 0 });
+    tick(0, { 0 });
+    EXPECT_EQ(_bank.getState(0), DiscreteState::off);
+
+    tick(0, { 0 });
+    EXPECT_EQ(_bank.getState(0), DiscreteState::on);
+}
+
+TEST_F(AcEdgeBankTest, RawChangesCountUntilTheFirstTimestampedEdge)
+{
+    // Channel 1 is never timestamped and follows its raw edges
+    for (int t = 0; t < 4; ++t)
+    {
+        _raw.set(1, (t % 2 != 0) ? DiscreteState::on : DiscreteState::off);
+        tick(0, {});
+    }
+
+    EXPECT_EQ(_bank.getState(1), DiscreteState::on);
+}
+
+TEST_F(AcEdgeBankTest, TimestampedChannelIgnoresRawChanges)
+{
+    tick(0, { 1000 });
+
+    // Raw edges every tick would turn the channel on
+    for (int t = 0; t < 10; ++t)
+    {
+        _raw.set(0, (t % 2 != 0) ? DiscreteState::on : DiscreteState::off);
+        tick(1, {});
+    }
+
+    EXPECT_EQ(_bank.getState(0), DiscreteState::off);
+}
+
+TEST(InputFilterBankTest, DebouncedInputSettlesAfterTheDebounceTime)
+{
+    const int tick_msec = 5;
+
+    InputFilterBank bank;
+
+    bank.setChannelCount(1);
+    bank.setChannelSettings(0, makeSettings(InputFilterKind::dcDebounce, 20));
+
+    RawWords raw;
+
+    // The first known state needs the debounce time too
+    raw.set(0, DiscreteState::off);
+    for (int time_msec = 0; time_msec < 20; time_msec += tick_msec)
+    {
+        raw.update(bank, tick_msec);
+        EXPECT_EQ(bank.getState(0), DiscreteState::unknown) << time_msec;
+    }
+
+    raw.update(bank, tick_msec);
+    EXPECT_EQ(bank.getState(0), DiscreteState::off);
+
+    // Bouncing for a while, every change starts the time again
+    for (int t = 0; t < 7; ++t)
+    {
+        raw.set(0, (t % 2 == 0) ? DiscreteState::on : DiscreteState::off);
+        raw.update(bank, tick_msec);
+        EXPECT_EQ(bank.getState(0), DiscreteState::off) << t;
+    }
+
+    // On since the last bounce, an unknown sample does not start the time again
+    const DiscreteState samples[] = { DiscreteState::on, DiscreteState::unknown, DiscreteState::on };
+
+    for (const auto sample : samples)
+    {
+        raw.set(0, sample);
+        raw.update(bank, tick_msec);
+        EXPECT_EQ(bank.getState(0), DiscreteState::off);
+    }
+
+    raw.set(0, DiscreteState::on);
+    raw.update(bank, tick_msec);
+    EXPECT_EQ(bank.getState(0), DiscreteState::on);
+}
+
+TEST(InputFilterBankTest, RawPassesTheSamplesThrough)
+{
+    InputFilterBank bank;
+
+    bank.setChannelCount(1);
+    bank.setKind(InputFilterKind::raw);
+
+    RawWords raw;
+
+    const DiscreteState samples[] = {
+        DiscreteState::on, DiscreteState::off, DiscreteState::unknown, DiscreteState::off, DiscreteState::on, DiscreteState::on
+    };
+
+    for (const auto sample : samples)
+    {
+        raw.set(0, sample);
+        raw.update(bank, 5);
+
+        EXPECT_EQ(bank.getState(0), sample);
+    }
+}
+
+// Every channel of a mixed bank against a bank of its kind only
+TEST(InputFilterBankTest, KindsMixWithinAWord)
+{
+    const size_t channelCount = 40;
+    const size_t kindCount = 4;
+
+    std::mt19937 random(7);
+    std::uniform_int_distribution<int> elapsedTimes_msec(1, 20);
+
+    auto makeChannelSettings = [](size_t channelIndex, InputFilterKind kind)
+    {
+        return makeSettings(kind, static_cast<int>(channelIndex * 3 % 40));
+    };
+
+    InputFilterBank mixedBank;
+    mixedBank.setChannelCount(channelCount);
+
+    InputFilterBank banks[kindCount];
+
+    for (size_t kind = 0; kind < kindCount; ++kind)
+    {
+        banks[kind].setChannelCount(channelCount);
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            banks[kind].setChannelSettings(i, makeChannelSettings(i, static_cast<InputFilterKind>(kind)));
+        }
+    }
+
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        mixedBank.setChannelSettings(i, makeChannelSettings(i, static_cast<InputFilterKind>(i % kindCount)));
+    }
+
+    std::vector<RandomTrace> traces(channelCount, RandomTrace(random));
+    RawWords raw;
+
+    for (int t = 0; t < 5000; ++t)
+    {
+        const auto elapsed_msec = elapsedTimes_msec(random);
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            raw.set(i, traces[i].next());
+        }
+
+        raw.update(mixedBank, elapsed_msec);
+
+        for (auto& bank : banks)
+        {
+            raw.update(bank, elapsed_msec);
+        }
+
+        for (size_t i = 0; i < channelCount; ++i)
+        {
+            ASSERT_EQ(mixedBank.getState(i), banks[i % kindCount].getState(i)) << "tick " << t << ", channel " << i;
+        }
+    }
+}
@@ -0,0 +1,200 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "action_manager.h"
+#include "struct_walk_action_manager.h"
+
+namespace
+{
+
+// A few channels past the counts and a group past the group count, which both paths skip
+const size_t inputChannelCount = 40;
+const size_t outputChannelCount = 40;
+const size_t channelIndexCount = 44;
+const size_t groupCount = 3;
+
+class RandomRules
+{
+public:
+    explicit RandomRules(uint32_t seed) :
+        _random(seed)
+    {
+    }
+
+    template <typename M>
+    void setUp(M& manager)
+    {
+        manager.setInputChannelCount(inputChannelCount);
+        manager.setOutputChannelCount(outputChannelCount);
+
+        for (size_t g = 0; g < groupCount; ++g)
+        {
+            manager.addOutputGroup(_groupMasks[g], 2);
+        }
+
+        for (const auto& rule : _rules)
+        {
+            manager.addRule(rule);
+        }
+    }
+
+    void generate(size_t ruleCount)
+    {
+        for (auto& mask : _groupMasks)
+        {
+            mask[0] = _random();
+            mask[1] = _random();
+        }
+
+        _rules.clear();
+
+        for (size_t i = 0; i < ruleCount; ++i)
+        {
+            _rules.push_back(makeRule());
+        }
+    }
+
+    // Events and input state changes of a tick, the same for both paths
+    struct Tick
+    {
+        std::vector<std::pair<size_t, EventType>> events;
+        std::vector<std::pair<size_t, DiscreteState>> inputStates;
+        int elapsed_msec;
+    };
+
+    Tick makeTick()
+    {
+        Tick result;
+
+        for (size_t i = 0; i < inputChannelCount; ++i)
+        {
+            if (percent() < 10)
+            {
+                result.events.push_back(std::make_pair(i, static_cast<EventType>(pick(1, 6))));
+            }
+
+            if (percent() < 5)
+            {
+                result.inputStates.push_back(std::make_pair(i, static_cast<DiscreteState>(pick(0, 2))));
+            }
+        }
+
+        result.elapsed_msec = pick(1, 20);
+        return result;
+    }
+
+    template <typename M>
+    static void run(M& manager, const Tick& tick)
+    {
+        for (const auto& item : tick.inputStates)
+        {
+            manager.setInputState(item.first, item.second);
+        }
+
+        for (const auto& item : tick.events)
+        {
+            manager.setInputEvent(item.first, item.second);
+        }
+
+        manager.advanceTime(tick.elapsed_msec);
+        manager.execute();
+    }
+
+private:
+    int pick(int min, int max) { return std::uniform_int_distribution<int>(min, max)(_random); }
+    int percent() { return pick(0, 99); }
+
+    Rule makeRule()
+    {
+        Rule result;
+
+        result.condition.inputChannelIndex = static_cast<size_t>(pick(0, static_cast<int>(channelIndexCount) - 1));
+        result.condition.eventType = static_cast<EventType>(pick(1, 6));
+
+        for (auto n = pick(0, 2); n > 0; --n)
+        {
+            RuleGuard guard;
+
+            guard.source = (percent() < 50) ? GuardSource::output : GuardSource::input;
+            guard.channelIndex = static_cast<size_t>(pick(0, static_cast<int>(channelIndexCount) - 1));
+            guard.state = (percent() < 50) ? DiscreteState::on : DiscreteState::off;
+
+            result.guards.push_back(guard);
+        }
+
+        for (auto n = pick(1, 4); n > 0; --n)
+        {
+            RuleAction action;
+
+            // Local and global off are rare, they would clear everything else
+            action.actionType = static_cast<ActionType>(pick(0, 13));
+            if (((action.actionType == ActionType::localOff) || (action.actionType == ActionType::globalOff)) && (percent() < 80))
+            {
+                action.actionType = ActionType::toggle;
+            }
+
+            const auto isGroup = (action.actionType == ActionType::groupOn) || (action.actionType == ActionType::groupOff) ||
+                (action.actionType == ActionType::groupToggle);
+
+            action.outputChannelIndex = static_cast<size_t>(isGroup ? pick(0, static_cast<int>(groupCount)) : pick(0, static_cast<int>(channelIndexCount) - 1));
+            action.duration_msec = static_cast<uint32_t>(pick(0, 300));
+
+            result.actions.push_back(action);
+        }
+
+        return result;
+    }
+
+    std::mt19937 _random;
+
+    uint32_t _groupMasks[groupCount][2];
+    std::vector<Rule> _rules;
+};
+
+} // namespace
+
+// The compiled rules against the structs they were compiled from: guards, several actions,
+// timed actions, groups, and channels out of range
+TEST(RuleCodeTest, MatchesTheStructWalk)
+{
+    for (uint32_t seed = 1; seed <= 20; ++seed)
+    {
+        RandomRules rules(seed);
+        rules.generate(100);
+
+        ActionManager manager;
+        StructWalkActionManager structWalk;
+
+        rules.setUp(manager);
+        rules.setUp(structWalk);
+
+        for (int t = 0; t < 2000; ++t)
+        {
+            const auto tick = rules.makeTick();
+
+            RandomRules::run(manager, tick);
+            RandomRules::run(structWalk, tick);
+
+            for (size_t i = 0; i < outputChannelCount; ++i)
+            {
+                DiscreteState state;
+                manager.getOutputState(i, state);
+
+                ASSERT_EQ(state, structWalk.getOutputState(i)) << "seed " << seed << ", tick " << t << ", output " << i;
+            }
+
+            for (size_t w = 0; w < BitUtils::wordCount(outputChannelCount); ++w)
+            {
+                ASSERT_EQ(manager.getChangedOutputWord(w), structWalk.getChangedOutputWord(w)) << "seed " << seed << ", tick " << t;
+            }
+
+            ASSERT_EQ(manager.getPendingTimerCount(), structWalk.getPendingTimerCount()) << "seed " << seed << ", tick " << t;
+        }
+    }
+}
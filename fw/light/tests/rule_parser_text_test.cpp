@@ -0,0 +1,256 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "rule_parser_text.h"
+#include "standard_resolvers.h"
+
+#include "test_rules.h"
+
+namespace
+{
+
+class RuleTextParserTest : public testing::Test
+{
+protected:
+    RuleTextParserTest() :
+        _inputs({ { "hall_switch", 0 }, { "room_switch", 1 } }),
+        _outputs({ { "hall_light", 0 }, { "room_light", 1 }, { "fan", 2 } }),
+        _groups({ { "downstairs", 0 } })
+    {
+        _parser.setInputChannelResolver(&_inputs);
+        _parser.setOutputChannelResolver(&_outputs);
+        _parser.setOutputGroupResolver(&_groups);
+        _parser.setEventResolver(&_resolvers);
+        _parser.setActionResolver(&_resolvers);
+    }
+
+    bool parse(const std::string& text) { return _parser.parse(text, _rule); }
+    bool hasError(RuleParserError error) const { return _parser.errors().count(error) != 0; }
+
+    uint32_t parseDuration_msec(const std::string& duration)
+    {
+        if (!parse("hall_switch click hall_light on_for:" + duration) || (_rule.actions.size() != 1))
+        {
+            return 0;
+        }
+
+        return _rule.actions[0].duration_msec;
+    }
+
+    static RuleAction makeAction(size_t outputChannelIndex, ActionType actionType, uint32_t duration_msec = 0)
+    {
+        RuleAction result;
+
+        result.outputChannelIndex = outputChannelIndex;
+        result.actionType = actionType;
+        result.duration_msec = duration_msec;
+
+        return result;
+    }
+
+    static RuleGuard makeGuard(GuardSource source, size_t channelIndex, DiscreteState state)
+    {
+        RuleGuard result;
+
+        result.source = source;
+        result.channelIndex = channelIndex;
+        result.state = state;
+
+        return result;
+    }
+
+    MapChannelResolver _inputs;
+    MapChannelResolver _outputs;
+    MapChannelResolver _groups;
+    StandardResolvers _resolvers;
+
+    RuleTextParser _parser;
+    Rule _rule;
+};
+
+} // namespace
+
+TEST_F(RuleTextParserTest, SingleAction)
+{
+    ASSERT_TRUE(parse("room_switch double_click room_light toggle"));
+
+    EXPECT_EQ(_rule.condition.inputChannelIndex, 1u);
+    EXPECT_EQ(_rule.condition.eventType, EventType::doubleClick);
+
+    ASSERT_EQ(_rule.actions.size(), 1u);
+    EXPECT_EQ(_rule.actions[0], makeAction(1, ActionType::toggle));
+    EXPECT_TRUE(_rule.guards.empty());
+}
+
+TEST_F(RuleTextParserTest, ActionsRunInOrder)
+{
+    ASSERT_TRUE(parse("hall_switch long_press hall_light turn_off fan on_for:30 downstairs group_off any global_off"));
+
+    ASSERT_EQ(_rule.actions.size(), 4u);
+    EXPECT_EQ(_rule.actions[0], makeAction(0, ActionType::turnOff));
+    EXPECT_EQ(_rule.actions[1], makeAction(2, ActionType::onFor, 30000));
+    EXPECT_EQ(_rule.actions[2], makeAction(0, ActionType::groupOff));
+
+    // The output of global_off is not resolved
+    EXPECT_EQ(_rule.actions[3].actionType, ActionType::globalOff);
+}
+
+TEST_F(RuleTextParserTest, CommentEndsTheRule)
+{
+    ASSERT_TRUE(parse("hall_switch click hall_light toggle // room_light toggle"));
+    EXPECT_EQ(_rule.actions.size(), 1u);
+
+    ASSERT_TRUE(parse("hall_switch click hall_light toggle //room_light toggle"));
+    EXPECT_EQ(_rule.actions.size(), 1u);
+
+    ASSERT_TRUE(parse("hall_switch click hall_light toggle if output fan is off // and output fan is on"));
+    EXPECT_EQ(_rule.guards.size(), 1u);
+}
+
+TEST_F(RuleTextParserTest, CommentBeforeTheFirstActionIsIncomplete)
+{
+    EXPECT_FALSE(parse("hall_switch click // hall_light toggle"));
+    EXPECT_TRUE(hasError(RuleParserError::parsingError));
+}
+
+TEST_F(RuleTextParserTest, GuardsChainWithAnd)
+{
+    ASSERT_TRUE(parse("hall_switch click hall_light toggle room_light turn_on if output fan is off and input room_switch is on"));
+
+    ASSERT_EQ(_rule.actions.size(), 2u);
+    ASSERT_EQ(_rule.guards.size(), 2u);
+
+    EXPECT_EQ(_rule.guards[0], makeGuard(GuardSource::output, 2, DiscreteState::off));
+    EXPECT_EQ(_rule.guards[1], makeGuard(GuardSource::input, 1, DiscreteState::on));
+}
+
+TEST_F(RuleTextParserTest, GuardChannelsResolveBySource)
+{
+    // hall_switch is an input only, fan an output only
+    EXPECT_FALSE(parse("hall_switch click hall_light toggle if output hall_switch is on"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidGuard));
+
+    EXPECT_FALSE(parse("hall_switch click hall_light toggle if input fan is on"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidGuard));
+}
+
+TEST_F(RuleTextParserTest, InvalidGuardsAreRejected)
+{
+    const char* const texts[] = {
+        "hall_switch click hall_light toggle if sensor fan is on",
+        "hall_switch click hall_light toggle if output fan equals on",
+        "hall_switch click hall_light toggle if output fan is dimmed",
+        "hall_switch click hall_light toggle if output fan on",
+    };
+
+    for (const auto text : texts)
+    {
+        EXPECT_FALSE(parse(text)) << text;
+        EXPECT_TRUE(hasError(RuleParserError::invalidGuard)) << text;
+    }
+}
+
+TEST_F(RuleTextParserTest, IncompleteGuardsAreRejected)
+{
+    const char* const texts[] = {
+        "hall_switch click hall_light toggle if",
+        "hall_switch click hall_light toggle if output fan",
+        "hall_switch click hall_light toggle if output fan is",
+        "hall_switch click hall_light toggle if output fan is on and",
+        "hall_switch click hall_light toggle if output fan is on or input room_switch is on",
+        "hall_switch click hall_light toggle if output fan is on room_light toggle",
+    };
+
+    for (const auto text : texts)
+    {
+        EXPECT_FALSE(parse(text)) << text;
+        EXPECT_TRUE(hasError(RuleParserError::parsingError)) << text;
+    }
+}
+
+TEST_F(RuleTextParserTest, DurationUnits)
+{
+    EXPECT_EQ(parseDuration_msec("5"), 5000u);
+    EXPECT_EQ(parseDuration_msec("5s"), 5000u);
+    EXPECT_EQ(parseDuration_msec("250ms"), 250u);
+    EXPECT_EQ(parseDuration_msec("2m"), 120000u);
+
+    // The longest delay of the timers
+    EXPECT_EQ(parseDuration_msec("35791m"), 35791u * 60 * 1000);
+}
+
+TEST_F(RuleTextParserTest, InvalidDurationsAreRejected)
+{
+    const char* const durations[] = { "", "0", "0ms", "5h", "ms", "5 s", "-5", "1.5", "35792m", "4294967296" };
+
+    for (const auto duration : durations)
+    {
+        EXPECT_FALSE(parse(std::string("hall_switch click hall_light on_for:") + duration)) << duration;
+    }
+
+    EXPECT_FALSE(parse("hall_switch click hall_light on_for:5h"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidDuration));
+}
+
+TEST_F(RuleTextParserTest, DurationOnlyForTimedActions)
+{
+    EXPECT_FALSE(parse("hall_switch click hall_light toggle:5"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidDuration));
+
+    EXPECT_FALSE(parse("hall_switch click hall_light pulse"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidDuration));
+
+    EXPECT_TRUE(parse("hall_switch click hall_light pulse:500ms"));
+    EXPECT_TRUE(parse("hall_switch click hall_light off_after:1m"));
+}
+
+TEST_F(RuleTextParserTest, UnknownNamesAreRejected)
+{
+    EXPECT_FALSE(parse("porch_switch click hall_light toggle"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidInputChannel));
+
+    EXPECT_FALSE(parse("hall_switch triple_click hall_light toggle"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidEvent));
+
+    EXPECT_FALSE(parse("hall_switch click porch_light toggle"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidOutputChannel));
+
+    EXPECT_FALSE(parse("hall_switch click hall_light dim"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidAction));
+
+    // Groups and outputs are looked up apart
+    EXPECT_FALSE(parse("hall_switch click downstairs toggle"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidOutputChannel));
+
+    EXPECT_FALSE(parse("hall_switch click hall_light group_on"));
+    EXPECT_TRUE(hasError(RuleParserError::invalidOutputChannel));
+}
+
+TEST_F(RuleTextParserTest, IncompleteRulesAreRejected)
+{
+    const char* const texts[] = {
+        "",
+        "hall_switch",
+        "hall_switch click",
+        "hall_switch click hall_light",
+        "hall_switch click hall_light toggle room_light",
+    };
+
+    for (const auto text : texts)
+    {
+        EXPECT_FALSE(parse(text)) << text;
+        EXPECT_TRUE(hasError(RuleParserError::parsingError)) << text;
+    }
+}
+
+TEST_F(RuleTextParserTest, ErrorsOfThePreviousRuleAreCleared)
+{
+    EXPECT_FALSE(parse("hall_switch click porch_light toggle"));
+    EXPECT_TRUE(parse("hall_switch click hall_light toggle"));
+
+    EXPECT_TRUE(_parser.errors().empty());
+}
@@ -0,0 +1,182 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <FS.h>
+
+#include "rules_cache.h"
+#include "rules_reader.h"
+#include "standard_resolvers.h"
+
+#include "test_rules.h"
+
+namespace
+{
+
+const char* const rulesFilename = "/rules.txt";
+const char* const cacheFilename = "/rules.bin";
+
+const char* const rulesText =
+    "// Hall\n"
+    "hall_switch click hall_light toggle\n"
+    "hall_switch long_press hall_light turn_off fan on_for:30 downstairs group_off // all off\n"
+    "\n"
+    "room_switch double_click room_light pulse:500ms if output fan is off and input hall_switch is on\n"
+    "room_switch hold_repeat any local_off\n"
+    "room_switch click fan off_after:2m room_light toggle if input room_switch is on\n";
+
+// Stands for a source that must not be read: the rules have to come from the cache
+class FailingRulesReader : public IRulesReader
+{
+public:
+    ReadResult readRule(Rule& result_out) override
+    {
+        (void)result_out;
+        return ReadResult::error;
+    }
+
+    bool hasMoreRules() const override { return false; }
+    bool reset() override { return false; }
+};
+
+class RulesCacheTest : public testing::Test
+{
+protected:
+    RulesCacheTest() :
+        _inputs({ { "hall_switch", 0 }, { "room_switch", 1 } }),
+        _outputs({ { "hall_light", 0 }, { "room_light", 1 }, { "fan", 2 } }),
+        _groups({ { "downstairs", 0 } })
+    {
+        _fileSystem.setFile(rulesFilename, rulesText);
+
+        _textReader.setInputChannelResolver(&_inputs);
+        _textReader.setOutputChannelResolver(&_outputs);
+        _textReader.setOutputGroupResolver(&_groups);
+        _textReader.setEventResolver(&_resolvers);
+        _textReader.setActionResolver(&_resolvers);
+
+        _textReader.setFilename(rulesFilename);
+        _textReader.setFileSystem(&_fileSystem);
+    }
+
+    void setUpCache(RulesCacheReader& cache, IRulesReader& sourceReader)
+    {
+        cache.setSourceReader(&sourceReader);
+        cache.setFilename(cacheFilename);
+        cache.setFileSystem(&_fileSystem);
+        cache.addSourceFilename(rulesFilename);
+    }
+
+    static std::vector<Rule> readAll(IRulesReader& reader)
+    {
+        std::vector<Rule> result;
+
+        while (reader.hasMoreRules())
+        {
+            Rule rule;
+            if (reader.readRule(rule) == IRulesReader::ReadResult::success)
+            {
+                result.push_back(rule);
+            }
+        }
+
+        return result;
+    }
+
+    MapChannelResolver _inputs;
+    MapChannelResolver _outputs;
+    MapChannelResolver _groups;
+    StandardResolvers _resolvers;
+
+    FS _fileSystem;
+    RulesTextReader _textReader;
+};
+
+} // namespace
+
+TEST_F(RulesCacheTest, LoadedRulesEqualTheParsedOnes)
+{
+    ASSERT_TRUE(_textReader.reset());
+    const auto parsedRules = readAll(_textReader);
+
+    ASSERT_EQ(parsedRules.size(), 5u);
+
+    // Compiled from the text and saved
+    RulesCacheReader compilingCache;
+    setUpCache(compilingCache, _textReader);
+
+    ASSERT_TRUE(compilingCache.reset());
+    EXPECT_EQ(readAll(compilingCache), parsedRules);
+    ASSERT_TRUE(_fileSystem.exists(cacheFilename));
+
+    // Loaded without the source
+    FailingRulesReader failingReader;
+    RulesCacheReader loadingCache;
+    setUpCache(loadingCache, failingReader);
+
+    ASSERT_TRUE(loadingCache.reset());
+    EXPECT_EQ(readAll(loadingCache), parsedRules);
+
+    // Read again after a reset
+    ASSERT_TRUE(loadingCache.reset());
+    EXPECT_EQ(readAll(loadingCache), parsedRules);
+}
+
+TEST_F(RulesCacheTest, ChangedSourceIsCompiledAgain)
+{
+    RulesCacheReader cache;
+    setUpCache(cache, _textReader);
+
+    ASSERT_TRUE(cache.reset());
+    ASSERT_EQ(readAll(cache).size(), 5u);
+
+    _fileSystem.setFile(rulesFilename, "hall_switch click hall_light toggle\n");
+
+    ASSERT_TRUE(cache.reset());
+    EXPECT_EQ(readAll(cache).size(), 1u);
+
+    // And the cache holds the new rules
+    FailingRulesReader failingReader;
+    RulesCacheReader loadingCache;
+    setUpCache(loadingCache, failingReader);
+
+    ASSERT_TRUE(loadingCache.reset());
+    EXPECT_EQ(readAll(loadingCache).size(), 1u);
+}
+
+TEST_F(RulesCacheTest, DamagedCacheIsNotLoaded)
+{
+    RulesCacheReader cache;
+    setUpCache(cache, _textReader);
+
+    ASSERT_TRUE(cache.reset());
+    const auto fullSize = _fileSystem.getFile(cacheFilename).size();
+
+    FailingRulesReader failingReader;
+    RulesCacheReader loadingCache;
+    setUpCache(loadingCache, failingReader);
+
+    // A record cut short
+    _fileSystem.getFile(cacheFilename).resize(fullSize - 1);
+    EXPECT_FALSE(loadingCache.reset());
+
+    // The last rule missing: a rule, two action and one guard records
+    ASSERT_TRUE(cache.reset());
+    ASSERT_EQ(_fileSystem.getFile(cacheFilename).size(), fullSize);
+
+    _fileSystem.getFile(cacheFilename).resize(fullSize - 28);
+    EXPECT_FALSE(loadingCache.reset());
+
+    // Another signature
+    ASSERT_TRUE(cache.reset());
+    _fileSystem.getFile(cacheFilename)[0] ^= 0xFF;
+    EXPECT_FALSE(loadingCache.reset());
+
+    // Compiled again, loads
+    ASSERT_TRUE(cache.reset());
+    EXPECT_TRUE(loadingCache.reset());
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <initializer_list>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+
+#include "types.h"
+
+// Rule comparison and channel names shared by the rule tests
+
+inline bool operator==(const RuleAction& a, const RuleAction& b)
+{
+    return (a.outputChannelIndex == b.outputChannelIndex) && (a.actionType == b.actionType) && (a.duration_msec == b.duration_msec);
+}
+
+inline bool operator==(const RuleGuard& a, const RuleGuard& b)
+{
+    return (a.source == b.source) && (a.channelIndex == b.channelIndex) && (a.state == b.state);
+}
+
+inline bool operator==(const Rule& a, const Rule& b)
+{
+    return (a.condition.inputChannelIndex == b.condition.inputChannelIndex) && (a.condition.eventType == b.condition.eventType) &&
+        (a.actions == b.actions) && (a.guards == b.guards);
+}
+
+inline void PrintTo(const Rule& rule, std::ostream* stream_p)
+{
+    *stream_p << "{input " << rule.condition.inputChannelIndex << ", event " << static_cast<int>(rule.condition.eventType) << ", actions";
+
+    for (const auto& action : rule.actions)
+    {
+        *stream_p << " (" << action.outputChannelIndex << " " << static_cast<int>(action.actionType) << " " << action.duration_msec << ")";
+    }
+
+    *stream_p << ", guards";
+
+    for (const auto& guard : rule.guards)
+    {
+        *stream_p << " (" << static_cast<int>(guard.source) << " " << guard.channelIndex << " " << static_cast<int>(guard.state) << ")";
+    }
+
+    *stream_p << "}";
+}
+
+class MapChannelResolver : public IChannelNameResolver
+{
+public:
+    MapChannelResolver(std::initializer_list<std::pair<const std::string, size_t>> channels) : _channels(channels) {}
+
+    bool resolveChannelName(const std::string& channelName, size_t& channelIndex_out) const override
+    {
+        const auto it = _channels.find(channelName);
+        if (it == _channels.end())
+        {
+            return false;
+        }
+
+        channelIndex_out = it->second;
+        return true;
+    }
+
+private:
+    std::map<std::string, size_t> _channels;
+};
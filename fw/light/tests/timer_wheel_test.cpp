@@ -0,0 +1,261 @@
+#include <cstddef>
+#include <cstdint>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "timer_wheel.h"
+
+namespace
+{
+
+const uint32_t revolution_msec = TimerWheel::slotDuration_msec * TimerWheel::slotCount;
+
+// Advances the wheel and collects the timers it reports as expired
+class WheelClock
+{
+public:
+    explicit WheelClock(size_t capacity)
+    {
+        _wheel.setCapacity(capacity);
+    }
+
+    TimerWheel& wheel() { return _wheel; }
+    uint32_t now_msec() const { return _now_msec; }
+
+    std::vector<size_t> advance(uint32_t elapsed_msec)
+    {
+        std::vector<size_t> result;
+
+        _now_msec += elapsed_msec;
+        _wheel.advance(elapsed_msec, [&result](size_t timerIndex) { result.push_back(timerIndex); });
+
+        return result;
+    }
+
+private:
+    TimerWheel _wheel;
+    uint32_t _now_msec = 0;
+};
+
+} // namespace
+
+TEST(TimerWheelTest, ExpiresOnTheDeadlineAcrossSlots)
+{
+    WheelClock clock(3);
+
+    clock.wheel().start(0, 7);
+    clock.wheel().start(1, 8);
+    clock.wheel().start(2, 9);
+
+    EXPECT_TRUE(clock.advance(6).empty());
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 0 }));
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 1 }));
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 2 }));
+    EXPECT_EQ(clock.wheel().getPendingCount(), 0u);
+}
+
+TEST(TimerWheelTest, LongTimersWaitForTheirRevolution)
+{
+    WheelClock clock(2);
+
+    // Same slot as a timer due now, revolutions later
+    clock.wheel().start(0, revolution_msec);
+    clock.wheel().start(1, 3 * revolution_msec + 5);
+
+    for (uint32_t time_msec = 10; time_msec < revolution_msec; time_msec += 10)
+    {
+        ASSERT_TRUE(clock.advance(10).empty()) << time_msec;
+    }
+
+    EXPECT_TRUE(clock.advance(revolution_msec % 10 - 1).empty());
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 0 }));
+
+    while (clock.now_msec() < 3 * revolution_msec + 4)
+    {
+        ASSERT_TRUE(clock.advance(1).empty()) << clock.now_msec();
+    }
+
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 1 }));
+}
+
+TEST(TimerWheelTest, ElapsedTimeLongerThanARevolution)
+{
+    WheelClock clock(4);
+
+    clock.wheel().start(0, 10);
+    clock.wheel().start(1, revolution_msec + 100);
+    clock.wheel().start(2, 2 * revolution_msec);
+    clock.wheel().start(3, 2 * revolution_msec + 1);
+
+    auto expired = clock.advance(2 * revolution_msec);
+    std::sort(expired.begin(), expired.end());
+
+    EXPECT_EQ(expired, std::vector<size_t>({ 0, 1, 2 }));
+    EXPECT_TRUE(clock.wheel().isPending(3));
+
+    EXPECT_EQ(clock.advance(1), std::vector<size_t>({ 3 }));
+}
+
+TEST(TimerWheelTest, RestartFromOnExpired)
+{
+    TimerWheel wheel;
+    wheel.setCapacity(1);
+
+    wheel.start(0, 100);
+
+    std::vector<uint32_t> times_msec;
+    uint32_t now_msec = 0;
+
+    for (int t = 0; t < 100; ++t)
+    {
+        now_msec += 10;
+        wheel.advance(10,
+            [&](size_t timerIndex)
+            {
+                times_msec.push_back(now_msec);
+                wheel.start(timerIndex, 100);
+            });
+    }
+
+    EXPECT_EQ(times_msec, std::vector<uint32_t>({ 100, 200, 300, 400, 500, 600, 700, 800, 900, 1000 }));
+    EXPECT_TRUE(wheel.isPending(0));
+}
+
+TEST(TimerWheelTest, CancelFromOnExpired)
+{
+    TimerWheel wheel;
+    wheel.setCapacity(3);
+
+    // All three are due in the same advance, the first one reported cancels the others
+    wheel.start(0, 10);
+    wheel.start(1, 10);
+    wheel.start(2, 15);
+
+    size_t expiredCount = 0;
+
+    wheel.advance(20,
+        [&](size_t timerIndex)
+        {
+            ++expiredCount;
+
+            for (size_t i = 0; i < 3; ++i)
+            {
+                if (i != timerIndex)
+                {
+                    wheel.cancel(i);
+                }
+            }
+        });
+
+    EXPECT_EQ(expiredCount, 1u);
+    EXPECT_EQ(wheel.getPendingCount(), 0u);
+
+    wheel.advance(revolution_msec, [&](size_t) { ++expiredCount; });
+    EXPECT_EQ(expiredCount, 1u);
+}
+
+// Against a map of the deadlines: every timer is reported in the first advance that
+// reaches its deadline, and only then
+TEST(TimerWheelTest, MatchesNaiveTimers)
+{
+    const size_t capacity = 64;
+
+    std::mt19937 random(1234);
+    std::uniform_int_distribution<size_t> timerIndexes(0, capacity - 1);
+    std::uniform_int_distribution<int> percents(0, 99);
+
+    TimerWheel wheel;
+    wheel.setCapacity(capacity);
+
+    std::map<size_t, uint64_t> deadlines_msec;
+    uint64_t now_msec = 0;
+
+    auto randomDelay_msec = [&]() -> uint32_t
+    {
+        const auto percent = percents(random);
+
+        if (percent < 60)
+        {
+            return std::uniform_int_distribution<uint32_t>(0, 200)(random);
+        }
+
+        if (percent < 90)
+        {
+            return std::uniform_int_distribution<uint32_t>(0, revolution_msec + 100)(random);
+        }
+
+        return std::uniform_int_distribution<uint32_t>(0, 4 * revolution_msec)(random);
+    };
+
+    size_t expiredCount = 0;
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        for (int n = percents(random) % 4; n > 0; --n)
+        {
+            const auto index = timerIndexes(random);
+
+            if (percents(random) < 80)
+            {
+                const auto delay_msec = randomDelay_msec();
+
+                wheel.start(index, delay_msec);
+                deadlines_msec[index] = now_msec + delay_msec;
+            }
+            else
+            {
+                wheel.cancel(index);
+                deadlines_msec.erase(index);
+            }
+        }
+
+        const uint32_t elapsed_msec = (percents(random) < 98)
+            ? std::uniform_int_distribution<uint32_t>(0, 30)(random)
+            : std::uniform_int_distribution<uint32_t>(revolution_msec, 3 * revolution_msec)(random);
+
+        now_msec += elapsed_msec;
+
+        wheel.advance(elapsed_msec,
+            [&](size_t timerIndex)
+            {
+                const auto it = deadlines_msec.find(timerIndex);
+
+                ASSERT_NE(it, deadlines_msec.end()) << "timer " << timerIndex << " is not pending";
+                ASSERT_LE(it->second, now_msec) << "timer " << timerIndex << " expired early";
+
+                deadlines_msec.erase(it);
+                ++expiredCount;
+
+                // Timers restarted and cancelled while the expired ones are reported
+                if (percents(random) < 30)
+                {
+                    const auto delay_msec = randomDelay_msec() + 1;
+
+                    wheel.start(timerIndex, delay_msec);
+                    deadlines_msec[timerIndex] = now_msec + delay_msec;
+                }
+
+                if (percents(random) < 20)
+                {
+                    const auto other = timerIndexes(random);
+
+                    wheel.cancel(other);
+                    deadlines_msec.erase(other);
+                }
+            });
+
+        for (const auto& deadline : deadlines_msec)
+        {
+            ASSERT_GT(deadline.second, now_msec) << "timer " << deadline.first << " was missed at step " << step;
+        }
+
+        ASSERT_EQ(wheel.getPendingCount(), deadlines_msec.size());
+    }
+
+    EXPECT_GT(expiredCount, 1000u);
+}
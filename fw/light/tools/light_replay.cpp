@@ -0,0 +1,468 @@
+// Replays raw input samples through LightController on the host and reports the
+// events it detects. The samples come from a recorded trace or from switches pressed
+// at random times over a synthetic 50/60 Hz optocoupler signal with sampling jitter
+// and contact bounce. Synthetic runs know the true switch changes, so they report
+// missed and spurious events and the event latency.
+//
+//     light_replay --filter ac --period 50,75,100 --traces 1000 --seconds 60
+//     light_replay --trace complaint.txt --events
+//     light_replay --capture input_capture.bin --filter ac --period 50,75
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "light_controller.h"
+
+#include "fake_devices.h"
+
+#include "replay_sources.h"
+#include "replay_stats.h"
+
+namespace
+{
+
+struct Options
+{
+    std::string traceFilename;
+    std::string captureFilename;
+    bool isEventListPrinted = false;
+
+    SyntheticParams synthetic;
+    size_t traceCount = 1;
+    uint32_t seed = 1;
+
+    InputFilterSettings filter;
+    std::vector<int> periods_msec { 75 };
+};
+
+class EventRecorder : public IEventSender
+{
+public:
+    EventRecorder(ReplayStats& stats, bool isPrinted) :
+        _stats(stats),
+        _isPrinted(isPrinted)
+    {
+    }
+
+    void setTime_usec(uint64_t value) { _time_usec = value; }
+
+    void beginSendEvents() override {}
+    void endSendEvents() override {}
+
+    void sendEvent(size_t inputChannelIndex, EventType eventType) override
+    {
+        // Gestures follow from rise and fall, the switch changes are matched with those only
+        if ((eventType == EventType::rise) || (eventType == EventType::fall))
+        {
+            _stats.addEvent(inputChannelIndex, eventType, _time_usec);
+        }
+
+        if (_isPrinted)
+        {
+            std::printf("%10.1f %4zu %s\n", _time_usec / 1000.0, inputChannelIndex, getEventName(eventType));
+        }
+    }
+
+    static const char* getEventName(EventType eventType)
+    {
+        switch (eventType)
+        {
+            case EventType::rise:
+                return "rise";
+
+            case EventType::fall:
+                return "fall";
+
+            case EventType::click:
+                return "click";
+
+            case EventType::doubleClick:
+                return "double_click";
+
+            case EventType::longPress:
+                return "long_press";
+
+            case EventType::holdRepeat:
+                return "hold_repeat";
+
+            default:
+                return "none";
+        }
+    }
+
+private:
+    ReplayStats& _stats;
+    bool _isPrinted;
+    uint64_t _time_usec = 0;
+};
+
+// Runs one source to its end, returns the number of ticks
+size_t replay(IReplaySource& source, const Options& options, int period_msec, ReplayStats& stats_out)
+{
+    const auto channelCount = source.getChannelCount();
+
+    FakeInputDevice inputDevice;
+    FakeOutputDevice outputDevice;
+    FakeRulesReader rulesReader;
+    EventRecorder recorder(stats_out, options.isEventListPrinted);
+
+    inputDevice.setChannelCount(channelCount);
+    outputDevice.setChannelCount(channelCount);
+    stats_out.setChannelCount(channelCount);
+
+    std::unique_ptr<LightController> controller_p(new LightController());
+
+    controller_p->setInputCount(channelCount);
+    controller_p->setOutputCount(channelCount);
+    controller_p->setInputDevice(&inputDevice);
+    controller_p->setOutputDevice(&outputDevice);
+    controller_p->setRulesReader(&rulesReader);
+    controller_p->setEventSender(&recorder);
+
+    controller_p->setInputFilterKind(options.filter.kind);
+    controller_p->setNominalFrequency_hz(options.synthetic.mainsFrequency_hz);
+    controller_p->setInputFilterPeriod_msec(period_msec);
+
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        controller_p->setInputFilterSettings(i, options.filter);
+    }
+
+    controller_p->initialize();
+
+    ReplayFrame frame;
+    std::vector<ReplayTransition> transitions;
+
+    uint64_t time_usec = 0;
+    size_t tickCount = 0;
+
+    while (source.next(frame, transitions))
+    {
+        for (const auto& transition : transitions)
+        {
+            stats_out.addTransition(transition);
+        }
+
+        transitions.clear();
+
+        inputDevice.setFrame(frame.onWords, frame.validWords);
+        inputDevice.setEdges(frame.edges);
+
+        time_usec += static_cast<uint64_t>(frame.elapsed_msec) * 1000;
+        recorder.setTime_usec(time_usec);
+
+        controller_p->execute(frame.elapsed_msec);
+        ++tickCount;
+    }
+
+    stats_out.finish();
+
+    return tickCount;
+}
+
+bool parseInt(const char* text, int& value_out)
+{
+    char* end_p;
+    const auto value = std::strtol(text, &end_p, 10);
+
+    if ((*text == '\0') || (*end_p != '\0') || (value < 0) || (value > INT32_MAX))
+    {
+        return false;
+    }
+
+    value_out = static_cast<int>(value);
+    return true;
+}
+
+bool parseFilter(const std::string& text, InputFilterSettings& result_out)
+{
+    if (text == "ac")
+    {
+        result_out.kind = InputFilterKind::acWindow;
+        return true;
+    }
+
+    if (text == "ac-edge")
+    {
+        result_out.kind = InputFilterKind::acEdge;
+        return true;
+    }
+
+    if (text == "raw")
+    {
+        result_out.kind = InputFilterKind::raw;
+        return true;
+    }
+
+    if (text.compare(0, 2, "dc") != 0)
+    {
+        return false;
+    }
+
+    result_out.kind = InputFilterKind::dcDebounce;
+
+    if (text.size() == 2)
+    {
+        return true;
+    }
+
+    return (text[2] == ':') && parseInt(text.c_str() + 3, result_out.debounce_msec);
+}
+
+bool parsePeriods(const std::string& text, std::vector<int>& result_out)
+{
+    result_out.clear();
+
+    size_t pos = 0;
+    while (pos <= text.size())
+    {
+        auto end = text.find(',', pos);
+        if (end == std::string::npos)
+        {
+            end = text.size();
+        }
+
+        int value;
+        if (!parseInt(text.substr(pos, end - pos).c_str(), value) || (value == 0))
+        {
+            return false;
+        }
+
+        result_out.push_back(value);
+        pos = end + 1;
+    }
+
+    return !result_out.empty();
+}
+
+void printUsage()
+{
+    std::printf(
+        "Usage: light_replay [options]\n"
+        "  --trace FILE        replay a text trace instead of synthetic ones\n"
+        "  --capture FILE      replay a capture downloaded from /api/v1/capture/get\n"
+        "  --events            print every event: time (msec), channel, event\n"
+        "  --filter KIND       ac, ac-edge, dc, dc:MSEC or raw (ac)\n"
+        "  --period LIST       AC window periods to sweep, msec, comma separated (75)\n"
+        "  --mains HZ          mains frequency, also the nominal one of the filter (50)\n"
+        "Synthetic traces:\n"
+        "  --traces N          number of traces, seeds SEED..SEED+N-1 (1)\n"
+        "  --seed N            (1)\n"
+        "  --seconds N         length of a trace (60)\n"
+        "  --channels N        (16)\n"
+        "  --tick MSEC         (5)\n"
+        "  --duty PERCENT      optocoupler pulse duty cycle (50)\n"
+        "  --jitter USEC       sampling time error (200)\n"
+        "  --bounce MSEC       contact bounce after every switch change (5)\n"
+        "  --read-latency USEC INT to port read time of the edge timestamps, ac-edge (300)\n"
+        "  --hold MIN:MAX      msec between switch changes (150:2000)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options_out)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string name = argv[i];
+
+        if (name == "--events")
+        {
+            options_out.isEventListPrinted = true;
+            continue;
+        }
+
+        if (i + 1 >= argc)
+        {
+            return false;
+        }
+
+        const std::string value = argv[++i];
+        int number = 0;
+
+        const auto isNumber = parseInt(value.c_str(), number);
+        auto& synthetic = options_out.synthetic;
+
+        if (name == "--trace")
+        {
+            options_out.traceFilename = value;
+        }
+        else if (name == "--capture")
+        {
+            options_out.captureFilename = value;
+        }
+        else if (name == "--filter")
+        {
+            if (!parseFilter(value, options_out.filter))
+            {
+                return false;
+            }
+        }
+        else if (name == "--period")
+        {
+            if (!parsePeriods(value, options_out.periods_msec))
+            {
+                return false;
+            }
+        }
+        else if (name == "--hold")
+        {
+            const auto separatorPos = value.find(':');
+            int min_msec, max_msec;
+
+            if ((separatorPos == std::string::npos) || !parseInt(value.substr(0, separatorPos).c_str(), min_msec) ||
+                !parseInt(value.substr(separatorPos + 1).c_str(), max_msec) || (min_msec == 0) || (max_msec < min_msec))
+            {
+                return false;
+            }
+
+            synthetic.minHold_msec = static_cast<uint32_t>(min_msec);
+            synthetic.maxHold_msec = static_cast<uint32_t>(max_msec);
+        }
+        else if (!isNumber)
+        {
+            return false;
+        }
+        else if ((name == "--mains") && (number > 0))
+        {
+            synthetic.mainsFrequency_hz = number;
+        }
+        else if ((name == "--traces") && (number > 0))
+        {
+            options_out.traceCount = static_cast<size_t>(number);
+        }
+        else if (name == "--seed")
+        {
+            options_out.seed = static_cast<uint32_t>(number);
+        }
+        else if ((name == "--seconds") && (number > 0))
+        {
+            synthetic.duration_msec = static_cast<uint32_t>(number) * 1000;
+        }
+        else if ((name == "--channels") && (number > 0) && (number <= 128))
+        {
+            synthetic.channelCount = static_cast<size_t>(number);
+        }
+        else if ((name == "--tick") && (number > 0))
+        {
+            synthetic.tick_msec = number;
+        }
+        else if ((name == "--duty") && (number <= 100))
+        {
+            synthetic.dutyCycle_percent = number;
+        }
+        else if (name == "--jitter")
+        {
+            synthetic.jitter_usec = static_cast<uint32_t>(number);
+        }
+        else if (name == "--bounce")
+        {
+            synthetic.bounce_msec = static_cast<uint32_t>(number);
+        }
+        else if (name == "--read-latency")
+        {
+            synthetic.readLatency_usec = static_cast<uint32_t>(number);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    const auto kind = options_out.filter.kind;
+    options_out.synthetic.isAc = (kind == InputFilterKind::acWindow) || (kind == InputFilterKind::acEdge);
+    options_out.synthetic.hasEdgeTimes = kind == InputFilterKind::acEdge;
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 2;
+    }
+
+    for (const auto period_msec : options.periods_msec)
+    {
+        ReplayStats total;
+        size_t tickCount = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        if (!options.captureFilename.empty())
+        {
+            CaptureFileSource source;
+            std::string error;
+
+            if (!source.open(options.captureFilename, error))
+            {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+
+            if (source.getLostRecordCount() > 0)
+            {
+                std::fprintf(stderr, "The capture lost its %zu oldest ticks\n", source.getLostRecordCount());
+            }
+
+            tickCount += replay(source, options, period_msec, total);
+        }
+        else if (!options.traceFilename.empty())
+        {
+            TraceFileSource source;
+            std::string error;
+
+            if (!source.open(options.traceFilename, error))
+            {
+                std::fprintf(stderr, "%s\n", error.c_str());
+                return 1;
+            }
+
+            tickCount += replay(source, options, period_msec, total);
+
+            if (source.hasError())
+            {
+                std::fprintf(stderr, "Invalid frame at line %zu\n", source.getLineNumber());
+                return 1;
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < options.traceCount; ++i)
+            {
+                SyntheticSource source(options.synthetic, options.seed + static_cast<uint32_t>(i));
+                ReplayStats stats;
+
+                tickCount += replay(source, options, period_msec, stats);
+                total.merge(stats);
+            }
+        }
+
+        const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // A recorded trace has no switch changes to match the events with
+        if (!options.traceFilename.empty() || !options.captureFilename.empty())
+        {
+            std::printf("period %d msec: events %zu\n", period_msec, total.getEventCount());
+        }
+        else
+        {
+            std::printf("period %d msec: %s\n", period_msec, total.toString().c_str());
+        }
+
+        std::printf("    %zu ticks in %.2f s, %.2f M ticks/s\n", tickCount, seconds, tickCount / seconds / 1e6);
+    }
+
+    return 0;
+}
@@ -0,0 +1,518 @@
+#include <iterator>
+
+#include "input_capture.h"
+
+#include "replay_sources.h"
+
+namespace
+{
+
+uint16_t readUint16(const uint8_t* src_p)
+{
+    return static_cast<uint16_t>(src_p[0] | (src_p[1] << 8));
+}
+
+uint32_t readUint32(const uint8_t* src_p)
+{
+    return readUint16(src_p) | (static_cast<uint32_t>(readUint16(src_p + 2)) << 16);
+}
+
+} // namespace
+
+bool TraceFileSource::open(const std::string& filename, std::string& error_out)
+{
+    _file.open(filename);
+    if (!_file)
+    {
+        error_out = "Failed to open " + filename;
+        return false;
+    }
+
+    // The first frame tells the channel count
+    if (!readLine(_pendingLine))
+    {
+        error_out = filename + " has no frames";
+        return false;
+    }
+
+    const auto separatorPos = _pendingLine.find_first_of(" \t");
+    const auto statesPos = _pendingLine.find_first_not_of(" \t", separatorPos);
+
+    if ((separatorPos == std::string::npos) || (statesPos == std::string::npos))
+    {
+        error_out = "Invalid frame at line " + std::to_string(_lineNumber);
+        return false;
+    }
+
+    _channelCount = _pendingLine.find_first_of(" \t\r", statesPos);
+    _channelCount = ((_channelCount == std::string::npos) ? _pendingLine.size() : _channelCount) - statesPos;
+    _hasPendingLine = true;
+
+    return true;
+}
+
+bool TraceFileSource::readLine(std::string& line_out)
+{
+    while (std::getline(_file, line_out))
+    {
+        ++_lineNumber;
+
+        const auto start = line_out.find_first_not_of(" \t\r");
+        if ((start == std::string::npos) || (line_out[start] == '#'))
+        {
+            continue;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool TraceFileSource::next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out)
+{
+    (void)transitions_out;
+
+    std::string line;
+
+    if (_hasPendingLine)
+    {
+        line.swap(_pendingLine);
+        _hasPendingLine = false;
+    }
+    else if (!readLine(line))
+    {
+        return false;
+    }
+
+    if (!parseLine(line, frame_out))
+    {
+        _hasError = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool TraceFileSource::parseLine(const std::string& line, ReplayFrame& frame_out) const
+{
+    size_t statesPos = 0;
+
+    try
+    {
+        frame_out.elapsed_msec = std::stoi(line, &statesPos);
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    statesPos = line.find_first_not_of(" \t", statesPos);
+    if ((statesPos == std::string::npos) || (frame_out.elapsed_msec < 0))
+    {
+        return false;
+    }
+
+    const auto wordCount = (_channelCount + 31) / 32;
+
+    frame_out.onWords.assign(wordCount, 0);
+    frame_out.validWords.assign(wordCount, 0);
+
+    for (size_t i = 0; i < _channelCount; ++i)
+    {
+        const auto pos = statesPos + i;
+        if (pos >= line.size())
+        {
+            return false;
+        }
+
+        const auto mask = static_cast<uint32_t>(1) << (i % 32);
+
+        switch (line[pos])
+        {
+            case '1':
+                frame_out.onWords[i / 32] |= mask;
+                frame_out.validWords[i / 32] |= mask;
+                break;
+
+            case '0':
+                frame_out.validWords[i / 32] |= mask;
+                break;
+
+            case 'x':
+            case 'X':
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool CaptureFileSource::open(const std::string& filename, std::string& error_out)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        error_out = "Failed to open " + filename;
+        return false;
+    }
+
+    _data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    const auto header_p = _data.data();
+    const auto headerSize = InputCapture::headerSize;
+
+    if ((_data.size() < headerSize) || (header_p[0] != 'L') || (header_p[1] != 'C') || (header_p[2] != 'A') || (header_p[3] != 'P'))
+    {
+        error_out = filename + " is not an input capture";
+        return false;
+    }
+
+    if (header_p[4] != InputCapture::formatVersion)
+    {
+        error_out = filename + " has an unsupported capture version";
+        return false;
+    }
+
+    _expanderCount = header_p[5];
+    _recordCount = readUint32(header_p + 8);
+    _lostRecordCount = readUint32(header_p + 12);
+
+    const auto channelCount = readUint16(header_p + 6);
+    const auto recordSize = InputCapture::recordHeaderSize + _expanderCount;
+
+    if ((_expanderCount > InputCapture::maxExpanderCount) ||
+        (_data.size() < headerSize + 2 * channelCount + _recordCount * recordSize))
+    {
+        error_out = filename + " is truncated";
+        return false;
+    }
+
+    _channelPins.resize(channelCount);
+
+    for (size_t i = 0; i < channelCount; ++i)
+    {
+        auto& channelPin = _channelPins[i];
+
+        channelPin.expanderIndex = header_p[headerSize + 2 * i];
+        channelPin.pin = header_p[headerSize + 2 * i + 1];
+
+        if ((channelPin.expanderIndex >= _expanderCount) || (channelPin.pin > 7))
+        {
+            error_out = filename + " has an invalid channel pin";
+            return false;
+        }
+    }
+
+    _position = headerSize + 2 * channelCount;
+    return true;
+}
+
+bool CaptureFileSource::next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out)
+{
+    (void)transitions_out;
+
+    const auto recordSize = InputCapture::recordHeaderSize + _expanderCount;
+    if (_position + recordSize > _data.size())
+    {
+        return false;
+    }
+
+    const auto record_p = _data.data() + _position;
+    const auto connectedMask = readUint16(record_p + 2);
+    const auto bytes_p = record_p + InputCapture::recordHeaderSize;
+
+    _position += recordSize;
+
+    const auto wordCount = (_channelPins.size() + 31) / 32;
+
+    frame_out.elapsed_msec = readUint16(record_p);
+    frame_out.onWords.assign(wordCount, 0);
+    frame_out.validWords.assign(wordCount, 0);
+
+    for (size_t i = 0; i < _channelPins.size(); ++i)
+    {
+        const auto& channelPin = _channelPins[i];
+        const auto mask = static_cast<uint32_t>(1) << (i % 32);
+
+        if ((connectedMask & (1u << channelPin.expanderIndex)) == 0)
+        {
+            continue;
+        }
+
+        frame_out.validWords[i / 32] |= mask;
+
+        if ((bytes_p[channelPin.expanderIndex] & (1u << channelPin.pin)) != 0)
+        {
+            frame_out.onWords[i / 32] |= mask;
+        }
+    }
+
+    return true;
+}
+
+SyntheticSource::SyntheticSource(const SyntheticParams& params, uint32_t seed) :
+    _params(params),
+    _randomState((seed != 0) ? seed : 1)
+{
+    _halfPeriod_usec = 500000 / static_cast<uint32_t>(params.mainsFrequency_hz);
+    _pulse_usec = _halfPeriod_usec * static_cast<uint32_t>(params.dutyCycle_percent) / 100;
+
+    _channels.resize(params.channelCount);
+
+    for (auto& channel : _channels)
+    {
+        channel.isPressed = false;
+        channel.nextChange_usec = static_cast<uint64_t>(params.settle_msec) * 1000 + randomHold_usec();
+        channel.bounceEnd_usec = 0;
+        channel.phase_usec = randomBelow(_halfPeriod_usec);
+
+        channel.level = false;
+        channel.readLevel = false;
+        channel.nextLevelChange_usec = UINT64_MAX;
+    }
+}
+
+uint32_t SyntheticSource::random()
+{
+    // xorshift32, cheap enough to leave the time to the controller
+    auto x = _randomState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    _randomState = x;
+    return x;
+}
+
+uint64_t SyntheticSource::randomHold_usec()
+{
+    const auto range_msec = (_params.maxHold_msec > _params.minHold_msec) ? _params.maxHold_msec - _params.minHold_msec : 0;
+    const auto hold_msec = _params.minHold_msec + randomBelow(range_msec + 1);
+
+    return static_cast<uint64_t>(hold_msec) * 1000;
+}
+
+bool SyntheticSource::sample(const Channel& channel, uint64_t time_usec)
+{
+    if (time_usec < channel.bounceEnd_usec)
+    {
+        return (random() & 1) != 0;
+    }
+
+    if (!channel.isPressed)
+    {
+        return false;
+    }
+
+    if (!_params.isAc)
+    {
+        return true;
+    }
+
+    return (time_usec + channel.phase_usec) % _halfPeriod_usec < _pulse_usec;
+}
+
+void SyntheticSource::changeSwitch(size_t channelIndex, std::vector<ReplayTransition>& transitions_out)
+{
+    auto& channel = _channels[channelIndex];
+
+    channel.isPressed = !channel.isPressed;
+    channel.bounceEnd_usec = channel.nextChange_usec + static_cast<uint64_t>(_params.bounce_msec) * 1000;
+
+    // The contacts move at once
+    channel.nextLevelChange_usec = channel.nextChange_usec;
+
+    ReplayTransition transition;
+
+    transition.channelIndex = channelIndex;
+    transition.isPressed = channel.isPressed;
+    transition.time_usec = channel.nextChange_usec;
+
+    transitions_out.push_back(transition);
+
+    channel.nextChange_usec += randomHold_usec();
+}
+
+bool SyntheticSource::getSteadyLevel(const Channel& channel, uint64_t time_usec) const
+{
+    if (!channel.isPressed)
+    {
+        return false;
+    }
+
+    if (!_params.isAc)
+    {
+        return true;
+    }
+
+    return (time_usec + channel.phase_usec) % _halfPeriod_usec < _pulse_usec;
+}
+
+uint64_t SyntheticSource::getNextLevelChange_usec(const Channel& channel, uint64_t time_usec)
+{
+    // Bounce toggles every 50..1000 usec until it ends
+    if (time_usec < channel.bounceEnd_usec)
+    {
+        const auto next_usec = time_usec + 50 + randomBelow(951);
+        return (next_usec < channel.bounceEnd_usec) ? next_usec : channel.bounceEnd_usec;
+    }
+
+    if (!channel.isPressed || !_params.isAc)
+    {
+        return UINT64_MAX;
+    }
+
+    const auto position_usec = (time_usec + channel.phase_usec) % _halfPeriod_usec;
+
+    return (position_usec < _pulse_usec) 
+        ? time_usec + (_pulse_usec - position_usec) 
+        : time_usec + (_halfPeriod_usec - position_usec);
+}
+
+void SyntheticSource::changeLevel(Channel& channel, uint64_t time_usec)
+{
+    channel.level = (time_usec < channel.bounceEnd_usec) ? !channel.level : getSteadyLevel(channel, time_usec);
+    channel.nextLevelChange_usec = getNextLevelChange_usec(channel, time_usec);
+
+    // INT is active while a port differs from its last read, a new interrupt needs it inactive first
+    if (_isReadPending)
+    {
+        return;
+    }
+
+    auto isActive = false;
+    for (const auto& item : _channels)
+    {
+        isActive |= item.level != item.readLevel;
+    }
+
+    if (isActive)
+    {
+        _isReadPending = true;
+        _interruptTime_usec = time_usec;
+        _readTime_usec = time_usec + _params.readLatency_usec;
+    }
+}
+
+void SyntheticSource::readPorts(std::vector<InputEdge>& edges_out)
+{
+    for (size_t i = 0; i < _channels.size(); ++i)
+    {
+        auto& channel = _channels[i];
+
+        if (channel.level == channel.readLevel)
+        {
+            continue;
+        }
+
+        channel.readLevel = channel.level;
+
+        InputEdge edge;
+
+        edge.channelIndex = static_cast<uint16_t>(i);
+        edge.time_usec = static_cast<uint32_t>(_interruptTime_usec);
+
+        edges_out.push_back(edge);
+    }
+
+    _isReadPending = false;
+}
+
+void SyntheticSource::advanceLines(uint64_t time_usec, std::vector<InputEdge>& edges_out, std::vector<ReplayTransition>& transitions_out)
+{
+    for (;;)
+    {
+        // The earliest of the switch changes, the level changes and the read
+        auto next_usec = _isReadPending ? _readTime_usec : UINT64_MAX;
+        size_t nextChannel = _channels.size();
+        auto isSwitchChange = false;
+
+        for (size_t i = 0; i < _channels.size(); ++i)
+        {
+            const auto& channel = _channels[i];
+
+            if (channel.nextChange_usec < next_usec)
+            {
+                next_usec = channel.nextChange_usec;
+                nextChannel = i;
+                isSwitchChange = true;
+            }
+
+            if (channel.nextLevelChange_usec < next_usec)
+            {
+                next_usec = channel.nextLevelChange_usec;
+                nextChannel = i;
+                isSwitchChange = false;
+            }
+        }
+
+        if (next_usec > time_usec)
+        {
+            return;
+        }
+
+        if (nextChannel == _channels.size())
+        {
+            // Any later change raises INT again
+            readPorts(edges_out);
+        }
+        else if (isSwitchChange)
+        {
+            changeSwitch(nextChannel, transitions_out);
+        }
+        else
+        {
+            changeLevel(_channels[nextChannel], next_usec);
+        }
+    }
+}
+
+bool SyntheticSource::next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out)
+{
+    const auto tick_usec = static_cast<uint64_t>(_params.tick_msec) * 1000;
+
+    if (_time_usec + tick_usec > static_cast<uint64_t>(_params.duration_msec) * 1000)
+    {
+        return false;
+    }
+
+    _time_usec += tick_usec;
+
+    // Uniform in [-jitter, +jitter]
+    const auto jitter_usec = static_cast<int64_t>(randomBelow(2 * _params.jitter_usec + 1)) - _params.jitter_usec;
+    const auto sample_usec = static_cast<uint64_t>(static_cast<int64_t>(_time_usec) + jitter_usec);
+
+    const auto wordCount = (_params.channelCount + 31) / 32;
+
+    frame_out.elapsed_msec = _params.tick_msec;
+    frame_out.onWords.assign(wordCount, 0);
+    frame_out.validWords.assign(wordCount, ~static_cast<uint32_t>(0));
+    frame_out.edges.clear();
+
+    if (_params.hasEdgeTimes)
+    {
+        advanceLines(sample_usec, frame_out.edges, transitions_out);
+    }
+
+    for (size_t i = 0; i < _channels.size(); ++i)
+    {
+        const auto& channel = _channels[i];
+
+        while (sample_usec >= channel.nextChange_usec)
+        {
+            changeSwitch(i, transitions_out);
+        }
+
+        if (_params.hasEdgeTimes ? channel.level : sample(channel, sample_usec))
+        {
+            frame_out.onWords[i / 32] |= static_cast<uint32_t>(1) << (i % 32);
+        }
+    }
+
+    return true;
+}
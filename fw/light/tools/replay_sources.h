@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+// Raw input samples of one tick, bit per channel as IInputDevice::readAll() returns them
+struct ReplayFrame
+{
+    int elapsed_msec = 0;
+
+    std::vector<uint32_t> onWords;
+    std::vector<uint32_t> validWords;
+
+    // Timestamped raw changes since the previous frame, as IInputDevice::takeEdges() returns them
+    std::vector<InputEdge> edges;
+};
+
+// Switch change the filters should turn into an event
+struct ReplayTransition
+{
+    size_t channelIndex;
+    bool isPressed;
+    uint64_t time_usec;
+};
+
+class IReplaySource
+{
+public:
+    virtual ~IReplaySource() = default;
+
+    virtual size_t getChannelCount() const = 0;
+
+    // Returns false at the end of the source. Switch changes of the frame are appended
+    // to transitions_out if the source knows them
+    virtual bool next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out) = 0;
+};
+
+// Recorded trace, a text line per tick:
+//     ELAPSED_MSEC STATES
+// STATES has a character per channel starting from channel 0: 1 on, 0 off, x unknown.
+// Empty lines and lines starting with # are skipped
+class TraceFileSource : public IReplaySource
+{
+public:
+    bool open(const std::string& filename, std::string& error_out);
+
+    size_t getChannelCount() const override { return _channelCount; }
+    bool next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out) override;
+
+    size_t getLineNumber() const { return _lineNumber; }
+    bool hasError() const { return _hasError; }
+
+private:
+    bool readLine(std::string& line_out);
+    bool parseLine(const std::string& line, ReplayFrame& frame_out) const;
+
+    std::ifstream _file;
+    std::string _pendingLine;
+    bool _hasPendingLine = false;
+
+    size_t _channelCount = 0;
+    size_t _lineNumber = 0;
+    bool _hasError = false;
+};
+
+// Binary capture downloaded from the controller, see InputCapture
+class CaptureFileSource : public IReplaySource
+{
+public:
+    bool open(const std::string& filename, std::string& error_out);
+
+    size_t getChannelCount() const override { return _channelPins.size(); }
+    bool next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out) override;
+
+    size_t getRecordCount() const { return _recordCount; }
+    size_t getLostRecordCount() const { return _lostRecordCount; }
+
+private:
+    struct ChannelPin
+    {
+        uint8_t expanderIndex;
+        uint8_t pin;
+    };
+
+    std::vector<uint8_t> _data;
+    size_t _position = 0;
+
+    size_t _expanderCount = 0;
+    size_t _recordCount = 0;
+    size_t _lostRecordCount = 0;
+
+    std::vector<ChannelPin> _channelPins;
+};
+
+struct SyntheticParams
+{
+    size_t channelCount = 16;
+    uint32_t duration_msec = 60000;
+    int tick_msec = 5;
+
+    // AC: the optocoupler output is a pulse train at twice the mains frequency.
+    // DC: the output follows the switch
+    bool isAc = true;
+    int mainsFrequency_hz = 50;
+    int dutyCycle_percent = 50;
+
+    // Sampling time error of every tick
+    uint32_t jitter_usec = 200;
+
+    // Random samples after every switch change
+    uint32_t bounce_msec = 5;
+
+    // Random time between switch changes
+    uint32_t minHold_msec = 150;
+    uint32_t maxHold_msec = 2000;
+
+    // Switches stay released at first, so the filters settle
+    uint32_t settle_msec = 500;
+
+    // Timestamped edges from the INT line shared by the expanders: a change raises it, the
+    // bus task reads all the ports readLatency_usec later and the changes the read sees get
+    // the time of the interrupt. Then the optocoupler output changes at exact times and
+    // bounces as random toggles
+    bool hasEdgeTimes = false;
+    uint32_t readLatency_usec = 300;
+};
+
+// Switches pressed and released at random times. The same seed gives the same frames
+class SyntheticSource : public IReplaySource
+{
+public:
+    SyntheticSource(const SyntheticParams& params, uint32_t seed);
+
+    size_t getChannelCount() const override { return _params.channelCount; }
+    bool next(ReplayFrame& frame_out, std::vector<ReplayTransition>& transitions_out) override;
+
+private:
+    struct Channel
+    {
+        bool isPressed;
+        uint64_t nextChange_usec;
+        uint64_t bounceEnd_usec;
+        uint32_t phase_usec;    // Of the mains, channels are on different phases
+
+        // Optocoupler output with edge times, its level as of the last port read
+        bool level;
+        bool readLevel;
+        uint64_t nextLevelChange_usec;
+    };
+
+    uint32_t random();
+    uint32_t randomBelow(uint32_t limit) { return (limit == 0) ? 0 : random() % limit; }
+    uint64_t randomHold_usec();
+
+    void changeSwitch(size_t channelIndex, std::vector<ReplayTransition>& transitions_out);
+
+    bool sample(const Channel& channel, uint64_t time_usec);
+
+    bool getSteadyLevel(const Channel& channel, uint64_t time_usec) const;
+    uint64_t getNextLevelChange_usec(const Channel& channel, uint64_t time_usec);
+    void advanceLines(uint64_t time_usec, std::vector<InputEdge>& edges_out, std::vector<ReplayTransition>& transitions_out);
+    void changeLevel(Channel& channel, uint64_t time_usec);
+    void readPorts(std::vector<InputEdge>& edges_out);
+
+    SyntheticParams _params;
+    uint32_t _randomState;
+
+    uint32_t _halfPeriod_usec;
+    uint32_t _pulse_usec;
+
+    uint64_t _time_usec = 0;
+    std::vector<Channel> _channels;
+
+    // Shared INT line: time of its first interrupt since the last port read
+    bool _isReadPending = false;
+    uint64_t _interruptTime_usec = 0;
+    uint64_t _readTime_usec = 0;
+};
@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstdio>
+
+#include "replay_stats.h"
+
+void ReplayStats::setChannelCount(size_t value)
+{
+    _channels.assign(value, Channel());
+}
+
+void ReplayStats::addTransition(const ReplayTransition& transition)
+{
+    if (transition.channelIndex >= _channels.size())
+    {
+        return;
+    }
+
+    auto& channel = _channels[transition.channelIndex];
+
+    if (channel.isWaiting)
+    {
+        ++_missedCount;
+    }
+
+    channel.isWaiting = true;
+    channel.expected = transition.isPressed ? EventType::rise : EventType::fall;
+    channel.transition_usec = transition.time_usec;
+
+    ++_transitionCount;
+}
+
+void ReplayStats::addEvent(size_t channelIndex, EventType event, uint64_t time_usec)
+{
+    if (channelIndex >= _channels.size())
+    {
+        return;
+    }
+
+    auto& channel = _channels[channelIndex];
+
+    ++_eventCount;
+
+    if (channel.hasEvent)
+    {
+        const auto interval_usec = time_usec - channel.lastEvent_usec;
+
+        if (!_hasEventInterval || (interval_usec < _shortestEventInterval_usec))
+        {
+            _shortestEventInterval_usec = interval_usec;
+            _hasEventInterval = true;
+        }
+    }
+
+    channel.hasEvent = true;
+    channel.lastEvent_usec = time_usec;
+
+    if (!channel.isWaiting || (event != channel.expected))
+    {
+        ++_spuriousCount;
+        return;
+    }
+
+    channel.isWaiting = false;
+
+    _latencies_usec.push_back(static_cast<int64_t>(time_usec - channel.transition_usec));
+    _isSorted = false;
+}
+
+void ReplayStats::finish()
+{
+    for (auto& channel : _channels)
+    {
+        if (channel.isWaiting)
+        {
+            ++_missedCount;
+        }
+
+        channel = Channel();
+    }
+}
+
+void ReplayStats::merge(const ReplayStats& other)
+{
+    _transitionCount += other._transitionCount;
+    _eventCount += other._eventCount;
+    _missedCount += other._missedCount;
+    _spuriousCount += other._spuriousCount;
+
+    if (other._hasEventInterval && (!_hasEventInterval || (other._shortestEventInterval_usec < _shortestEventInterval_usec)))
+    {
+        _shortestEventInterval_usec = other._shortestEventInterval_usec;
+        _hasEventInterval = true;
+    }
+
+    _latencies_usec.insert(_latencies_usec.end(), other._latencies_usec.begin(), other._latencies_usec.end());
+    _isSorted = false;
+}
+
+bool ReplayStats::getShortestEventInterval_usec(uint64_t& value_out) const
+{
+    value_out = _shortestEventInterval_usec;
+    return _hasEventInterval;
+}
+
+bool ReplayStats::getLatency_usec(double percentile, int64_t& value_out) const
+{
+    if (_latencies_usec.empty())
+    {
+        return false;
+    }
+
+    if (!_isSorted)
+    {
+        std::sort(_latencies_usec.begin(), _latencies_usec.end());
+        _isSorted = true;
+    }
+
+    const auto lastIndex = _latencies_usec.size() - 1;
+    auto index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(lastIndex) + 0.5);
+
+    value_out = _latencies_usec[std::min(index, lastIndex)];
+    return true;
+}
+
+bool ReplayStats::getAverageLatency_usec(double& value_out) const
+{
+    if (_latencies_usec.empty())
+    {
+        return false;
+    }
+
+    double sum = 0;
+    for (const auto value : _latencies_usec)
+    {
+        sum += static_cast<double>(value);
+    }
+
+    value_out = sum / static_cast<double>(_latencies_usec.size());
+    return true;
+}
+
+std::string ReplayStats::toString() const
+{
+    char text[256];
+
+    std::snprintf(text, sizeof(text), "changes %zu, events %zu, missed %zu, spurious %zu",
+        _transitionCount, _eventCount, _missedCount, _spuriousCount);
+
+    std::string result = text;
+
+    double average_usec;
+    int64_t p50_usec, p99_usec, min_usec, max_usec;
+
+    if (getAverageLatency_usec(average_usec) && getLatency_usec(0, min_usec) && getLatency_usec(50, p50_usec) &&
+        getLatency_usec(99, p99_usec) && getLatency_usec(100, max_usec))
+    {
+        std::snprintf(text, sizeof(text), ", latency msec min %.1f avg %.1f p50 %.1f p99 %.1f max %.1f",
+            min_usec / 1000.0, average_usec / 1000.0, p50_usec / 1000.0, p99_usec / 1000.0, max_usec / 1000.0);
+
+        result += text;
+    }
+
+    uint64_t interval_usec;
+    if (getShortestEventInterval_usec(interval_usec))
+    {
+        std::snprintf(text, sizeof(text), ", shortest event interval %.1f msec", interval_usec / 1000.0);
+        result += text;
+    }
+
+    return result;
+}
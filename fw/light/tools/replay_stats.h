@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+#include "replay_sources.h"
+
+// Matches the events of the controller with the switch changes of the source. Every
+// change expects one event of its direction before the next change of the channel:
+// a change left without one is missed, any other event is spurious (a light that
+// toggled twice).
+class ReplayStats
+{
+public:
+    void setChannelCount(size_t value);
+
+    void addTransition(const ReplayTransition& transition);
+    void addEvent(size_t channelIndex, EventType event, uint64_t time_usec);
+
+    // Changes still waiting for their event at the end of a source count as missed
+    void finish();
+
+    void merge(const ReplayStats& other);
+
+    size_t getTransitionCount() const { return _transitionCount; }
+    size_t getEventCount() const { return _eventCount; }
+    size_t getMissedCount() const { return _missedCount; }
+    size_t getSpuriousCount() const { return _spuriousCount; }
+
+    // Shortest time between two events of the same channel, the source of double toggles
+    bool getShortestEventInterval_usec(uint64_t& value_out) const;
+
+    // Latency from a switch change to its event, percentile 0..100
+    bool getLatency_usec(double percentile, int64_t& value_out) const;
+    bool getAverageLatency_usec(double& value_out) const;
+
+    std::string toString() const;
+
+private:
+    struct Channel
+    {
+        bool isWaiting = false;
+        EventType expected = EventType::none;
+        uint64_t transition_usec = 0;
+
+        bool hasEvent = false;
+        uint64_t lastEvent_usec = 0;
+    };
+
+    std::vector<Channel> _channels;
+
+    size_t _transitionCount = 0;
+    size_t _eventCount = 0;
+    size_t _missedCount = 0;
+    size_t _spuriousCount = 0;
+
+    bool _hasEventInterval = false;
+    uint64_t _shortestEventInterval_usec = 0;
+
+    mutable std::vector<int64_t> _latencies_usec;
+    mutable bool _isSorted = true;
+};